@@ -1,94 +1,398 @@
 #include <iostream>
 #include <fstream>
 #include <string>
-#include <thread>
+#include <vector>
+#include <memory>
 #include <chrono>
+#include <cerrno>
+#include <cstdlib>
 
-#include "antlr4-runtime.h"
-#include "LuaLexer.h"
-#include "LuaParser.h"
-
-#include "frontend/Listing.h"
-#include "frontend/SyntaxErrorHandler.h"
-#include "frontend/Semantics.h"
-#include "intermediate/symtab/Predefined.h"
-#include "intermediate/type/Typespec.h"
-#include "backend/compiler/Compiler.h"
+#include "driver/Driver.h"
+#include "driver/CompileServer.h"
+#include "intermediate/util/WorkStealingPool.h"
+#include "intermediate/util/Tracer.h"
 
 using namespace std;
-using namespace antlrcpp;
-using namespace antlr4;
 
-using namespace frontend;
-using namespace intermediate::type;
-using namespace intermediate::symtab;
+using namespace driver;
+using namespace intermediate::util;
 using namespace backend::compiler;
 
+/**
+ * Append the source file names listed in a manifest, one per line.
+ * @param manifest the manifest file name.
+ * @param sourceFiles the vector to append to.
+ * @return true if the manifest was read, else false.
+ */
+static bool readManifest(const string& manifest, vector<string>& sourceFiles)
+{
+    ifstream ins(manifest);
+    if (ins.fail()) return false;
+
+    string line;
+    while (getline(ins, line))
+    {
+        if (!line.empty() && (line.back() == '\r')) line.pop_back();
+        if (!line.empty() && (line[0] != '#')) sourceFiles.push_back(line);
+    }
+
+    return true;
+}
+
+/**
+ * Parse a count, such as a size in bytes, from an option value.
+ * @param text the option value.
+ * @param count set to the count.
+ * @return true if the value is a decimal count that fits, else false.
+ */
+static bool parseCount(const string& text, size_t& count)
+{
+    if (text.empty() || (text.find_first_not_of("0123456789") != string::npos))
+    {
+        return false;
+    }
+
+    errno = 0;
+    unsigned long long value = strtoull(text.c_str(), nullptr, 10);
+    count = (size_t) value;
+
+    return (errno != ERANGE) && (count == value);
+}
+
+/**
+ * Write the recorded trace, if tracing is on.
+ * @param traceFile the trace file name, or empty if tracing is off.
+ */
+static void writeTrace(const string& traceFile)
+{
+    if (traceFile.empty()) return;
+
+    if (!Tracer::write(traceFile))
+    {
+        cout << "ERROR: Failed to write trace \"" << traceFile << "\"." << endl;
+    }
+}
+
 int main(int argc, const char *args[])
 {
-    if (argc < 1)
+    auto startTime = chrono::steady_clock::now();
+    DriverOptions options;
+    vector<string> sourceFiles;
+    int jobs = 1;
+    bool useCache = false;
+    string cacheDirectory = CompileCache::defaultDirectory();
+    size_t cacheMaxSize = 0;     // 0 for no eviction
+    bool cacheStats = false;
+    bool serve = false;
+    bool timePasses = false;
+    string timePassesJson;       // JSON report file, or - for stdout
+    string traceFile;            // trace-event file, or empty
+    string socketPath = CompileServer::defaultSocketPath();
+
+    // Command-line options and the source file names.
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = args[i];
+
+        if      (arg == "--sync-output")    options.compiler.syncOutput = true;
+        else if (arg == "--no-peephole")    options.compiler.peephole = false;
+        else if (arg == "--no-fold")        options.fold = false;
+        else if (arg == "--peephole-stats") options.peepholeStats = true;
+        else if (arg == "--quiet")          options.quiet = true;
+        else if (arg == "--emit=jasmin")    options.compiler.emit = EmitFormat::JASMIN;
+        else if (arg == "--emit=class")     options.compiler.emit = EmitFormat::CLASS;
+        else if (arg.rfind("--runtime-timing=", 0) == 0)
+        {
+            string timing = arg.substr(17);
+
+            if      (timing == "off") options.compiler.timing = RuntimeTiming::OFF;
+            else if (timing == "ms")  options.compiler.timing = RuntimeTiming::MS;
+            else if (timing == "ns")  options.compiler.timing = RuntimeTiming::NS;
+            else
+            {
+                cout << "ERROR: Invalid runtime timing \"" << timing
+                     << "\", expected off, ms or ns." << endl;
+                return -1;
+            }
+        }
+        else if (   ((arg == "-j") && (i + 1 < argc))
+                 || ((arg.rfind("-j", 0) == 0) && (arg.size() > 2)))
+        {
+            string count = arg == "-j" ? args[++i] : arg.substr(2);
+            size_t value;
+
+            if (!parseCount(count, value) || (value < 1) || (value > 1024))
+            {
+                cout << "ERROR: Invalid job count \"" << count
+                     << "\", expected 1 to 1024." << endl;
+                return -1;
+            }
+            jobs = (int) value;
+        }
+        else if (arg.rfind("--output-buffer=", 0) == 0)
+        {
+            string size = arg.substr(16);
+
+            if (!parseCount(size, options.compiler.outputBufferSize))
+            {
+                cout << "ERROR: Invalid output buffer size \"" << size
+                     << "\", expected a count of bytes." << endl;
+                return -1;
+            }
+        }
+        else if (arg == "--time-passes")    timePasses = true;
+        else if (arg.rfind("--time-passes-json=", 0) == 0)
+        {
+            timePassesJson = arg.substr(19);
+        }
+        else if (arg.rfind("--trace=", 0) == 0) traceFile = arg.substr(8);
+        else if (arg == "--serve")          serve = true;
+        else if (arg.rfind("--serve=", 0) == 0)
+        {
+            serve = true;
+            socketPath = arg.substr(8);
+        }
+        else if (arg == "--cache")          useCache = true;
+        else if (arg == "--cache-stats")    cacheStats = true;
+        else if (arg.rfind("--cache-dir=", 0) == 0)
+        {
+            useCache = true;
+            cacheDirectory = arg.substr(12);
+        }
+        else if (arg.rfind("--cache-max-size=", 0) == 0)
+        {
+            string size = arg.substr(17);
+
+            if (!parseCount(size, cacheMaxSize))
+            {
+                cout << "ERROR: Invalid cache size \"" << size
+                     << "\", expected a count of bytes." << endl;
+                return -1;
+            }
+        }
+        else if (arg.rfind("--manifest=", 0) == 0)
+        {
+            string manifest = arg.substr(11);
+            if (!readManifest(manifest, sourceFiles))
+            {
+                cout << "ERROR: Failed to open manifest \""
+                     << manifest << "\"." << endl;
+                return -1;
+            }
+        }
+        else sourceFiles.push_back(arg);
+    }
+
+    if (!traceFile.empty()) Tracer::start();
+    options.timePasses = timePasses || !timePassesJson.empty();
+
+    // Compile on request until shut down, with warm lexer and parser.
+    if (serve)
+    {
+        unique_ptr<CompileCache> cache;
+        if (useCache) cache.reset(new CompileCache(cacheDirectory));
+
+        CompileServer server(socketPath, options, cache.get(), jobs);
+        int status = server.run();
+        writeTrace(traceFile);
+
+        if (cache != nullptr)
+        {
+            cache->saveStatistics();
+            if (cacheMaxSize > 0) cache->evict(cacheMaxSize);
+            if (cacheStats) cache->printStatistics(cout);
+        }
+        return status;
+    }
+
+    // Without source files, only report on or trim the cache.
+    if (sourceFiles.empty() && (cacheStats || (cacheMaxSize > 0)))
     {
-        cout << "USAGE: Lua sourceFileName" << endl;
+        CompileCache cache(cacheDirectory);
+        if (cacheMaxSize > 0)
+        {
+            printf("%d cache entries evicted.\n", cache.evict(cacheMaxSize));
+        }
+        if (cacheStats) cache.printStatistics(cout);
+        return 0;
+    }
+
+    if (sourceFiles.empty())
+    {
+        cout << "USAGE: Lua [--sync-output] [--output-buffer=bytes] "
+             << "[--no-peephole] [--peephole-stats] [--no-fold] "
+             << "[--emit=class|jasmin] [--runtime-timing=off|ms|ns] "
+             << "[--quiet] [--manifest=file] [-j N] "
+             << "[--cache] [--cache-dir=dir] [--cache-max-size=bytes] "
+             << "[--cache-stats] [--time-passes] [--time-passes-json=file] "
+             << "[--trace=file.json] "
+             << "sourceFileName ..." << endl;
+        cout << "       Lua --serve[=socket] [-j N] [options]" << endl;
         return -1;
     }
 
-    string sourceFile = args[1];
-    string sourceFileName = sourceFile.substr(0, sourceFile.size()-4);
-
-    cout << "PASS 1: \n";
-    // Generate a source file listing.
-    Listing listing(sourceFile);
-
-    ifstream ins;
-    ins.open(args[1]);
-
-    // Create the input stream.
-    ANTLRInputStream input(ins);
-    // Custom syntax error handler.
-    SyntaxErrorHandler syntaxErrorHandler;
-
-    // Create a lexer which scans the character stream
-    // to create a token stream.
-    LuaLexer lexer(&input);
-    lexer.removeErrorListeners();
-    lexer.addErrorListener(&syntaxErrorHandler);
-    CommonTokenStream tokens(&lexer);
-
-    // Create a parser which parses the token stream.
-    LuaParser parser(&tokens);
-
-    // Pass 1: Check syntax and create the parse tree.
-    tree::ParseTree *tree = parser.chunk();
-
-    // Allow any syntax error messages to print.
-	this_thread::sleep_for(chrono::milliseconds(100));
-	int syntaxErrors = syntaxErrorHandler.getCount();
-	if (syntaxErrors > 0)
-	{
-		printf("\nThere were %d syntax errors.\n", syntaxErrors);
-		cout << "Object file not created or modified." << endl;
-		return syntaxErrors;
-	}
-
-    // Pass 2: Create symbol tables and set parse tree node datatypes.
-	cout << "\nPASS 2:";
-	Semantics *pass2 = new Semantics(sourceFileName);
-	pass2->visit(tree);
-
-	int semanticErrors = pass2->getErrorCount();
-	if (semanticErrors > 0)
-	{
-		cout << endl << "There were " << semanticErrors << " semantic errors." << " Object file not created or modified." << endl;
-		return semanticErrors;
-	}
-
-	// Pass 3: Compile the Lua program.
-	cout << "\nPASS 3: \n";
-	SymtabEntry *programId = pass2->getProgramId();
-	Compiler *pass3 = new Compiler(programId);
-	pass3->visit(tree);
-
-	cout << "Object file \"" << pass3->getObjectFileName() << "\" created." << endl;
-
-    return 0;
+    if (jobs < 1) jobs = 1;
+
+    // A single file spreads its routines over the workers instead,
+    // so its pass times must count every thread.
+    if (sourceFiles.size() == 1)
+    {
+        options.compiler.routineJobs = jobs;
+        jobs = 1;
+        if (options.timePasses) PassTimer::measureProcess(true);
+    }
+    if (jobs > (int) sourceFiles.size()) jobs = sourceFiles.size();
+
+    // Concurrent listings would interleave.
+    if (jobs > 1) options.quiet = true;
+
+    // The cache is shared by every driver and, through the
+    // file system, by other compiler processes.
+    unique_ptr<CompileCache> cache;
+    if (useCache || cacheStats || (cacheMaxSize > 0))
+    {
+        cache.reset(new CompileCache(cacheDirectory));
+    }
+    CompileCache *driverCache = useCache ? cache.get() : nullptr;
+
+    vector<CompileResult> results(sourceFiles.size());
+
+    if (jobs == 1)
+    {
+        // Compile each file with the same driver, so that the lexer
+        // and parser are built only once.
+        Driver compiler(options, driverCache);
+
+        for (size_t i = 0; i < sourceFiles.size(); i++)
+        {
+            results[i] = compiler.compile(sourceFiles[i]);
+        }
+    }
+    else
+    {
+        // Each worker has its own driver. The compilations share
+        // no mutable state, so the files compile independently.
+        vector<unique_ptr<Driver>> compilers;
+        for (int i = 0; i < jobs; i++)
+        {
+            compilers.emplace_back(new Driver(options, driverCache));
+        }
+
+        WorkStealingPool pool(jobs);
+        for (size_t i = 0; i < sourceFiles.size(); i++)
+        {
+            pool.submit([&, i] (int worker)
+            {
+                results[i] = compilers[worker]->compile(sourceFiles[i]);
+            });
+        }
+        pool.wait();
+    }
+
+    int failed = 0;
+    int cached = 0;
+    int syntaxErrors = 0;
+    int semanticErrors = 0;
+    int stackErrors = 0;
+    long sourceLines = 0;
+    size_t objectBytes = 0;
+
+    for (const CompileResult& result : results)
+    {
+        if (!result.succeeded()) failed++;
+        if (result.cached) cached++;
+        syntaxErrors   += result.syntaxErrors;
+        semanticErrors += result.semanticErrors;
+        stackErrors    += result.stackErrors;
+        sourceLines    += result.sourceLines;
+        objectBytes    += result.objectBytes;
+    }
+
+    double totalSeconds = chrono::duration<double>(
+                              chrono::steady_clock::now() - startTime).count();
+
+    // Per-file phase measurements, after all the compiler output.
+    if (timePasses)
+    {
+        for (const CompileResult& result : results)
+        {
+            if (result.passes.getTimings().empty()) continue;
+            cout << result.passes.toText(result.sourceFile);
+        }
+    }
+
+    if (!timePassesJson.empty())
+    {
+        string json = "{\"version\": "
+                    + Tracer::jsonString(CompileCache::VERSION)
+                    + ", \"files\": [\n";
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            json += "  " + results[i].passes.toJson(results[i].sourceFile);
+            json += i + 1 < results.size() ? ",\n" : "\n";
+        }
+        json += "]}\n";
+
+        if (timePassesJson == "-") cout << json;
+        else
+        {
+            ofstream outs(timePassesJson);
+            outs << json;
+            if (outs.fail())
+            {
+                cout << "ERROR: Failed to write \"" << timePassesJson
+                     << "\"." << endl;
+            }
+        }
+    }
+
+    writeTrace(traceFile);
+
+    // Batch summary.
+    if (sourceFiles.size() > 1)
+    {
+        int files = sourceFiles.size();
+        printf("\n===== BATCH SUMMARY =====\n\n");
+        printf("%8d files compiled, %d failed\n", files - failed, failed);
+        if (driverCache != nullptr)
+        {
+            printf("%8d restored from the cache\n", cached);
+        }
+        printf("%8d syntax errors\n", syntaxErrors);
+        printf("%8d semantic errors\n", semanticErrors);
+        printf("%8d stack errors\n", stackErrors);
+        printf("%8ld source lines\n", sourceLines);
+        printf("%8zu object bytes\n", objectBytes);
+        printf("%8d worker threads\n", jobs);
+        printf("%8.3f seconds total (%.0f files/sec, %.0f lines/sec)\n",
+               totalSeconds,
+               totalSeconds > 0 ? files/totalSeconds : 0.0,
+               totalSeconds > 0 ? sourceLines/totalSeconds : 0.0);
+    }
+    else
+    {
+        printf("Total compile time %.3f ms.\n", totalSeconds*1000);
+    }
+
+    if (cache != nullptr)
+    {
+        cache->saveStatistics();
+        if (cacheMaxSize > 0)
+        {
+            int removed = cache->evict(cacheMaxSize);
+            if (cacheStats) printf("%d cache entries evicted.\n", removed);
+        }
+        if (cacheStats) cache->printStatistics(cout);
+    }
+
+    // A single file's exit status is its error count, as before.
+    if (sourceFiles.size() == 1)
+    {
+        if (syntaxErrors > 0)   return syntaxErrors;
+        if (semanticErrors > 0) return semanticErrors;
+        if (stackErrors > 0)    return stackErrors;
+        return failed > 0 ? -1 : 0;
+    }
+
+    return failed;
 }
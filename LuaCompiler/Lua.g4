@@ -5,6 +5,7 @@ grammar Lua;
     #include <map>
     #include "intermediate/symtab/Symtab.h"
     #include "intermediate/type/Typespec.h"
+    #include "intermediate/ast/ExpNode.h"
     using namespace intermediate::symtab;
     using namespace intermediate::type;
 }
@@ -32,7 +33,7 @@ printStat
 printArguments 
 	: '(' exp (',' exp)* ')' ;
 	
-retstat
+retstat	locals [SymtabEntry *entry = nullptr]
     : 'return' exp? ';'?
     ;
 
@@ -57,7 +58,7 @@ explist
     : exp (',' exp)*
     ;
 
-exp
+exp	locals [bool folded = false, int value = 0, LuaParser::ExpContext *reduced = nullptr, LuaParser::ExpContext *doubled = nullptr, intermediate::ast::ExpNode *node = nullptr, Typespec *type = nullptr]
     : 'nil' | 'false' | 'true'
     | number
     | string
@@ -72,7 +73,7 @@ prefixexp
     : varOrExp nameAndArgs*
     ;
 
-functiondef
+functiondef	locals [SymtabEntry *entry = nullptr]
     : 'function' funcname funcbody
     ;
     
@@ -88,7 +89,7 @@ parlist
     : varlist (',' '...')? | '...'
     ;
     
-functioncall
+functioncall	locals [SymtabEntry *entry = nullptr]
     : varOrExp nameAndArgs+
     ;
 
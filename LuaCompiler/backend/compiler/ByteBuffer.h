@@ -0,0 +1,95 @@
+/**
+ * <h1>ByteBuffer</h1>
+ *
+ * <p>Growable buffer of big-endian class file data.</p>
+ */
+#ifndef BYTEBUFFER_H_
+#define BYTEBUFFER_H_
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace backend { namespace compiler {
+
+using namespace std;
+
+class ByteBuffer
+{
+private:
+    vector<uint8_t> bytes;  // the buffered data
+
+public:
+    /**
+     * Getter.
+     * @return the count of buffered bytes.
+     */
+    size_t size() const { return bytes.size(); }
+
+    /**
+     * Getter.
+     * @return the buffered bytes.
+     */
+    const uint8_t *data() const { return bytes.data(); }
+
+    /**
+     * Append a 1-byte value.
+     * @param value the value.
+     */
+    void putU1(int value) { bytes.push_back(value & 0xFF); }
+
+    /**
+     * Append a 2-byte value.
+     * @param value the value.
+     */
+    void putU2(int value)
+    {
+        putU1(value >> 8);
+        putU1(value);
+    }
+
+    /**
+     * Append a 4-byte value.
+     * @param value the value.
+     */
+    void putU4(uint32_t value)
+    {
+        putU2(value >> 16);
+        putU2(value);
+    }
+
+    /**
+     * Append the contents of another buffer.
+     * @param other the other buffer.
+     */
+    void putBytes(const ByteBuffer& other)
+    {
+        bytes.insert(bytes.end(), other.bytes.begin(), other.bytes.end());
+    }
+
+    /**
+     * Overwrite a 2-byte value.
+     * @param position the position of the value.
+     * @param value the new value.
+     */
+    void setU2(size_t position, int value)
+    {
+        bytes[position]     = (value >> 8) & 0xFF;
+        bytes[position + 1] = value & 0xFF;
+    }
+
+    /**
+     * Overwrite a 4-byte value.
+     * @param position the position of the value.
+     * @param value the new value.
+     */
+    void setU4(size_t position, uint32_t value)
+    {
+        setU2(position,     value >> 16);
+        setU2(position + 2, value & 0xFFFF);
+    }
+};
+
+}}  // namespace backend::compiler
+
+#endif /* BYTEBUFFER_H_ */
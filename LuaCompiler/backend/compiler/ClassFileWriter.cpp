@@ -0,0 +1,728 @@
+/**
+ * <h1>ClassFileWriter</h1>
+ *
+ * <p>Assemble method code records directly into a JVM class file,
+ * without going through Jasmin.</p>
+ */
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+
+#include "ClassFileWriter.h"
+
+namespace backend { namespace compiler {
+
+using namespace std;
+
+// Version 50 (Java 6) is the first to check StackMapTable frames.
+// Its verifier falls back to type inference if a frame is rejected.
+static const uint32_t MAGIC         = 0xCAFEBABE;
+static const int      MINOR_VERSION = 0;
+static const int      MAJOR_VERSION = 50;
+
+// The full_frame type of a StackMapTable entry.
+static const int FULL_FRAME = 255;
+
+// Access flags.
+static const int ACC_PUBLIC  = 0x0001;
+static const int ACC_PRIVATE = 0x0002;
+static const int ACC_STATIC  = 0x0008;
+static const int ACC_SUPER   = 0x0020;
+
+// Operation codes that have no Instruction of their own.
+static const int OP_LDC_W = 0x13;
+static const int OP_WIDE  = 0xC4;
+
+ClassFileWriter::ClassFileWriter(ObjectFile *objectFile)
+    : objectFile(objectFile), classAccess(0), thisClass(0), superClass(0),
+      fieldCount(0), methodCount(0), methodAccess(0),
+      maxLocals(0), maxStack(0)
+{
+}
+
+void ClassFileWriter::write(const MethodCode& code)
+{
+    for (const CodeRecord& record : code.getRecords())
+    {
+        switch (record.kind)
+        {
+            case RecordKind::DIRECTIVE:
+                writeDirective(code, record);
+                break;
+
+            case RecordKind::INSTRUCTION:
+            case RecordKind::LABEL:
+            case RecordKind::SWITCH_LABEL:
+            case RecordKind::CASE:
+            case RecordKind::DEFAULT_CASE:
+                body.push_back(&record);
+                break;
+
+            // Comments and blank lines only appear in Jasmin text.
+            default: break;
+        }
+    }
+}
+
+void ClassFileWriter::close()
+{
+    ByteBuffer file;
+
+    file.putU4(MAGIC);
+    file.putU2(MINOR_VERSION);
+    file.putU2(MAJOR_VERSION);
+
+    file.putU2(pool.getCount());
+    pool.write(file);
+
+    file.putU2(classAccess);
+    file.putU2(thisClass);
+    file.putU2(superClass);
+    file.putU2(0);  // interfaces
+
+    file.putU2(fieldCount);
+    file.putBytes(fields);
+
+    file.putU2(methodCount);
+    file.putBytes(methods);
+
+    file.putU2(0);  // class attributes
+
+    objectFile->write(reinterpret_cast<const char *>(file.data()),
+                      file.size());
+}
+
+void ClassFileWriter::writeDirective(const MethodCode& code,
+                                     const CodeRecord& record)
+{
+    switch (record.directive)
+    {
+        case Directive::CLASS_PUBLIC:
+            classAccess = accessFlags(record.directive) | ACC_SUPER;
+            className = code.getText(record.operands[0]);
+            thisClass = pool.classRef(className);
+            break;
+
+        case Directive::SUPER:
+            superClass = pool.classRef(code.getText(record.operands[0]));
+            break;
+
+        case Directive::FIELD:
+        case Directive::FIELD_PRIVATE_STATIC:
+            fields.putU2(accessFlags(record.directive));
+            fields.putU2(pool.utf8(code.getText(record.operands[0])));
+            fields.putU2(pool.utf8(code.getText(record.operands[1])));
+            fields.putU2(0);  // field attributes
+            fieldCount++;
+            break;
+
+        case Directive::METHOD_PUBLIC:
+        case Directive::METHOD_STATIC:
+        case Directive::METHOD_PUBLIC_STATIC:
+        case Directive::METHOD_PRIVATE_STATIC:
+        {
+            string header = code.getText(record.operands[0]);
+            size_t paren = header.find('(');
+
+            methodAccess     = accessFlags(record.directive);
+            methodName       = header.substr(0, paren);
+            methodDescriptor = header.substr(paren);
+            maxLocals = maxStack = 0;
+            body.clear();
+            break;
+        }
+
+        case Directive::LIMIT_LOCALS:
+            maxLocals = record.operands[0];
+            break;
+
+        case Directive::LIMIT_STACK:
+            maxStack = record.operands[0];
+            break;
+
+        case Directive::END_METHOD:
+            writeMethod(code);
+            break;
+
+        // .var and .line are debugging information.
+        default: break;
+    }
+}
+
+void ClassFileWriter::writeMethod(const MethodCode& code)
+{
+    int codeLength = locateLabels(code);
+
+    ByteBuffer bytecode;
+    for (size_t i = 0; i < body.size(); i++)
+    {
+        encode(code, i, offsets[i], &bytecode);
+    }
+
+    ByteBuffer stackMapTable;
+    bool hasFrames = writeStackMapTable(code, stackMapTable);
+
+    methods.putU2(methodAccess);
+    methods.putU2(pool.utf8(methodName));
+    methods.putU2(pool.utf8(methodDescriptor));
+    methods.putU2(1);  // method attributes
+
+    // The Code attribute.
+    methods.putU2(pool.utf8("Code"));
+    methods.putU4(12 + codeLength + stackMapTable.size());
+    methods.putU2(maxStack);
+    methods.putU2(maxLocals);
+    methods.putU4(codeLength);
+    methods.putBytes(bytecode);
+    methods.putU2(0);  // exception table
+    methods.putU2(hasFrames ? 1 : 0);
+    methods.putBytes(stackMapTable);
+
+    methodCount++;
+    body.clear();
+    offsets.clear();
+    labelOffsets.clear();
+}
+
+bool ClassFileWriter::writeStackMapTable(const MethodCode& code,
+                                         ByteBuffer& out)
+{
+    FrameAnalyzer analyzer(code, body, offsets, className);
+    map<int, Frame> frames =
+        analyzer.analyze(methodName, methodDescriptor,
+                         (methodAccess & ACC_STATIC) != 0, maxLocals);
+
+    if (frames.empty()) return false;
+
+    ByteBuffer entries;
+    int previous = -1;
+
+    for (auto& entry : frames)
+    {
+        int offset = entry.first;
+        const Frame& frame = entry.second;
+
+        // Trailing unused locals need not be listed.
+        size_t localCount = frame.locals.size();
+        while (   (localCount > 0)
+               && (frame.locals[localCount - 1].tag == VerificationType::TOP))
+        {
+            localCount--;
+        }
+
+        // A long or double is listed once for its two slots.
+        ByteBuffer locals;
+        int listed = 0;
+        for (size_t i = 0; i < localCount; i++)
+        {
+            writeVerificationType(frame.locals[i], locals);
+            listed++;
+            if (frame.locals[i].isWide()) i++;
+        }
+
+        entries.putU1(FULL_FRAME);
+        entries.putU2(offset - previous - 1);
+        entries.putU2(listed);
+        entries.putBytes(locals);
+        entries.putU2(frame.stack.size());
+        for (const VerificationType& type : frame.stack)
+        {
+            writeVerificationType(type, entries);
+        }
+
+        previous = offset;
+    }
+
+    out.putU2(pool.utf8("StackMapTable"));
+    out.putU4(2 + entries.size());
+    out.putU2(frames.size());
+    out.putBytes(entries);
+
+    return true;
+}
+
+void ClassFileWriter::writeVerificationType(const VerificationType& type,
+                                            ByteBuffer& out)
+{
+    out.putU1(type.tag);
+
+    if (type.tag == VerificationType::OBJECT)
+    {
+        out.putU2(pool.classRef(type.className));
+    }
+    else if (type.tag == VerificationType::UNINITIALIZED)
+    {
+        out.putU2(type.offset);
+    }
+}
+
+int ClassFileWriter::locateLabels(const MethodCode& code)
+{
+    int offset = 0;
+    offsets.assign(body.size(), 0);
+
+    for (size_t i = 0; i < body.size(); i++)
+    {
+        const CodeRecord& record = *body[i];
+        offsets[i] = offset;
+
+        if (record.kind == RecordKind::LABEL)
+        {
+            if (labelOffsets.find(record.label) != labelOffsets.end())
+            {
+                cout << "ERROR: Label " << record.label
+                     << " is defined more than once in method "
+                     << methodName << "." << endl;
+                exit(-1);
+            }
+
+            labelOffsets[record.label] = offset;
+        }
+        else offset += encode(code, i, offset, nullptr);
+    }
+
+    if (offset > 0xFFFF)
+    {
+        cout << "ERROR: Method " << methodName
+             << " is too large for a class file." << endl;
+        exit(-1);
+    }
+
+    return offset;
+}
+
+int ClassFileWriter::encode(const MethodCode& code, size_t index, int offset,
+                            ByteBuffer *out)
+{
+    const CodeRecord& record = *body[index];
+    if (!record.isInstruction()) return 0;
+
+    Instruction instruction = record.instruction;
+    int op = opcode(instruction);
+
+    switch (instruction)
+    {
+        case Instruction::BIPUSH:
+            if (out != nullptr)
+            {
+                out->putU1(op);
+                out->putU1(record.operands[0]);
+            }
+            return 2;
+
+        case Instruction::SIPUSH:
+            if (out != nullptr)
+            {
+                out->putU1(op);
+                out->putU2(record.operands[0]);
+            }
+            return 3;
+
+        case Instruction::LDC:
+        {
+            int constant = ldcConstant(code, record);
+
+            if (constant <= 0xFF)
+            {
+                if (out != nullptr)
+                {
+                    out->putU1(op);
+                    out->putU1(constant);
+                }
+                return 2;
+            }
+
+            if (out != nullptr)
+            {
+                out->putU1(OP_LDC_W);
+                out->putU2(constant);
+            }
+            return 3;
+        }
+
+        case Instruction::ILOAD:  case Instruction::FLOAD:
+        case Instruction::ALOAD:  case Instruction::LLOAD:
+        case Instruction::ISTORE: case Instruction::FSTORE:
+        case Instruction::ASTORE: case Instruction::LSTORE:
+            return encodeLocal(op, record.operands[0], 0, false, out);
+
+        case Instruction::IINC:
+            return encodeLocal(op, record.operands[0], record.operands[1],
+                               true, out);
+
+        case Instruction::GETSTATIC: case Instruction::GETFIELD:
+        case Instruction::PUTSTATIC: case Instruction::PUTFIELD:
+        {
+            int field = fieldOperand(operandText(code, record));
+            if (out != nullptr)
+            {
+                out->putU1(op);
+                out->putU2(field);
+            }
+            return 3;
+        }
+
+        case Instruction::INVOKESTATIC:  case Instruction::INVOKESPECIAL:
+        case Instruction::INVOKEVIRTUAL: case Instruction::INVOKENONVIRTUAL:
+        {
+            int method = methodOperand(operandText(code, record));
+            if (out != nullptr)
+            {
+                out->putU1(op);
+                out->putU2(method);
+            }
+            return 3;
+        }
+
+        case Instruction::NEW:       case Instruction::ANEWARRAY:
+        case Instruction::CHECKCAST:
+        {
+            int type = pool.classRef(code.getText(record.operands[0]));
+            if (out != nullptr)
+            {
+                out->putU1(op);
+                out->putU2(type);
+            }
+            return 3;
+        }
+
+        case Instruction::MULTIANEWARRAY:
+        {
+            int type = pool.classRef(code.getText(record.operands[0]));
+            if (out != nullptr)
+            {
+                out->putU1(op);
+                out->putU2(type);
+                out->putU1(stoi(code.getText(record.operands[1])));
+            }
+            return 4;
+        }
+
+        case Instruction::NEWARRAY:
+        {
+            static const map<string, int> ARRAY_TYPES =
+            {
+                {"boolean", 4}, {"char",  5}, {"float", 6}, {"double", 7},
+                {"byte",    8}, {"short", 9}, {"int",  10}, {"long",  11},
+            };
+
+            if (out != nullptr)
+            {
+                out->putU1(op);
+                out->putU1(ARRAY_TYPES.at(code.getText(record.operands[0])));
+            }
+            return 2;
+        }
+
+        case Instruction::IFEQ:      case Instruction::IFNE:
+        case Instruction::IFLT:      case Instruction::IFLE:
+        case Instruction::IFGT:      case Instruction::IFGE:
+        case Instruction::IF_ICMPEQ: case Instruction::IF_ICMPNE:
+        case Instruction::IF_ICMPLT: case Instruction::IF_ICMPLE:
+        case Instruction::IF_ICMPGT: case Instruction::IF_ICMPGE:
+        case Instruction::GOTO:
+            if (out != nullptr)
+            {
+                out->putU1(op);
+                out->putU2(branchOffset(record.label, offset));
+            }
+            return 3;
+
+        case Instruction::LOOKUPSWITCH:
+        {
+            // The match-offset pairs and default label follow.
+            vector<pair<int, Label *>> matches;
+            Label *defaultLabel = nullptr;
+
+            for (size_t i = index + 1;
+                 (i < body.size()) && (defaultLabel == nullptr); i++)
+            {
+                const CodeRecord& entry = *body[i];
+
+                if (entry.kind == RecordKind::DEFAULT_CASE)
+                {
+                    defaultLabel = entry.label;
+                }
+                else if (   (entry.kind == RecordKind::CASE)
+                         || (   (entry.kind == RecordKind::SWITCH_LABEL)
+                             && (entry.form == OperandForm::INTEGER)))
+                {
+                    matches.push_back(make_pair(entry.operands[0],
+                                                entry.label));
+                }
+            }
+
+            int padding = 3 - (offset%4);
+            int size = 1 + padding + 8 + 8*matches.size();
+
+            if (out != nullptr)
+            {
+                // The JVM requires the pairs sorted by match value.
+                sort(matches.begin(), matches.end(),
+                     [] (const pair<int, Label *>& a,
+                         const pair<int, Label *>& b)
+                     { return a.first < b.first; });
+
+                out->putU1(op);
+                for (int i = 0; i < padding; i++) out->putU1(0);
+                out->putU4(branchOffset(defaultLabel, offset));
+                out->putU4(matches.size());
+
+                for (auto& match : matches)
+                {
+                    out->putU4(match.first);
+                    out->putU4(branchOffset(match.second, offset));
+                }
+            }
+            return size;
+        }
+
+        // Instructions without operands.
+        default:
+            if (out != nullptr) out->putU1(op);
+            return 1;
+    }
+}
+
+int ClassFileWriter::encodeLocal(int opcode, int slot, int increment,
+                                 bool hasIncrement, ByteBuffer *out)
+{
+    bool wide = (slot > 0xFF)
+                 || (hasIncrement && ((increment < -128) || (increment > 127)));
+
+    if (!wide)
+    {
+        if (out != nullptr)
+        {
+            out->putU1(opcode);
+            out->putU1(slot);
+            if (hasIncrement) out->putU1(increment);
+        }
+        return hasIncrement ? 3 : 2;
+    }
+
+    if (out != nullptr)
+    {
+        out->putU1(OP_WIDE);
+        out->putU1(opcode);
+        out->putU2(slot);
+        if (hasIncrement) out->putU2(increment);
+    }
+    return hasIncrement ? 6 : 4;
+}
+
+int ClassFileWriter::branchOffset(Label *label, int offset)
+{
+    auto it = labelOffsets.find(label);
+    if ((label == nullptr) || (it == labelOffsets.end()))
+    {
+        cout << "ERROR: Undefined label "
+             << (label != nullptr ? label->getString() : "")
+             << " in method " << methodName << "." << endl;
+        exit(-1);
+    }
+
+    int branch = it->second - offset;
+    if ((branch < -32768) || (branch > 32767))
+    {
+        cout << "ERROR: Branch to " << label << " in method " << methodName
+             << " is out of range." << endl;
+        exit(-1);
+    }
+
+    return branch;
+}
+
+int ClassFileWriter::ldcConstant(const MethodCode& code,
+                                 const CodeRecord& record)
+{
+    switch (record.form)
+    {
+        case OperandForm::INTEGER:
+            return pool.integer(record.operands[0]);
+
+        case OperandForm::REAL:
+            return pool.real(static_cast<float>(record.real));
+
+        default:
+        {
+            string text = code.getText(record.operands[0]);
+
+            return text[0] == '"' ? pool.stringConstant(unquote(text))
+                                  : pool.classRef(text);
+        }
+    }
+}
+
+int ClassFileWriter::fieldOperand(const string& text)
+{
+    size_t blank = text.find(' ');
+    size_t slash = text.rfind('/', blank);
+
+    return pool.fieldRef(text.substr(0, slash),
+                         text.substr(slash + 1, blank - slash - 1),
+                         text.substr(blank + 1));
+}
+
+int ClassFileWriter::methodOperand(const string& text)
+{
+    // The method name may follow either a slash or a dot.
+    size_t paren = text.find('(');
+    size_t separator = text.find_last_of("/.", paren);
+
+    return pool.methodRef(text.substr(0, separator),
+                          text.substr(separator + 1, paren - separator - 1),
+                          text.substr(paren));
+}
+
+string ClassFileWriter::operandText(const MethodCode& code,
+                                    const CodeRecord& record)
+{
+    if (record.form == OperandForm::TEXT_PAIR)
+    {
+        return code.getText(record.operands[0]) + " "
+             + code.getText(record.operands[1]);
+    }
+
+    return code.getText(record.operands[0]);
+}
+
+string ClassFileWriter::unquote(const string& literal)
+{
+    string value;
+    size_t last = literal.size() - 1;
+
+    for (size_t i = 1; i < last; i++)
+    {
+        char ch = literal[i];
+
+        if ((ch != '\\') || (i + 1 == last))
+        {
+            value += ch;
+            continue;
+        }
+
+        ch = literal[++i];
+        switch (ch)
+        {
+            case 'n': value += '\n'; break;
+            case 't': value += '\t'; break;
+            case 'r': value += '\r'; break;
+            case 'b': value += '\b'; break;
+            case 'f': value += '\f'; break;
+
+            case 'u':
+            {
+                // A UTF-16 code unit, written as modified UTF-8.
+                int unit = stoi(literal.substr(i + 1, 4), nullptr, 16);
+                i += 4;
+
+                if ((unit > 0) && (unit < 0x80)) value += char(unit);
+                else if (unit < 0x800)
+                {
+                    value += char(0xC0 | (unit >> 6));
+                    value += char(0x80 | (unit & 0x3F));
+                }
+                else
+                {
+                    value += char(0xE0 | (unit >> 12));
+                    value += char(0x80 | ((unit >> 6) & 0x3F));
+                    value += char(0x80 | (unit & 0x3F));
+                }
+                break;
+            }
+
+            // \" \' \\ and any other escaped character.
+            default: value += ch; break;
+        }
+    }
+
+    return value;
+}
+
+int ClassFileWriter::accessFlags(Directive directive)
+{
+    switch (directive)
+    {
+        case Directive::CLASS_PUBLIC:
+        case Directive::METHOD_PUBLIC:          return ACC_PUBLIC;
+        case Directive::METHOD_STATIC:          return ACC_STATIC;
+        case Directive::METHOD_PUBLIC_STATIC:   return ACC_PUBLIC  | ACC_STATIC;
+        case Directive::FIELD_PRIVATE_STATIC:
+        case Directive::METHOD_PRIVATE_STATIC:  return ACC_PRIVATE | ACC_STATIC;
+        default:                                return 0;
+    }
+}
+
+int ClassFileWriter::opcode(Instruction instruction)
+{
+    static const map<Instruction, int> OPCODES =
+    {
+        // Load constant
+        {ICONST_0, 0x03}, {ICONST_1, 0x04}, {ICONST_2, 0x05},
+        {ICONST_3, 0x06}, {ICONST_4, 0x07}, {ICONST_5, 0x08},
+        {ICONST_M1, 0x02},
+        {FCONST_0, 0x0B}, {FCONST_1, 0x0C}, {FCONST_2, 0x0D},
+        {ACONST_NULL, 0x01},
+        {BIPUSH, 0x10}, {SIPUSH, 0x11}, {LDC, 0x12},
+
+        // Load value or address
+        {ILOAD_0, 0x1A}, {ILOAD_1, 0x1B}, {ILOAD_2, 0x1C}, {ILOAD_3, 0x1D},
+        {FLOAD_0, 0x22}, {FLOAD_1, 0x23}, {FLOAD_2, 0x24}, {FLOAD_3, 0x25},
+        {ALOAD_0, 0x2A}, {ALOAD_1, 0x2B}, {ALOAD_2, 0x2C}, {ALOAD_3, 0x2D},
+        {LLOAD_0, 0x1E}, {LLOAD_1, 0x1F}, {LLOAD_2, 0x20}, {LLOAD_3, 0x21},
+        {ILOAD, 0x15}, {FLOAD, 0x17}, {ALOAD, 0x19}, {LLOAD, 0x16},
+        {GETSTATIC, 0xB2}, {GETFIELD, 0xB4},
+
+        // Store value or address
+        {ISTORE_0, 0x3B}, {ISTORE_1, 0x3C}, {ISTORE_2, 0x3D}, {ISTORE_3, 0x3E},
+        {FSTORE_0, 0x43}, {FSTORE_1, 0x44}, {FSTORE_2, 0x45}, {FSTORE_3, 0x46},
+        {ASTORE_0, 0x4B}, {ASTORE_1, 0x4C}, {ASTORE_2, 0x4D}, {ASTORE_3, 0x4E},
+        {LSTORE_0, 0x3F}, {LSTORE_1, 0x40}, {LSTORE_2, 0x41}, {LSTORE_3, 0x42},
+        {ISTORE, 0x36}, {FSTORE, 0x38}, {ASTORE, 0x3A}, {LSTORE, 0x37},
+        {PUTSTATIC, 0xB3}, {PUTFIELD, 0xB5},
+
+        // Operand stack
+        {POP, 0x57}, {POP2, 0x58}, {SWAP, 0x5F}, {DUP, 0x59},
+        {DUP_X1, 0x5A}, {DUP_X2, 0x5B},
+
+        // Arithmetic and logical
+        {IADD, 0x60}, {FADD, 0x62}, {ISUB, 0x64}, {FSUB, 0x66},
+        {IMUL, 0x68}, {FMUL, 0x6A}, {IDIV, 0x6C}, {FDIV, 0x6E},
+        {IREM, 0x70}, {FREM, 0x72}, {INEG, 0x74}, {FNEG, 0x76},
+        {IINC, 0x84}, {IAND, 0x7E}, {IOR, 0x80}, {IXOR, 0x82},
+        {LADD, 0x61}, {LSUB, 0x65},
+
+        // Type conversion and checking
+        {I2F, 0x86}, {I2C, 0x92}, {I2D, 0x87}, {F2I, 0x8B},
+        {F2D, 0x8D}, {D2F, 0x90}, {CHECKCAST, 0xC0},
+
+        // Objects and arrays
+        {NEW, 0xBB}, {NEWARRAY, 0xBC}, {ANEWARRAY, 0xBD},
+        {MULTIANEWARRAY, 0xC5},
+        {IALOAD, 0x2E}, {FALOAD, 0x30}, {BALOAD, 0x33},
+        {CALOAD, 0x34}, {AALOAD, 0x32},
+        {IASTORE, 0x4F}, {FASTORE, 0x51}, {BASTORE, 0x54},
+        {CASTORE, 0x55}, {AASTORE, 0x53},
+
+        // Compare and branch
+        {IFEQ, 0x99}, {IFNE, 0x9A}, {IFLT, 0x9B},
+        {IFGE, 0x9C}, {IFGT, 0x9D}, {IFLE, 0x9E},
+        {IF_ICMPEQ, 0x9F}, {IF_ICMPNE, 0xA0}, {IF_ICMPLT, 0xA1},
+        {IF_ICMPGE, 0xA2}, {IF_ICMPGT, 0xA3}, {IF_ICMPLE, 0xA4},
+        {FCMPG, 0x96}, {GOTO, 0xA7}, {LOOKUPSWITCH, 0xAB},
+
+        // Call and return
+        {INVOKESTATIC, 0xB8}, {INVOKESPECIAL, 0xB7},
+        {INVOKEVIRTUAL, 0xB6}, {INVOKENONVIRTUAL, 0xB7},
+        {RETURN, 0xB1}, {IRETURN, 0xAC}, {FRETURN, 0xAE}, {ARETURN, 0xB0},
+        {LRETURN, 0xAD},
+
+        // No operation
+        {NOP, 0x00},
+    };
+
+    return OPCODES.at(instruction);
+}
+
+}} // namespace backend::compiler
@@ -0,0 +1,193 @@
+/**
+ * <h1>ClassFileWriter</h1>
+ *
+ * <p>Assemble method code records directly into a JVM class file,
+ * without going through Jasmin.</p>
+ */
+#ifndef CLASSFILEWRITER_H_
+#define CLASSFILEWRITER_H_
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "MethodCode.h"
+#include "ObjectFile.h"
+#include "ByteBuffer.h"
+#include "ConstantPool.h"
+#include "FrameAnalyzer.h"
+
+namespace backend { namespace compiler {
+
+using namespace std;
+
+class ClassFileWriter
+{
+private:
+    ObjectFile *objectFile;  // where to write the class file
+
+    ConstantPool pool;       // the class's constant pool
+    int classAccess;         // access flags of the class
+    string className;        // internal name of the class
+    int thisClass;           // constant pool index of the class
+    int superClass;          // constant pool index of the superclass
+    ByteBuffer fields;       // the encoded fields
+    int fieldCount;          // count of fields
+    ByteBuffer methods;      // the encoded methods
+    int methodCount;         // count of methods
+
+    int methodAccess;        // access flags of the current method
+    string methodName;       // name of the current method
+    string methodDescriptor; // descriptor of the current method
+    int maxLocals;           // from the method's .limit locals
+    int maxStack;            // from the method's .limit stack
+    vector<const CodeRecord *> body;  // the current method's code
+
+    vector<int> offsets;              // bytecode offset of each body record
+    map<Label *, int> labelOffsets;   // bytecode offset of each label
+
+public:
+    /**
+     * Constructor.
+     * @param objectFile the object file to write to.
+     */
+    ClassFileWriter(ObjectFile *objectFile);
+
+    /**
+     * Assemble method code records. Class-level directives are
+     * recorded, and each method is assembled at its .end method.
+     * @param code the method code.
+     */
+    void write(const MethodCode& code);
+
+    /**
+     * Write the complete class file to the object file.
+     */
+    void close();
+
+private:
+    /**
+     * Process a directive record.
+     * @param code the method code that contains the record.
+     * @param record the record.
+     */
+    void writeDirective(const MethodCode& code, const CodeRecord& record);
+
+    /**
+     * Assemble the current method and append it to the methods.
+     * @param code the method code.
+     */
+    void writeMethod(const MethodCode& code);
+
+    /**
+     * Encode the StackMapTable attribute of the current method.
+     * @param code the method code.
+     * @param out the buffer to write the attribute to.
+     * @return true if the method needs the attribute, else false.
+     */
+    bool writeStackMapTable(const MethodCode& code, ByteBuffer& out);
+
+    /**
+     * Encode a verification type.
+     * @param type the type.
+     * @param out the buffer to write to.
+     */
+    void writeVerificationType(const VerificationType& type,
+                               ByteBuffer& out);
+
+    /**
+     * Compute the bytecode offset of each record and label
+     * of the current method.
+     * @param code the method code.
+     * @return the bytecode length.
+     */
+    int locateLabels(const MethodCode& code);
+
+    /**
+     * Encode an instruction of the current method.
+     * @param code the method code.
+     * @param index the index of the instruction in the body.
+     * @param offset the bytecode offset of the instruction.
+     * @param out the bytecode buffer, or null to only compute the size.
+     * @return the size of the encoded instruction in bytes.
+     */
+    int encode(const MethodCode& code, size_t index, int offset,
+               ByteBuffer *out);
+
+    /**
+     * Encode a local variable load, store or increment, using the
+     * wide prefix if the operands do not fit in a byte.
+     * @param opcode the operation code byte.
+     * @param slot the local variable slot number.
+     * @param increment the increment of IINC, or 0.
+     * @param hasIncrement true for IINC.
+     * @param out the bytecode buffer, or null.
+     * @return the encoded size in bytes.
+     */
+    static int encodeLocal(int opcode, int slot, int increment,
+                           bool hasIncrement, ByteBuffer *out);
+
+    /**
+     * Compute the branch offset to a label.
+     * @param label the target label.
+     * @param offset the bytecode offset of the branch instruction.
+     * @return the branch offset.
+     */
+    int branchOffset(Label *label, int offset);
+
+    /**
+     * Enter the constant operand of an LDC instruction.
+     * @param code the method code that contains the instruction.
+     * @param record the instruction record.
+     * @return the constant pool index.
+     */
+    int ldcConstant(const MethodCode& code, const CodeRecord& record);
+
+    /**
+     * Enter a field reference written as "owner/name descriptor".
+     * @param text the reference text.
+     * @return the constant pool index.
+     */
+    int fieldOperand(const string& text);
+
+    /**
+     * Enter a method reference written as "owner/name(params)return".
+     * @param text the reference text.
+     * @return the constant pool index.
+     */
+    int methodOperand(const string& text);
+
+    /**
+     * Get an instruction's operand text, joining a pair with a blank.
+     * @param code the method code that contains the record.
+     * @param record the instruction record.
+     * @return the text.
+     */
+    static string operandText(const MethodCode& code, const CodeRecord& record);
+
+    /**
+     * Remove the quotes of a Jasmin string literal and replace its
+     * escape sequences with the characters they represent.
+     * @param literal the quoted literal.
+     * @return the string value.
+     */
+    static string unquote(const string& literal);
+
+    /**
+     * Get the access flags of a .class, .field or .method directive.
+     * @param directive the directive code.
+     * @return the access flags.
+     */
+    static int accessFlags(Directive directive);
+
+    /**
+     * Get the operation code byte of an instruction.
+     * @param instruction the instruction.
+     * @return the operation code byte.
+     */
+    static int opcode(Instruction instruction);
+};
+
+}}  // namespace backend::compiler
+
+#endif /* CLASSFILEWRITER_H_ */
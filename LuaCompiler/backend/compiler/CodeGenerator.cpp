@@ -16,12 +16,12 @@
 
 #include "intermediate/symtab/Predefined.h"
 #include "intermediate/type/Typespec.h"
+#include "intermediate/util/Tracer.h"
 #include "CodeGenerator.h"
 #include "Directive.h"
 #include "Label.h"
 #include "Instruction.h"
 #include "LocalVariables.h"
-#include "LocalStack.h"
 
 namespace backend { namespace compiler {
 
@@ -29,20 +29,82 @@ using namespace std;
 using namespace std::chrono;
 using namespace intermediate;
 
-int Label::index = 0;
-int CodeGenerator::count = 0;
 
-void CodeGenerator::open(string programName, string suffix)
+void CodeGenerator::open(string programName, string suffix,
+                         const CompilerOptions& options)
 {
     objectFileName = programName + "." + suffix;
-    objectFile = new ofstream(objectFileName);
+    objectFile = new ObjectFile(objectFileName, options.outputBufferSize,
+                                options.syncOutput);
+    ownedObjectFile.reset(objectFile);
 
-    if (!objectFile->is_open())
+    if (!objectFile->isOpen())
     {
         cout << "ERROR: Failed to open object file \""
              << objectFileName << "\"." << endl;
         exit(-1);
     }
+
+    methodCode    = new MethodCode();
+    stackAnalyzer = new StackAnalyzer();
+    jasminWriter  = new JasminWriter(objectFile);
+    ownedMethodCode.reset(methodCode);
+    ownedStackAnalyzer.reset(stackAnalyzer);
+    ownedJasminWriter.reset(jasminWriter);
+    if (options.emit == EmitFormat::CLASS)
+    {
+        classWriter = new ClassFileWriter(objectFile);
+        ownedClassWriter.reset(classWriter);
+    }
+    if (options.peephole)
+    {
+        peephole = new PeepholeOptimizer();
+        ownedPeephole.reset(peephole);
+    }
+}
+
+void CodeGenerator::close()
+{
+    writeCode();
+    if (classWriter != nullptr) classWriter->close();
+    objectFile->close();
+}
+
+void CodeGenerator::writeCode()
+{
+    if (!methodCode->isEmpty())
+    {
+        util::TraceSpan span("codegen", "CodeGenerator::writeCode");
+        span.arg("records", (long) methodCode->getRecords().size());
+
+        if (peephole != nullptr) peephole->optimize(*methodCode);
+        stackAnalyzer->analyze(*methodCode);
+
+        // A routine generated on its own is spliced in later.
+        if (deferred != nullptr) deferred->push_back(move(*methodCode));
+        else                     write(*methodCode);
+
+        methodCode->clear();
+    }
+}
+
+void CodeGenerator::splice(vector<MethodCode>& codes)
+{
+    writeCode();
+    for (const MethodCode& code : codes) write(code);
+}
+
+void CodeGenerator::write(const MethodCode& code)
+{
+    int instructions = 0;
+    for (const CodeRecord& record : code.getRecords())
+    {
+        if (record.isInstruction()) instructions++;
+    }
+    objectFile->countInstructions(instructions);
+
+    if (classWriter != nullptr) classWriter->write(code);
+    else                        jasminWriter->write(code);
 }
 
 // =====================
@@ -54,8 +116,7 @@ void CodeGenerator::open(string programName, string suffix)
  */
 void CodeGenerator::emitLine()
 {
-    *objectFile << endl;;
-    objectFile->flush();
+    methodCode->appendBlankLine();
 }
 
 /**
@@ -64,10 +125,7 @@ void CodeGenerator::emitLine()
  */
 void CodeGenerator::emitComment(string text)
 {
-    *objectFile << ";" << endl;
-    *objectFile << "; " << text << endl;
-    *objectFile << ";" << endl;
-    objectFile->flush();
+    methodCode->appendComment(text);
 }
 
 
@@ -83,41 +141,45 @@ void CodeGenerator::emitComment(LuaParser::BlockContext *ctx)
 
 void CodeGenerator::emitLabel(Label *label)
 {
-    *objectFile << label << ":" << endl;
-    objectFile->flush();
+    methodCode->appendLabel(label);
 }
 
 void CodeGenerator::emitLabel(int value, Label *label)
 {
-    *objectFile << "\t  " << value << ": " << label << endl;
-    objectFile->flush();
+    methodCode->appendSwitchLabel(value, label);
 }
 
 void CodeGenerator::emitLabel(string value, Label *label)
 {
-    *objectFile << "\t  " << value << ": " << label << endl;
-    objectFile->flush();
+    methodCode->appendSwitchLabel(value, label);
 }
 
 void CodeGenerator::emitDirective(Directive directive)
 {
-    *objectFile << directive << endl;
-    objectFile->flush();
-    ++count;
+    methodCode->appendDirective(directive);
+
+    // The method is complete.
+    if (directive == END_METHOD) writeCode();
 }
 
 void CodeGenerator::emitDirective(Directive directive, string operand)
 {
-    *objectFile << directive << " " << operand << endl;
-    objectFile->flush();
-    ++count;
+    // A new method: first write any pending class-level code
+    // so that each method's code is buffered by itself.
+    if (   (directive == METHOD_PUBLIC)
+        || (directive == METHOD_STATIC)
+        || (directive == METHOD_PUBLIC_STATIC)
+        || (directive == METHOD_PRIVATE_STATIC))
+    {
+        writeCode();
+    }
+
+    methodCode->appendDirective(directive, operand);
 }
 
 void CodeGenerator::emitDirective(Directive directive, int operand)
 {
-    *objectFile << directive << " " << operand << endl;
-    objectFile->flush();
-    ++count;
+    methodCode->appendDirective(directive, operand);
 }
 
 /**
@@ -128,94 +190,59 @@ void CodeGenerator::emitDirective(Directive directive, int operand)
 void CodeGenerator::emitDirective(Directive directive,
                                   string operand1, string operand2)
 {
-    *objectFile << directive << " " << operand1 << " " << operand2 << endl;
-    objectFile->flush();
-    ++count;
+    methodCode->appendDirective(directive, operand1, operand2);
 }
 void CodeGenerator::emitDirective(Directive directive,
                                   string operand1, string operand2,
                                   string operand3)
 {
-    *objectFile << directive << " " + operand1 << " " << operand2
-                                               << " " << operand3 << endl;
-    objectFile->flush();
-    ++count;
+    methodCode->appendDirective(directive, operand1, operand2, operand3);
 }
 
 void CodeGenerator::emit(Instruction instruction)
 {
-    *objectFile << "\t" << instruction << endl;
-    objectFile->flush();
-
-    localStack->increase(stackUse(instruction));
-    ++count;
+    methodCode->appendInstruction(instruction);
 }
 
 void CodeGenerator::emit(Instruction instruction, string operand)
 {
-    *objectFile << "\t" << instruction << "\t" << operand << endl;
-    objectFile->flush();
-
-    localStack->increase(stackUse(instruction));
-    ++count;
+    methodCode->appendInstruction(instruction, operand);
 }
 
 void CodeGenerator::emit(Instruction instruction, int operand)
 {
-    *objectFile << "\t" << instruction << "\t" << operand << endl;
-    objectFile->flush();
-
-    localStack->increase(stackUse(instruction));
-    ++count;
+    methodCode->appendInstruction(instruction, operand);
 }
 
 void CodeGenerator::emit(Instruction instruction, double operand)
 {
-    *objectFile << "\t" << instruction << "\t" << operand << endl;
-    objectFile->flush();
-
-    localStack->increase(stackUse(instruction));
-    ++count;
+    methodCode->appendInstruction(instruction, operand);
 }
 
 void CodeGenerator::emit(Instruction instruction, Label *label)
 {
-    *objectFile << "\t" << instruction << "\t" << label << endl;
-    objectFile->flush();
-
-    localStack->increase(stackUse(instruction));
-    ++count;
+    methodCode->appendInstruction(instruction, label);
 }
 
 void CodeGenerator::emit(Instruction instruction, int operand1, int operand2)
 {
-    *objectFile << "\t" << instruction << "\t" << operand1 << " "
-                                               << operand2 << endl;
-    objectFile->flush();
-
-    localStack->increase(stackUse(instruction));
-    ++count;
+    methodCode->appendInstruction(instruction, operand1, operand2);
 }
 
 void CodeGenerator::emit(Instruction instruction,
                          string operand1, string operand2)
 {
-    *objectFile << "\t" << instruction << "\t" << operand1 << " "
-                                               << operand2 << endl;
-    objectFile->flush();
-
-    localStack->increase(stackUse(instruction));
-    ++count;
+    methodCode->appendInstruction(instruction, operand1, operand2);
 }
 
 void CodeGenerator::emitCase(int caseNum, Label *label)	// Added by us
 {
-    *objectFile << "\t" << "\t" << caseNum << ": " << label << endl;
+    methodCode->appendCase(caseNum, label);
 }
 
 void CodeGenerator::emitDefaultCase(Label *label)	// Added by us
 {
-    *objectFile << "\t" << "\t" << "default: " << label << endl << endl;
+    methodCode->appendDefaultCase(label);
 }
 
 // =====
@@ -268,7 +295,7 @@ void CodeGenerator::emitLoadConstant(string value)
 
 void CodeGenerator::emitLoadValue(SymtabEntry *variableId)
 {
-    Typespec *type = Predefined::numberType;
+    Typespec *type = variableId->getType();
     Kind kind = variableId->getKind();
     int nestingLevel = variableId->getSymtab()->getNestingLevel();
 
@@ -277,24 +304,23 @@ void CodeGenerator::emitLoadValue(SymtabEntry *variableId)
     {
         Object value = variableId->getValue();
 
-        if (type == Predefined::numberType)
+        if (isPrimitive(type))
         {
             emitLoadConstant(value.as<int>());
         }
-        else if (type == Predefined::nilType)
+        else if (type == Predefined::stringType)
         {
-            emitLoadConstant(value.as<int>());
+            emitLoadConstant(value.as<string>());
         }
-        else  // string
+        else  // nil
         {
-            emitLoadConstant(value.as<string>());
+            emit(ACONST_NULL);
         }
     }
 
     // Program variable.
     else if (nestingLevel == 1)
     {
-    	cout << "Here\n";
         string variableName = variableId->getName();
         string name = programName + "/" + variableName;
         emit(GETSTATIC, name, typeDescriptor(type));
@@ -315,13 +341,7 @@ void CodeGenerator::emitLoadValue(SymtabEntry *variableId)
  */
 void CodeGenerator::emitLoadLocal(Typespec *type, int index)
 {
-    if (type != nullptr)
-        type = type->baseType();
-
-
-    if (   (type == Predefined::numberType)
-        || (type == Predefined::boolType)
-        || (type == Predefined::stringType))
+    if (isPrimitive(type))
     {
         switch (index)
         {
@@ -331,6 +351,16 @@ void CodeGenerator::emitLoadLocal(Typespec *type, int index)
             default: emit(ILOAD, index);
         }
     }
+    else if (isTagged(type))
+    {
+        switch (index)
+        {
+            case 0:  emit(LLOAD_0); break;
+            case 1:  emit(LLOAD_1); break;
+            case 2:  emit(LLOAD_2); break;
+            default: emit(LLOAD, index);
+        }
+    }
     else
     {
         switch (index)
@@ -368,28 +398,20 @@ void CodeGenerator::emitStoreToUnmodifiedVariable(SymtabEntry *targetId,
         string name = programName + "/" + targetName;
 
         emitRangeCheck(targetType);
-        emit(PUTSTATIC, name, typeDescriptor(targetType->baseType()));
+        emit(PUTSTATIC, name, typeDescriptor(targetType));
     }
 
     // Local variable.
     else
     {
         emitRangeCheck(targetType);
-        emitStoreLocal(targetType->baseType(), slot);
+        emitStoreLocal(targetType, slot);
     }
 }
 
 void CodeGenerator::emitStoreLocal(Typespec *type, int slot)
 {
-
-    if (type != nullptr)
-    {
-        type = type->baseType();
-    }
-
-    if (   (type == Predefined::numberType)
-        || (type == Predefined::boolType)
-        || (type == Predefined::stringType))
+    if (isPrimitive(type))
     {
         switch (slot)
         {
@@ -399,6 +421,16 @@ void CodeGenerator::emitStoreLocal(Typespec *type, int slot)
             default: emit(ISTORE, slot);
         }
     }
+    else if (isTagged(type))
+    {
+        switch (slot)
+        {
+            case 0:  emit(LSTORE_0); break;
+            case 1:  emit(LSTORE_1); break;
+            case 2:  emit(LSTORE_2); break;
+            default: emit(LSTORE, slot);
+        }
+    }
     else
     {
         switch (slot)
@@ -443,16 +475,135 @@ void CodeGenerator::emitCheckCastClass(Typespec *type)
 
 void CodeGenerator::emitReturnValue(Typespec *type)
 {
+    if      (isPrimitive(type)) emit(IRETURN);
+    else if (isTagged(type))    emit(LRETURN);
+    else                        emit(ARETURN);
+}
 
-    if (type != nullptr)
-        type = type->baseType();
+void CodeGenerator::emitLoadDefault(Typespec *type)
+{
+    if      (isPrimitive(type)) emit(ICONST_0);
+    else if (isTagged(type))    emit(GETSTATIC, "LuaValue/NIL", "J");
+    else                        emit(ACONST_NULL);
+}
 
+void CodeGenerator::emitPop(Typespec *type)
+{
+    emit(isTagged(type) ? POP2 : POP);
+}
+
+void CodeGenerator::emitConvert(Typespec *fromType, Typespec *toType)
+{
+    if (fromType == nullptr) fromType = Predefined::nilType;
+    if (toType   == nullptr) toType   = Predefined::nilType;
+    if (fromType == toType) return;
+
+    // From a dynamic value. Only the conversion
+    // to a string can allocate.
+    if (isTagged(fromType))
+    {
+        if (toType == Predefined::numberType)
+        {
+            emit(INVOKESTATIC, "LuaValue/toInt(J)I");
+        }
+        else if (toType == Predefined::boolType)
+        {
+            emit(INVOKESTATIC, "LuaValue/toBoolean(J)Z");
+        }
+        else if (toType == Predefined::stringType)
+        {
+            emit(INVOKESTATIC, "LuaValue/toString(J)Ljava/lang/String;");
+        }
+        else  // nil
+        {
+            emit(POP2);
+            emit(ACONST_NULL);
+        }
+
+        return;
+    }
+
+    // To a dynamic value. Only the conversion
+    // from a string looks up the runtime's side table.
+    if (isTagged(toType))
+    {
+        if (fromType == Predefined::numberType)
+        {
+            emit(INVOKESTATIC, "LuaValue/ofInt(I)J");
+        }
+        else if (fromType == Predefined::boolType)
+        {
+            emit(INVOKESTATIC, "LuaValue/ofBoolean(Z)J");
+        }
+        else if (fromType == Predefined::stringType)
+        {
+            emit(INVOKESTATIC, "LuaValue/ofString(Ljava/lang/String;)J");
+        }
+        else  // nil
+        {
+            emit(POP);
+            emit(GETSTATIC, "LuaValue/NIL", "J");
+        }
+
+        return;
+    }
+
+    bool fromPrimitive = isPrimitive(fromType);
+
+    // To an int or a boolean. Both are ints in the JVM.
+    if (isPrimitive(toType))
+    {
+        if (fromPrimitive) return;
+
+        // Lua converts a numeric string in arithmetic. The runtime
+        // converts it as it does a dynamic string.
+        if (   (fromType == Predefined::stringType)
+            && (toType == Predefined::numberType))
+        {
+            emit(INVOKESTATIC, "LuaValue/parseInt(Ljava/lang/String;)I");
+        }
+        else
+        {
+            emitCheckCastClass(toType);
+            emit(INVOKEVIRTUAL, valueSignature(toType));
+        }
+    }
+
+    // To a string.
+    else if (toType == Predefined::stringType)
+    {
+        if (fromPrimitive)
+        {
+            emit(INVOKESTATIC, "java/lang/String/valueOf("
+                               + typeDescriptor(fromType)
+                               + ")Ljava/lang/String;");
+        }
+        else emitCheckCast(toType);
+    }
+
+    // To nil, which is an object.
+    else if (fromPrimitive) emit(INVOKESTATIC, valueOfSignature(fromType));
+}
+
+void CodeGenerator::emitTruth(Typespec *type)
+{
+    // Only nil and false are false.
+    if (type == Predefined::boolType) return;
 
     if (   (type == Predefined::numberType)
-        || (type == Predefined::boolType)
         || (type == Predefined::stringType))
-    									   emit(IRETURN);
-    else                                   emit(ARETURN);
+    {
+        emit(POP);
+        emit(ICONST_1);
+    }
+    else if ((type == Predefined::nilType) || (type == nullptr))
+    {
+        emit(POP);
+        emit(ICONST_0);
+    }
+
+    // A dynamic value, which the runtime tests by its bits.
+    else emit(INVOKESTATIC, "LuaValue/truth(J)Z");
 }
 
 void CodeGenerator::emitRangeCheck(Typespec *targetType)
@@ -475,45 +626,38 @@ void CodeGenerator::emitRangeCheck(Typespec *targetType)
 // Utilities
 // =========
 
-string CodeGenerator::typeDescriptor(SymtabEntry *id)
+bool CodeGenerator::isPrimitive(Typespec *type)
 {
-    Typespec *type = id->getType();
-    return type != nullptr ? typeDescriptor(type) : "I";
+    return    (type == Predefined::numberType)
+           || (type == Predefined::boolType);
 }
 
-string CodeGenerator::typeDescriptor(Typespec *LuaType)
+bool CodeGenerator::isTagged(Typespec *type)
 {
-    string descriptor;
-
-    LuaType = LuaType->baseType();
-    string str;
+    return type == Predefined::dynamicType;
+}
 
-    if      (LuaType == Predefined::numberType) 	str = "I";
-    else if (LuaType == Predefined::boolType) 		str = "Z";
-    else if (LuaType == Predefined::stringType)  	str = "Ljava/lang/String;";
-    else 											str = "nil";
+string CodeGenerator::typeDescriptor(SymtabEntry *id)
+{
+    return typeDescriptor(id->getType());
+}
 
-    descriptor += str;
-    return descriptor;
+string CodeGenerator::typeDescriptor(Typespec *LuaType)
+{
+    // Nil is an object, and a dynamic value is a tagged long.
+    if      (LuaType == Predefined::numberType)  return "I";
+    else if (LuaType == Predefined::boolType)    return "Z";
+    else if (LuaType == Predefined::stringType)  return "Ljava/lang/String;";
+    else if (LuaType == Predefined::dynamicType) return "J";
+    else                                         return "Ljava/lang/Object;";
 }
 
 string CodeGenerator::objectTypeName(Typespec *LuaType)
 {
-    string typeName;
-    bool isArray = false;
-
-    LuaType = LuaType->baseType();
-    string str;
-
-    if      (LuaType == Predefined::numberType) 	str = "java/lang/Integer";
-    else if (LuaType == Predefined::boolType) 		str = "java/lang/Boolean";
-    else if (LuaType == Predefined::stringType)  	str = "Ljava/lang/String;";
-    else 											str = "nil";
-
-    typeName += str;
-    if (isArray) typeName += ";";
-
-    return typeName;
+    if      (LuaType == Predefined::numberType) return "java/lang/Integer";
+    else if (LuaType == Predefined::boolType)   return "java/lang/Boolean";
+    else if (LuaType == Predefined::stringType) return "java/lang/String";
+    else                                        return "java/lang/Object";
 }
 
 string CodeGenerator::valueOfSignature(Typespec *type)
@@ -536,18 +680,9 @@ string CodeGenerator::valueSignature(Typespec *type)
                     : type == Predefined::stringType  	? "string"
                     :                                     "nil";
     stringstream ss;
-    ss << javaType << "." << typeName << "Value()" << typeCode;
+    ss << javaType << "/" << typeName << "Value()" << typeCode;
 
     return ss.str();
 }
 
-void CodeGenerator::increaseStack(int num_of_parameters)
-{
-	if(localStack->capacity() < num_of_parameters){
-		localStack->reset();
-		localStack->increase(num_of_parameters);
-		count = num_of_parameters;
-	}
-}
-
 }} // namespace backend::compiler
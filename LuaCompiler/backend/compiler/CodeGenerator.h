@@ -10,6 +10,8 @@
 #define COMPILER_CODEGENERATOR_H_
 
 #include <fstream>
+#include <vector>
+#include <memory>
 
 #include "LuaBaseVisitor.h"
 #include "antlr4-runtime.h"
@@ -21,7 +23,13 @@
 #include "Label.h"
 #include "Instruction.h"
 #include "LocalVariables.h"
-#include "LocalStack.h"
+#include "ObjectFile.h"
+#include "MethodCode.h"
+#include "JasminWriter.h"
+#include "ClassFileWriter.h"
+#include "PeepholeOptimizer.h"
+#include "StackAnalyzer.h"
+#include "CompilerOptions.h"
 
 namespace backend { namespace compiler {
 
@@ -36,28 +44,46 @@ class CodeGenerator
 private:
     string objectFileName;
 
+    // What open() created, which this generator frees. The generators
+    // derived from it share these without owning them.
+    unique_ptr<ObjectFile>        ownedObjectFile;
+    unique_ptr<MethodCode>        ownedMethodCode;
+    unique_ptr<StackAnalyzer>     ownedStackAnalyzer;
+    unique_ptr<JasminWriter>      ownedJasminWriter;
+    unique_ptr<ClassFileWriter>   ownedClassWriter;
+    unique_ptr<PeepholeOptimizer> ownedPeephole;
+
 protected:
-    ofstream *objectFile;
+    ObjectFile *objectFile;
+    MethodCode *methodCode;         // code of the method being generated
+    JasminWriter *jasminWriter;     // writes the code to the object file
+    ClassFileWriter *classWriter;   // assembles a class file instead, or null
+    PeepholeOptimizer *peephole;    // optimizes each method, or null
+    StackAnalyzer *stackAnalyzer;   // computes each method's .limit stack
     string programName;
-    LocalVariables *localVariables;
-    LocalStack *localStack;
+    unique_ptr<LocalVariables> localVariables;  // slots of the method
     Compiler *compiler;
-
-    static int count;
+    CompilerOptions options;        // the code generation options
+    vector<MethodCode> *deferred;   // where a routine generated on its own
+                                    // keeps its code until it is spliced,
+                                    // else null
 
 public:
     /**
      * Constructor.
      * @param programName the name of the program.
      * @param suffix the suffix for the object file name.
+     * @param options the code generation options.
      * @param compiler the compiler to use.
      */
-    CodeGenerator(string programName, string suffix, Compiler *compiler)
-        : objectFile(nullptr), programName(programName),
-          localVariables(nullptr), localStack(nullptr),
-          compiler(nullptr)
+    CodeGenerator(string programName, string suffix,
+                  const CompilerOptions& options, Compiler *compiler)
+        : objectFile(nullptr), methodCode(nullptr), jasminWriter(nullptr),
+          classWriter(nullptr), peephole(nullptr), stackAnalyzer(nullptr),
+          programName(programName),
+          compiler(nullptr), options(options), deferred(nullptr)
 	{
-    	open(programName, suffix);
+    	open(programName, suffix, options);
 	}
 
     /**
@@ -66,10 +92,33 @@ public:
      * @param compiler the compiler to use.
      */
     CodeGenerator(CodeGenerator *parent, Compiler *compiler)
-        : objectFile(parent->objectFile), programName(parent->programName),
-          localVariables(parent->localVariables),
-          localStack(parent->localStack),
-          compiler(compiler) {}
+        : objectFile(parent->objectFile), methodCode(parent->methodCode),
+          jasminWriter(parent->jasminWriter),
+          classWriter(parent->classWriter), peephole(parent->peephole),
+          stackAnalyzer(parent->stackAnalyzer),
+          programName(parent->programName),
+          compiler(compiler), options(parent->options),
+          deferred(parent->deferred) {}
+
+    /**
+     * Constructor for the base generator of a routine that is generated
+     * on its own thread. It has private method code and analyzers, and
+     * it keeps the optimized code instead of writing it.
+     * @param parent the parent code generator.
+     * @param methodCode the routine's private method code.
+     * @param stackAnalyzer the routine's private stack analyzer.
+     * @param peephole the routine's private optimizer, or null.
+     * @param deferred where to keep the routine's code.
+     */
+    CodeGenerator(CodeGenerator *parent, MethodCode *methodCode,
+                  StackAnalyzer *stackAnalyzer, PeepholeOptimizer *peephole,
+                  vector<MethodCode> *deferred)
+        : objectFile(parent->objectFile), methodCode(methodCode),
+          jasminWriter(nullptr), classWriter(nullptr), peephole(peephole),
+          stackAnalyzer(stackAnalyzer),
+          programName(parent->programName),
+          compiler(nullptr), options(parent->options),
+          deferred(deferred) {}
 
     /**
      * Get the name of the object (Java) file.
@@ -77,17 +126,67 @@ public:
      */
     string getObjectFileName() const { return objectFileName; }
 
+    /**
+     * Get the count of lines written to the object file.
+     * @return the count.
+     */
+    int getObjectFileLineCount() const { return objectFile->getLineCount(); }
+
+    /**
+     * Get the count of instructions written to the object file.
+     * @return the count.
+     */
+    int getObjectFileInstructionCount() const
+    {
+        return objectFile->getInstructionCount();
+    }
+
+    /**
+     * Get the count of bytes written to the object file.
+     * @return the count.
+     */
+    size_t getObjectFileByteCount() const
+    {
+        return objectFile->getByteCount();
+    }
+
+    /**
+     * Get the peephole optimizer.
+     * @return the optimizer, or null if optimization is off.
+     */
+    PeepholeOptimizer *getPeepholeOptimizer() const { return peephole; }
+
+    /**
+     * Get the count of stack errors in the generated methods.
+     * @return the count.
+     */
+    int getStackErrorCount() const { return stackAnalyzer->getErrorCount(); }
+
     /**
      * Open the object file.
      * @param programName the name of the program.
      * @param suffix the suffix of the object file name.
+     * @param options the code generation options.
      */
-    void open(string programName, string suffix);
+    void open(string programName, string suffix,
+              const CompilerOptions& options);
 
     /**
-     * Close the object file.
+     * Close the object file, writing any buffered code.
      */
-    void close() { objectFile->close(); }
+    void close();
+
+    /**
+     * Write the buffered code records to the object file.
+     */
+    void writeCode();
+
+    /**
+     * Write the code kept by routines that were generated on their
+     * own, after any buffered code.
+     * @param codes the routines' code, in the order to write it.
+     */
+    void splice(vector<MethodCode>& codes);
 
     /**
      * Emit a blank line.
@@ -106,6 +205,12 @@ public:
      */
     void emitComment(LuaParser::BlockContext *ctx);
 
+    /**
+     * Create a new label in the current method.
+     * @return the label.
+     */
+    Label *newLabel() { return methodCode->newLabel(); }
+
     /**
      * Emit a label.
      * @param label the label.
@@ -290,6 +395,37 @@ public:
      */
     void emitReturnValue(Typespec *type);
 
+    /**
+     * Emit a load of the value that a variable has before it is
+     * assigned: nil, or zero or false if the variable is an int.
+     * @param type the variable's data type.
+     */
+    void emitLoadDefault(Typespec *type);
+
+    /**
+     * Emit code to discard the value on top of the operand stack.
+     * @param type the type of the value, or null for nil.
+     */
+    void emitPop(Typespec *type);
+
+    /**
+     * Emit code to convert the value on top of the operand stack
+     * from one type's representation to another's. A number or a
+     * boolean is an int, a string is a String, nil is a null Object,
+     * and a dynamic value is a tagged long of the LuaValue runtime.
+     * @param fromType the type of the value, or null for nil.
+     * @param toType the type to convert to, or null for nil.
+     */
+    void emitConvert(Typespec *fromType, Typespec *toType);
+
+    /**
+     * Emit code to replace the value on top of the operand stack
+     * with 1 if it is true in Lua, that is, neither nil nor false,
+     * else with 0.
+     * @param type the type of the value, or null for nil.
+     */
+    void emitTruth(Typespec *type);
+
     /**
      * Emit code to perform a runtime range check before an assignment.
      * @param targetType the type of the assignment target.
@@ -300,6 +436,21 @@ public:
     // Utilities
     // =========
 
+    /**
+     * Determine whether values of a type are JVM ints.
+     * @param type the data type.
+     * @return true if a number or a boolean, else false.
+     */
+    static bool isPrimitive(Typespec *type);
+
+    /**
+     * Determine whether values of a type are tagged JVM longs,
+     * which take two slots and two operand stack words.
+     * @param type the data type.
+     * @return true if dynamic, else false.
+     */
+    static bool isTagged(Typespec *type);
+
     /**
      * Emit a type descriptor of an identifier's type.
      * @param id the symbol table entry of an identifier.
@@ -335,8 +486,6 @@ public:
      */
     string valueSignature(Typespec *type);
 
-    void increaseStack(int num_of_parameters);
-
 private:
     /**
      * Emit code to store a value to an ummodified target variable,
@@ -345,6 +494,12 @@ private:
      */
     void emitStoreToUnmodifiedVariable(SymtabEntry *targetId,
                                        Typespec *targetType);
+
+    /**
+     * Write optimized method code to the object file.
+     * @param code the method code.
+     */
+    void write(const MethodCode& code);
 };
 
 }} // namespace backend::compiler
@@ -1,12 +1,13 @@
 #ifndef COMPILER_H_
 #define COMPILER_H_
 
-#include "LuaBaseVisitor.h"
-#include "antlr4-runtime.h"
+#include <memory>
 
 #include "intermediate/symtab/SymtabStack.h"
 #include "intermediate/symtab/SymtabEntry.h"
 #include "intermediate/type/Typespec.h"
+#include "intermediate/ast/ExpNode.h"
+#include "intermediate/ast/StatNode.h"
 #include "ProgramGenerator.h"
 #include "StatementGenerator.h"
 #include "ExpressionGenerator.h"
@@ -16,10 +17,14 @@ namespace backend { namespace compiler {
 using namespace std;
 using namespace intermediate::symtab;
 using namespace intermediate::type;
+using namespace intermediate::ast;
 
 class CodeGenerator;
 
-class Compiler : public LuaBaseVisitor
+/**
+ * Compile the lowered nodes of a program. It reads no parse tree.
+ */
+class Compiler
 {
 private:
     SymtabEntry *programId;  // symbol table entry of the program name
@@ -30,16 +35,28 @@ private:
     StatementGenerator  *statementCode;   // statement code generator
     ExpressionGenerator *expressionCode;  // expression code generator
 
+    // The generators that this compiler created, which it frees.
+    // A child compiler shares its parent's base and program generators.
+    unique_ptr<CodeGenerator>       ownedCode;
+    unique_ptr<ProgramGenerator>    ownedProgramCode;
+    unique_ptr<StatementGenerator>  ownedStatementCode;
+    unique_ptr<ExpressionGenerator> ownedExpressionCode;
+
 public:
     /**
      * Constructor for the base compiler.
      * @param programId the symtab entry for the program name.
+     * @param options the code generation options.
      */
-    Compiler(SymtabEntry *programId)
+    Compiler(SymtabEntry *programId,
+             const CompilerOptions& options = CompilerOptions())
         : programId(programId), programName(programId->getName()),
-          code(new CodeGenerator(programName, "j", this)),
+          code(new CodeGenerator(programName,
+                                 options.emit == EmitFormat::CLASS ? "class"
+                                                                   : "j",
+                                 options, this)),
           programCode(nullptr), statementCode(nullptr),
-          expressionCode(nullptr) {}
+          expressionCode(nullptr), ownedCode(code) {}
 
     /**
      * Constructor for child compilers of procedures and functions.
@@ -50,29 +67,95 @@ public:
           code(parent->code), programCode(parent->programCode),
           statementCode(nullptr), expressionCode(nullptr) {}
 
+    /**
+     * Constructor for compilers of routines that are generated
+     * on their own threads.
+     * @param parent the parent compiler.
+     * @param code the routine's base code generator.
+     */
+    Compiler(Compiler *parent, CodeGenerator *code)
+        : programId(parent->programId), programName(parent->programName),
+          code(code), programCode(nullptr),
+          statementCode(nullptr), expressionCode(nullptr) {}
+
     /**
      * Get the name of the object (Jasmin) file.
      * @return the file name.
      */
     string getObjectFileName() { return code->getObjectFileName(); }
-	Object visitChunk(LuaParser::ChunkContext *ctx) override;
-	Object visitBlock(LuaParser::BlockContext *ctx) override;
-	Object visitStat(LuaParser::StatContext *ctx) override;
-	Object visitRetstat(LuaParser::RetstatContext *ctx) override;
-	Object visitAssignStat(LuaParser::AssignStatContext *ctx) override;
-	Object visitRepeatStat(LuaParser::RepeatStatContext *ctx) override;
-	Object visitPrintStat(LuaParser::PrintStatContext *ctx) override;
-	Object visitIfStat(LuaParser::IfStatContext *ctx) override;
-	Object visitExplist(LuaParser::ExplistContext *ctx) override;
-	Object visitExp(LuaParser::ExpContext *ctx) override;
-	Object visitPrefixexp(LuaParser::PrefixexpContext *ctx) override;
-	Object visitFunctioncall(LuaParser::FunctioncallContext *ctx) override;
-	Object visitVarOrExp(LuaParser::VarOrExpContext *ctx) override;
-	Object visitVar_(LuaParser::Var_Context *ctx) override;
-	Object visitNameAndArgs(LuaParser::NameAndArgsContext *ctx) override;
-	Object visitParlist(LuaParser::ParlistContext *ctx) override;
-	Object visitNumber(LuaParser::NumberContext *ctx) override;
-	Object visitString(LuaParser::StringContext *ctx) override;
+
+    /**
+     * Get the count of lines written to the object file.
+     * @return the count.
+     */
+    int getObjectFileLineCount() { return code->getObjectFileLineCount(); }
+
+    /**
+     * Get the count of instructions written to the object file.
+     * @return the count.
+     */
+    int getObjectFileInstructionCount()
+    {
+        return code->getObjectFileInstructionCount();
+    }
+
+    /**
+     * Get the count of bytes written to the object file.
+     * @return the count.
+     */
+    size_t getObjectFileByteCount() { return code->getObjectFileByteCount(); }
+
+    /**
+     * Get the peephole optimizer.
+     * @return the optimizer, or null if optimization is off.
+     */
+    PeepholeOptimizer *getPeepholeOptimizer()
+    {
+        return code->getPeepholeOptimizer();
+    }
+
+    /**
+     * Get the count of stack errors in the generated methods.
+     * @return the count.
+     */
+    int getStackErrorCount() { return code->getStackErrorCount(); }
+
+    /**
+     * Generate the program.
+     * @param program the program node.
+     */
+    void compileProgram(const ProgramNode *program);
+
+    /**
+     * Generate a routine with this compiler's own generators.
+     * @param routine the routine node.
+     */
+    void compileRoutine(const RoutineNode *routine);
+
+    /**
+     * Generate the statements of a block.
+     * @param block the first statement node, or null.
+     */
+    void compileBlock(const StatNode *block);
+
+    /**
+     * Generate a statement.
+     * @param stat the statement node.
+     */
+    void compileStatement(const StatNode *stat);
+
+    /**
+     * Generate an expression.
+     * @param node the expression node.
+     */
+    void compileExpression(const ExpNode *node);
+
+    /**
+     * Generate a function call, which leaves its result on the stack.
+     * @param node the call node.
+     */
+    void compileCall(const ExpNode *node);
+
 private:
     /**
      * Create new child code generators.
@@ -83,6 +166,10 @@ private:
         programCode    = new ProgramGenerator(parentGenerator, this, programId);
         statementCode  = new StatementGenerator(programCode, this);
         expressionCode = new ExpressionGenerator(programCode, this);
+
+        ownedProgramCode.reset(programCode);
+        ownedStatementCode.reset(statementCode);
+        ownedExpressionCode.reset(expressionCode);
     }
 };
 
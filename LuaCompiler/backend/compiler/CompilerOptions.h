@@ -0,0 +1,55 @@
+/**
+ * <h1>CompilerOptions</h1>
+ *
+ * <p>Command-line settings that control code generation.</p>
+ */
+#ifndef COMPILEROPTIONS_H_
+#define COMPILEROPTIONS_H_
+
+#include <cstddef>
+
+namespace backend { namespace compiler {
+
+/**
+ * The form of the object file.
+ */
+enum class EmitFormat
+{
+    JASMIN,  // Jasmin assembly text (.j)
+    CLASS    // JVM class file (.class)
+};
+
+/**
+ * How a generated program times itself.
+ */
+enum class RuntimeTiming
+{
+    OFF,  // no timing code
+    MS,   // print the execution time in milliseconds at exit
+    NS    // print the execution time in nanoseconds at exit, and
+          // the call count and time of each function
+};
+
+class CompilerOptions
+{
+public:
+    bool syncOutput;          // true to flush the object file after every line
+    size_t outputBufferSize;  // object file buffer size in bytes,
+                              // or 0 to write the file once at close
+    bool peephole;            // true to run the peephole optimizer
+    EmitFormat emit;          // the form of the object file
+    int routineJobs;          // worker threads that generate the routines
+    RuntimeTiming timing;     // the timing code in the generated program
+
+    /**
+     * Constructor.
+     */
+    CompilerOptions()
+        : syncOutput(false), outputBufferSize(64*1024), peephole(true),
+          emit(EmitFormat::JASMIN), routineJobs(1),
+          timing(RuntimeTiming::OFF) {}
+};
+
+}}  // namespace backend::compiler
+
+#endif /* COMPILEROPTIONS_H_ */
@@ -0,0 +1,147 @@
+/**
+ * <h1>ConstantPool</h1>
+ *
+ * <p>The constant pool of a generated class file. Each distinct
+ * constant is entered only once.</p>
+ */
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+
+#include "ConstantPool.h"
+
+namespace backend { namespace compiler {
+
+using namespace std;
+
+// Constant pool tags.
+static const int CONSTANT_UTF8         = 1;
+static const int CONSTANT_INTEGER      = 3;
+static const int CONSTANT_FLOAT        = 4;
+static const int CONSTANT_CLASS        = 7;
+static const int CONSTANT_STRING       = 8;
+static const int CONSTANT_FIELDREF     = 9;
+static const int CONSTANT_METHODREF    = 10;
+static const int CONSTANT_NAMEANDTYPE  = 12;
+
+int ConstantPool::utf8(const string& text)
+{
+    // Modified UTF-8: the null character takes two bytes.
+    ByteBuffer bytes;
+    for (char ch : text)
+    {
+        if (ch == '\0')
+        {
+            bytes.putU1(0xC0);
+            bytes.putU1(0x80);
+        }
+        else bytes.putU1(ch);
+    }
+
+    if (bytes.size() > 0xFFFF)
+    {
+        cout << "ERROR: Constant is too long for a class file." << endl;
+        exit(-1);
+    }
+
+    ByteBuffer entry;
+    entry.putU1(CONSTANT_UTF8);
+    entry.putU2(bytes.size());
+    entry.putBytes(bytes);
+
+    return enter(string(1, CONSTANT_UTF8) + text, entry);
+}
+
+int ConstantPool::integer(int value)
+{
+    ByteBuffer entry;
+    entry.putU1(CONSTANT_INTEGER);
+    entry.putU4(value);
+
+    return enter(string(1, CONSTANT_INTEGER) + to_string(value), entry);
+}
+
+int ConstantPool::real(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    ByteBuffer entry;
+    entry.putU1(CONSTANT_FLOAT);
+    entry.putU4(bits);
+
+    return enter(string(1, CONSTANT_FLOAT) + to_string(bits), entry);
+}
+
+int ConstantPool::stringConstant(const string& text)
+{
+    ByteBuffer entry;
+    entry.putU1(CONSTANT_STRING);
+    entry.putU2(utf8(text));
+
+    return enter(string(1, CONSTANT_STRING) + text, entry);
+}
+
+int ConstantPool::classRef(const string& name)
+{
+    ByteBuffer entry;
+    entry.putU1(CONSTANT_CLASS);
+    entry.putU2(utf8(name));
+
+    return enter(string(1, CONSTANT_CLASS) + name, entry);
+}
+
+int ConstantPool::nameAndType(const string& name, const string& descriptor)
+{
+    ByteBuffer entry;
+    entry.putU1(CONSTANT_NAMEANDTYPE);
+    entry.putU2(utf8(name));
+    entry.putU2(utf8(descriptor));
+
+    return enter(string(1, CONSTANT_NAMEANDTYPE) + name + " " + descriptor,
+                 entry);
+}
+
+int ConstantPool::fieldRef(const string& owner, const string& name,
+                           const string& descriptor)
+{
+    ByteBuffer entry;
+    entry.putU1(CONSTANT_FIELDREF);
+    entry.putU2(classRef(owner));
+    entry.putU2(nameAndType(name, descriptor));
+
+    return enter(string(1, CONSTANT_FIELDREF)
+                     + owner + "." + name + " " + descriptor,
+                 entry);
+}
+
+int ConstantPool::methodRef(const string& owner, const string& name,
+                            const string& descriptor)
+{
+    ByteBuffer entry;
+    entry.putU1(CONSTANT_METHODREF);
+    entry.putU2(classRef(owner));
+    entry.putU2(nameAndType(name, descriptor));
+
+    return enter(string(1, CONSTANT_METHODREF) + owner + "." + name + descriptor,
+                 entry);
+}
+
+int ConstantPool::enter(const string& key, const ByteBuffer& entry)
+{
+    auto it = indexes.find(key);
+    if (it != indexes.end()) return it->second;
+
+    if (count > 0xFFFF)
+    {
+        cout << "ERROR: Too many constants for a class file." << endl;
+        exit(-1);
+    }
+
+    entries.putBytes(entry);
+    indexes[key] = count;
+
+    return count++;
+}
+
+}} // namespace backend::compiler
@@ -0,0 +1,120 @@
+/**
+ * <h1>ConstantPool</h1>
+ *
+ * <p>The constant pool of a generated class file. Each distinct
+ * constant is entered only once.</p>
+ */
+#ifndef CONSTANTPOOL_H_
+#define CONSTANTPOOL_H_
+
+#include <string>
+#include <map>
+
+#include "ByteBuffer.h"
+
+namespace backend { namespace compiler {
+
+using namespace std;
+
+class ConstantPool
+{
+private:
+    ByteBuffer entries;        // the encoded entries
+    int count;                 // index of the next entry
+    map<string, int> indexes;  // index of each entry by its key
+
+public:
+    /**
+     * Constructor.
+     */
+    ConstantPool() : count(1) {}
+
+    /**
+     * Get the constant pool count of the class file,
+     * which is one more than the index of the last entry.
+     * @return the count.
+     */
+    int getCount() const { return count; }
+
+    /**
+     * Write the encoded entries.
+     * @param out the buffer to write to.
+     */
+    void write(ByteBuffer& out) const { out.putBytes(entries); }
+
+    /**
+     * Enter a CONSTANT_Utf8 entry.
+     * @param text the text.
+     * @return the entry's index.
+     */
+    int utf8(const string& text);
+
+    /**
+     * Enter a CONSTANT_Integer entry.
+     * @param value the value.
+     * @return the entry's index.
+     */
+    int integer(int value);
+
+    /**
+     * Enter a CONSTANT_Float entry.
+     * @param value the value.
+     * @return the entry's index.
+     */
+    int real(float value);
+
+    /**
+     * Enter a CONSTANT_String entry.
+     * @param text the string value.
+     * @return the entry's index.
+     */
+    int stringConstant(const string& text);
+
+    /**
+     * Enter a CONSTANT_Class entry.
+     * @param name the internal class name, such as java/lang/Object.
+     * @return the entry's index.
+     */
+    int classRef(const string& name);
+
+    /**
+     * Enter a CONSTANT_NameAndType entry.
+     * @param name the member name.
+     * @param descriptor the member type descriptor.
+     * @return the entry's index.
+     */
+    int nameAndType(const string& name, const string& descriptor);
+
+    /**
+     * Enter a CONSTANT_Fieldref entry.
+     * @param owner the internal name of the field's class.
+     * @param name the field name.
+     * @param descriptor the field type descriptor.
+     * @return the entry's index.
+     */
+    int fieldRef(const string& owner, const string& name,
+                 const string& descriptor);
+
+    /**
+     * Enter a CONSTANT_Methodref entry.
+     * @param owner the internal name of the method's class.
+     * @param name the method name.
+     * @param descriptor the method descriptor.
+     * @return the entry's index.
+     */
+    int methodRef(const string& owner, const string& name,
+                  const string& descriptor);
+
+private:
+    /**
+     * Enter an entry unless an equal one already exists.
+     * @param key the key that identifies the entry.
+     * @param entry the encoded entry.
+     * @return the entry's index.
+     */
+    int enter(const string& key, const ByteBuffer& entry);
+};
+
+}}  // namespace backend::compiler
+
+#endif /* CONSTANTPOOL_H_ */
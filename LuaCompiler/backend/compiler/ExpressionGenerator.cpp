@@ -9,77 +9,172 @@
 
 namespace backend { namespace compiler {
 
-void ExpressionGenerator::emitExpression(LuaParser::ExpContext *ctx)
+void ExpressionGenerator::emitExpression(const ExpNode *node)
 {
-    // More than one expression?
-    if (ctx->children.size() > 1)
+    switch (node->kind)
     {
-        string op = "";
-        if (ctx->operatorComparison() != nullptr){
-        	emitComment(ctx->getText());
-        	Label *trueLabel = new Label();
-			Label *exitLabel = new Label();
-			op = ctx->operatorComparison()->getText();
-			compiler->visit(ctx->exp(0)); // LHS expression
-			compiler->visit(ctx->exp(1)); // RHS expression
-
-			if      (op == "==" ) emit(IF_ICMPEQ, trueLabel);
-			else if (op == "~=")  emit(IF_ICMPNE, trueLabel);
-			else if (op == "<" )  emit(IF_ICMPLT, trueLabel);
-			else if (op == "<=")  emit(IF_ICMPLE, trueLabel);
-			else if (op == ">" )  emit(IF_ICMPGT, trueLabel);
-			else if (op == ">=")  emit(IF_ICMPGE, trueLabel);
-
-			emit(ICONST_0); // false
-			emit(GOTO, exitLabel);
-			emitLabel(trueLabel);
-			emit(ICONST_1); // true
-			emitLabel(exitLabel);
-
-			localStack->decrease(1);  // only one branch will be taken
-
-        } else if (ctx->operatorAddSub() != nullptr){
-        	op = ctx->operatorAddSub()->getText();
-        	compiler->visit(ctx->exp(0)); // LHS expression
-        	compiler->visit(ctx->exp(1)); // RHS expression
-
-        	if (op == "+")
-        		emit(IADD);
-        	else if (op == "-")
-        		emit(ISUB);
-
-        } else if (ctx->operatorMulDiv() != nullptr){
-        	op = ctx->operatorMulDiv()->getText();
-        	compiler->visit(ctx->exp(0)); // LHS expression
-        	compiler->visit(ctx->exp(1)); // RHS expression
-
-        	if (op == "*")
-        		emit(IMUL);
-        	else if (op == "/")
-        		emit(IDIV);
-        }
+        case ExpKind::NUMBER:
+            emitLoadConstant(node->value);
+            break;
+
+        case ExpKind::STRING:
+            emitLoadConstant(convertString(*node->text, true));
+            break;
+
+        case ExpKind::NIL:
+            emit(ACONST_NULL);
+            break;
+
+        case ExpKind::BOOLEAN:
+            emitLoadConstant(node->value);
+            break;
+
+        // Where the value is known to have a narrower type
+        // than the variable, it is converted to it.
+        case ExpKind::VARIABLE:
+            emitLoadValue(node->entry);
+            emitConvert(node->entry->getType(), node->type);
+            break;
+
+        case ExpKind::CALL:
+            compiler->compileCall(node);
+            break;
+
+        case ExpKind::BINARY:
+            emitBinary(node);
+            break;
+
+        // x*2 or 2*x: evaluate x only once and add it to itself.
+        case ExpKind::DOUBLE:
+            emitExpression(node->left, Predefined::numberType);
+            emit(DUP);
+            emit(IADD);
+            break;
+
+        case ExpKind::OTHER:
+            for (const ExpNode *operand = node->left; operand != nullptr;
+                 operand = operand->next)
+            {
+                emitExpression(operand);
+            }
+            break;
+    }
+}
 
+void ExpressionGenerator::emitExpression(const ExpNode *node, Typespec *type)
+{
+    emitExpression(node);
+    emitConvert(node->type, type);
+}
 
-    } else {
-    	compiler->visitChildren(ctx);
+void ExpressionGenerator::emitBinary(const ExpNode *node)
+{
+    if (node->isComparison()) emitComparison(node);
+    else
+    {
+        // Arithmetic is on ints.
+        emitExpression(node->left,  Predefined::numberType);  // LHS expression
+        emitExpression(node->right, Predefined::numberType);  // RHS expression
+
+        switch (node->op)
+        {
+            case ExpOperator::ADD: emit(IADD); break;
+            case ExpOperator::SUB: emit(ISUB); break;
+            case ExpOperator::MUL: emit(IMUL); break;
+            default:               emit(IDIV); break;
+        }
     }
 }
 
-Typespec *ExpressionGenerator::emitLoadVariable(LuaParser::Var_Context *varCtx)
+void ExpressionGenerator::emitComparison(const ExpNode *node)
 {
-    SymtabEntry *variableId = varCtx->entry;
-    Typespec *variableType = Predefined::numberType;
+    Label *trueLabel = newLabel();
+    Label *exitLabel = newLabel();
+    Typespec *leftType  = node->left->type;
+    Typespec *rightType = node->right->type;
+    bool equality =    (node->op == ExpOperator::EQ)
+                    || (node->op == ExpOperator::NE);
+    bool tagged = isTagged(leftType) || isTagged(rightType);
+
+    // Two numbers, or two booleans tested for equality, are ints.
+    if (   (   (leftType == Predefined::numberType)
+            && (rightType == Predefined::numberType))
+        || (   equality
+            && (leftType == Predefined::boolType)
+            && (rightType == Predefined::boolType)))
+    {
+        emitExpression(node->left);   // LHS expression
+        emitExpression(node->right);  // RHS expression
+
+        switch (node->op)
+        {
+            case ExpOperator::EQ: emit(IF_ICMPEQ, trueLabel); break;
+            case ExpOperator::NE: emit(IF_ICMPNE, trueLabel); break;
+            case ExpOperator::LT: emit(IF_ICMPLT, trueLabel); break;
+            case ExpOperator::LE: emit(IF_ICMPLE, trueLabel); break;
+            case ExpOperator::GT: emit(IF_ICMPGT, trueLabel); break;
+            default:              emit(IF_ICMPGE, trueLabel); break;
+        }
+    }
 
-    // Scalar value or structure address.
-    CodeGenerator::emitLoadValue(variableId);
+    // Values of any other types are equal if they are the same
+    // type and value. The runtime compares dynamic values by their
+    // tagged bits, and equals() compares the objects of the others.
+    else if (equality)
+    {
+        if (tagged)
+        {
+            emitExpression(node->left,  Predefined::dynamicType);
+            emitExpression(node->right, Predefined::dynamicType);
+            emit(INVOKESTATIC, "LuaValue/equal(JJ)Z");
+        }
+        else
+        {
+            // As objects, which is how nil is represented.
+            emitExpression(node->left,  Predefined::nilType);
+            emitExpression(node->right, Predefined::nilType);
+            emit(INVOKESTATIC, "java/util/Objects/equals(Ljava/lang/Object;"
+                               "Ljava/lang/Object;)Z");
+        }
 
-    return variableType;
-}
+        emit(node->op == ExpOperator::EQ ? IFNE : IFEQ, trueLabel);
+    }
 
-void ExpressionGenerator::emitLoadIntegerConstant(LuaParser::NumberContext *intCtx)
-{
-    int value = stoi(intCtx->getText());
-    emitLoadConstant(value);
+    // Two strings are ordered by their characters.
+    else if (   (leftType == Predefined::stringType)
+             && (rightType == Predefined::stringType))
+    {
+        emitExpression(node->left);   // LHS expression
+        emitExpression(node->right);  // RHS expression
+        emit(INVOKEVIRTUAL, "java/lang/String/compareTo(Ljava/lang/String;)I");
+        emit(node->op == ExpOperator::LT ? IFLT
+           : node->op == ExpOperator::LE ? IFLE
+           : node->op == ExpOperator::GT ? IFGT
+           :                               IFGE, trueLabel);
+    }
+
+    // The runtime orders dynamic values by their types at run time,
+    // with every ordering of NaN false, as in Lua. It also orders the
+    // values of any other pair of static types, such as a string and a
+    // number, which Lua does not convert to compare: it raises the
+    // same "attempt to compare" error as Lua.
+    else
+    {
+        emitExpression(node->left,  Predefined::dynamicType);
+        emitExpression(node->right, Predefined::dynamicType);
+        emit(INVOKESTATIC,
+             node->op == ExpOperator::LT ? "LuaValue/lessThan(JJ)Z"
+           : node->op == ExpOperator::LE ? "LuaValue/lessEqual(JJ)Z"
+           : node->op == ExpOperator::GT ? "LuaValue/greaterThan(JJ)Z"
+           :                               "LuaValue/greaterEqual(JJ)Z");
+        emit(IFNE, trueLabel);
+    }
+
+    emit(ICONST_0); // false
+    emit(GOTO, exitLabel);
+    emitLabel(trueLabel);
+    emit(ICONST_1); // true
+    emitLabel(exitLabel);
 }
 
 }} // namespace backend::compiler
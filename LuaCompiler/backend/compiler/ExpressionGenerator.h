@@ -3,9 +3,12 @@
 
 #include "CodeGenerator.h"
 #include "LuaBaseVisitor.h"
+#include "intermediate/ast/ExpNode.h"
 
 namespace backend { namespace compiler {
 
+using namespace intermediate::ast;
+
 class ExpressionGenerator : public CodeGenerator
 {
 public:
@@ -18,26 +21,30 @@ public:
         : CodeGenerator(parent, compiler) {}
 
     /**
-     * Emit code for an expression.
-     * @param ctx the ExpressionContext.
+     * Emit code for a lowered expression.
+     * @param node the expression node.
      */
-    void emitExpression(LuaParser::ExpContext *ctx);
+    void emitExpression(const ExpNode *node);
 
     /**
-     * Emit code to load a scalar variable's value
-     * or a structured variable's address.
-     * @param variableNode the variable node.
+     * Emit code for a lowered expression and convert its value.
+     * @param node the expression node.
+     * @param type the type to convert the value to.
      */
-    Typespec *emitLoadVariable(LuaParser::Var_Context *varCtx);
+    void emitExpression(const ExpNode *node, Typespec *type);
 
+private:
     /**
-     * Emit code to load an integer constant.
-     * @parm intCtx the IntegerConstantContext.
+     * Emit code for a binary operator expression.
+     * @param node the expression node.
      */
-    void emitLoadIntegerConstant(LuaParser::NumberContext *intCtx);
-
-private:
+    void emitBinary(const ExpNode *node);
 
+    /**
+     * Emit code for a comparison expression.
+     * @param node the expression node.
+     */
+    void emitComparison(const ExpNode *node);
 };
 
 }} // namespace backend::compiler
@@ -0,0 +1,622 @@
+/**
+ * <h1>FrameAnalyzer</h1>
+ *
+ * <p>Infer the types of the local variables and the operand stack at
+ * each branch target of a method, for the StackMapTable attribute
+ * that the JVM's type-checking verifier requires.</p>
+ */
+#include "FrameAnalyzer.h"
+
+namespace backend { namespace compiler {
+
+using namespace std;
+
+typedef VerificationType VT;
+
+/**
+ * Get the slot number of a short-form load or store instruction.
+ * @param instruction the instruction, such as ILOAD_2.
+ * @param first the instruction for slot 0, such as ILOAD_0.
+ * @return the slot number.
+ */
+static int slotOf(Instruction instruction, Instruction first)
+{
+    return static_cast<int>(instruction) - static_cast<int>(first);
+}
+
+map<int, Frame> FrameAnalyzer::analyze(const string& methodName,
+                                       const string& descriptor,
+                                       bool isStatic, int maxLocals)
+{
+    positions.clear();
+    frames.clear();
+
+    for (size_t i = 0; i < body.size(); i++)
+    {
+        if (body[i]->kind == RecordKind::LABEL) positions[body[i]->label] = i;
+    }
+
+    // The entry frame holds the receiver and the parameters.
+    Frame entry;
+    entry.locals.assign(maxLocals, VT());
+    int slot = 0;
+
+    if (!isStatic)
+    {
+        entry.locals[slot++] = methodName == "<init>"
+                                    ? VT(VT::UNINITIALIZED_THIS)
+                                    : VT(VT::OBJECT, className);
+    }
+
+    size_t position = 1;
+    while ((position < descriptor.size()) && (descriptor[position] != ')'))
+    {
+        VT type = typeOf(descriptor, position);
+        if (slot < maxLocals) store(entry, slot, type);
+        slot += type.isWide() ? 2 : 1;
+    }
+
+    // If the method begins with a label, the entry frame
+    // is one of the frames merged there.
+    vector<size_t> worklist;
+    if (!body.empty() && (body[0]->kind == RecordKind::LABEL))
+    {
+        merge(body[0]->label, entry, worklist);
+    }
+    else follow(0, entry, worklist);
+
+    while (!worklist.empty())
+    {
+        size_t start = worklist.back();
+        worklist.pop_back();
+
+        follow(start, frames[start], worklist);
+    }
+
+    // Where several labels share an offset, the last one
+    // has the merged frame of all of them.
+    map<int, Frame> result;
+    for (auto& labelFrame : frames)
+    {
+        result[offsets[labelFrame.first]] = labelFrame.second;
+    }
+
+    return result;
+}
+
+void FrameAnalyzer::follow(size_t start, Frame frame, vector<size_t>& worklist)
+{
+    for (size_t i = start; i < body.size(); i++)
+    {
+        const CodeRecord& record = *body[i];
+
+        // Falling through into a label: continue from there
+        // only if its frame changed.
+        if (record.kind == RecordKind::LABEL)
+        {
+            if (i == start) continue;
+
+            merge(record.label, frame, worklist);
+            return;
+        }
+
+        if (!record.isInstruction()) continue;
+
+        execute(frame, record, offsets[i]);
+
+        if (record.is(LOOKUPSWITCH))
+        {
+            for (size_t j = i + 1; j < body.size(); j++)
+            {
+                const CodeRecord& entry = *body[j];
+
+                if (   (entry.kind == RecordKind::CASE)
+                    || (entry.kind == RecordKind::SWITCH_LABEL)
+                    || (entry.kind == RecordKind::DEFAULT_CASE))
+                {
+                    merge(entry.label, frame, worklist);
+                }
+
+                if (entry.kind == RecordKind::DEFAULT_CASE) break;
+            }
+
+            return;
+        }
+
+        if (record.form == OperandForm::LABEL)
+        {
+            merge(record.label, frame, worklist);
+        }
+
+        if (   record.is(GOTO)    || record.is(RETURN)
+            || record.is(IRETURN) || record.is(FRETURN)
+            || record.is(ARETURN) || record.is(LRETURN))
+        {
+            return;
+        }
+    }
+}
+
+void FrameAnalyzer::merge(Label *label, const Frame& frame,
+                          vector<size_t>& worklist)
+{
+    auto it = positions.find(label);
+    if (it == positions.end()) return;  // reported by the StackAnalyzer
+
+    size_t index = it->second;
+    auto existing = frames.find(index);
+
+    if (existing == frames.end())
+    {
+        frames[index] = frame;
+        worklist.push_back(index);
+        return;
+    }
+
+    Frame& target = existing->second;
+    bool changed = false;
+
+    for (size_t i = 0; i < target.locals.size(); i++)
+    {
+        VT merged = i < frame.locals.size()
+                        ? mergeTypes(target.locals[i], frame.locals[i])
+                        : VT();
+        if (merged != target.locals[i])
+        {
+            target.locals[i] = merged;
+            changed = true;
+        }
+    }
+
+    // Stack depths that differ are reported by the StackAnalyzer.
+    for (size_t i = 0; (i < target.stack.size()) && (i < frame.stack.size());
+         i++)
+    {
+        VT merged = mergeTypes(target.stack[i], frame.stack[i]);
+        if (merged != target.stack[i])
+        {
+            target.stack[i] = merged;
+            changed = true;
+        }
+    }
+
+    if (changed) worklist.push_back(index);
+}
+
+void FrameAnalyzer::execute(Frame& frame, const CodeRecord& record,
+                            int offset)
+{
+    vector<VT>& stack = frame.stack;
+    Instruction instruction = record.instruction;
+
+    switch (instruction)
+    {
+        // Load constant
+        case Instruction::ICONST_0: case Instruction::ICONST_1:
+        case Instruction::ICONST_2: case Instruction::ICONST_3:
+        case Instruction::ICONST_4: case Instruction::ICONST_5:
+        case Instruction::ICONST_M1:
+        case Instruction::BIPUSH:   case Instruction::SIPUSH:
+            stack.push_back(VT(VT::INTEGER));
+            break;
+
+        case Instruction::FCONST_0: case Instruction::FCONST_1:
+        case Instruction::FCONST_2:
+            stack.push_back(VT(VT::FLOAT));
+            break;
+
+        case Instruction::ACONST_NULL:
+            stack.push_back(VT(VT::NULL_TYPE));
+            break;
+
+        case Instruction::LDC:
+            if (record.form == OperandForm::INTEGER)
+            {
+                stack.push_back(VT(VT::INTEGER));
+            }
+            else if (record.form == OperandForm::REAL)
+            {
+                stack.push_back(VT(VT::FLOAT));
+            }
+            else if (code.getText(record.operands[0])[0] == '"')
+            {
+                stack.push_back(VT(VT::OBJECT, "java/lang/String"));
+            }
+            else stack.push_back(VT(VT::OBJECT, "java/lang/Class"));
+            break;
+
+        // Load value or address
+        case Instruction::ILOAD_0: case Instruction::ILOAD_1:
+        case Instruction::ILOAD_2: case Instruction::ILOAD_3:
+        case Instruction::ILOAD:
+            stack.push_back(VT(VT::INTEGER));
+            break;
+
+        case Instruction::FLOAD_0: case Instruction::FLOAD_1:
+        case Instruction::FLOAD_2: case Instruction::FLOAD_3:
+        case Instruction::FLOAD:
+            stack.push_back(VT(VT::FLOAT));
+            break;
+
+        case Instruction::LLOAD_0: case Instruction::LLOAD_1:
+        case Instruction::LLOAD_2: case Instruction::LLOAD_3:
+        case Instruction::LLOAD:
+            stack.push_back(VT(VT::LONG));
+            break;
+
+        case Instruction::ALOAD_0: case Instruction::ALOAD_1:
+        case Instruction::ALOAD_2: case Instruction::ALOAD_3:
+            stack.push_back(load(frame, slotOf(instruction, ALOAD_0)));
+            break;
+
+        case Instruction::ALOAD:
+            stack.push_back(load(frame, record.operands[0]));
+            break;
+
+        case Instruction::GETSTATIC:
+        case Instruction::GETFIELD:
+        {
+            string text = operandText(record);
+            size_t position = text.rfind(' ') + 1;
+
+            if (record.is(GETFIELD)) pop(frame);
+            stack.push_back(typeOf(text, position));
+            break;
+        }
+
+        // Store value or address
+        case Instruction::ISTORE_0: case Instruction::ISTORE_1:
+        case Instruction::ISTORE_2: case Instruction::ISTORE_3:
+            store(frame, slotOf(instruction, ISTORE_0), pop(frame));
+            break;
+
+        case Instruction::FSTORE_0: case Instruction::FSTORE_1:
+        case Instruction::FSTORE_2: case Instruction::FSTORE_3:
+            store(frame, slotOf(instruction, FSTORE_0), pop(frame));
+            break;
+
+        case Instruction::ASTORE_0: case Instruction::ASTORE_1:
+        case Instruction::ASTORE_2: case Instruction::ASTORE_3:
+            store(frame, slotOf(instruction, ASTORE_0), pop(frame));
+            break;
+
+        case Instruction::LSTORE_0: case Instruction::LSTORE_1:
+        case Instruction::LSTORE_2: case Instruction::LSTORE_3:
+            store(frame, slotOf(instruction, LSTORE_0), pop(frame));
+            break;
+
+        case Instruction::ISTORE: case Instruction::FSTORE:
+        case Instruction::ASTORE: case Instruction::LSTORE:
+            store(frame, record.operands[0], pop(frame));
+            break;
+
+        case Instruction::PUTSTATIC: pop(frame, 1); break;
+        case Instruction::PUTFIELD:  pop(frame, 2); break;
+
+        // Operand stack
+        case Instruction::POP: pop(frame, 1); break;
+
+        // Each stack entry is one value, so a long or double
+        // is two words by itself.
+        case Instruction::POP2:
+            if (!stack.empty() && stack.back().isWide()) pop(frame, 1);
+            else                                         pop(frame, 2);
+            break;
+
+        case Instruction::SWAP:
+        {
+            VT a = pop(frame), b = pop(frame);
+            stack.push_back(a);
+            stack.push_back(b);
+            break;
+        }
+
+        case Instruction::DUP:
+            if (!stack.empty()) stack.push_back(stack.back());
+            break;
+
+        case Instruction::DUP_X1:
+        {
+            VT a = pop(frame), b = pop(frame);
+            stack.push_back(a);
+            stack.push_back(b);
+            stack.push_back(a);
+            break;
+        }
+
+        case Instruction::DUP_X2:
+        {
+            VT a = pop(frame), b = pop(frame), c = pop(frame);
+            stack.push_back(a);
+            stack.push_back(c);
+            stack.push_back(b);
+            stack.push_back(a);
+            break;
+        }
+
+        // Arithmetic and logical
+        case Instruction::IADD: case Instruction::ISUB:
+        case Instruction::IMUL: case Instruction::IDIV:
+        case Instruction::IREM: case Instruction::IAND:
+        case Instruction::IOR:  case Instruction::IXOR:
+            pop(frame, 2);
+            stack.push_back(VT(VT::INTEGER));
+            break;
+
+        case Instruction::FADD: case Instruction::FSUB:
+        case Instruction::FMUL: case Instruction::FDIV:
+        case Instruction::FREM:
+            pop(frame, 2);
+            stack.push_back(VT(VT::FLOAT));
+            break;
+
+        case Instruction::LADD: case Instruction::LSUB:
+            pop(frame, 2);
+            stack.push_back(VT(VT::LONG));
+            break;
+
+        case Instruction::INEG: case Instruction::FNEG:
+        case Instruction::IINC:
+            break;
+
+        // Type conversion and checking
+        case Instruction::I2F: case Instruction::D2F:
+            pop(frame, 1);
+            stack.push_back(VT(VT::FLOAT));
+            break;
+
+        case Instruction::I2C: case Instruction::F2I:
+            pop(frame, 1);
+            stack.push_back(VT(VT::INTEGER));
+            break;
+
+        case Instruction::I2D: case Instruction::F2D:
+            pop(frame, 1);
+            stack.push_back(VT(VT::DOUBLE));
+            break;
+
+        case Instruction::CHECKCAST:
+            pop(frame, 1);
+            stack.push_back(VT(VT::OBJECT, code.getText(record.operands[0])));
+            break;
+
+        // Objects and arrays
+        case Instruction::NEW:
+            stack.push_back(VT(VT::UNINITIALIZED, "", offset));
+            break;
+
+        case Instruction::NEWARRAY:
+        {
+            static const map<string, string> ARRAY_TYPES =
+            {
+                {"boolean", "[Z"}, {"char",  "[C"}, {"float", "[F"},
+                {"double",  "[D"}, {"byte",  "[B"}, {"short", "[S"},
+                {"int",     "[I"}, {"long",  "[J"},
+            };
+
+            pop(frame, 1);
+            stack.push_back(VT(VT::OBJECT,
+                               ARRAY_TYPES.at(code.getText(record.operands[0]))));
+            break;
+        }
+
+        case Instruction::ANEWARRAY:
+        {
+            string element = code.getText(record.operands[0]);
+
+            pop(frame, 1);
+            stack.push_back(VT(VT::OBJECT, element[0] == '['
+                                               ? "[" + element
+                                               : "[L" + element + ";"));
+            break;
+        }
+
+        case Instruction::MULTIANEWARRAY:
+            pop(frame, stoi(code.getText(record.operands[1])));
+            stack.push_back(VT(VT::OBJECT, code.getText(record.operands[0])));
+            break;
+
+        case Instruction::IALOAD: case Instruction::BALOAD:
+        case Instruction::CALOAD:
+            pop(frame, 2);
+            stack.push_back(VT(VT::INTEGER));
+            break;
+
+        case Instruction::FALOAD:
+            pop(frame, 2);
+            stack.push_back(VT(VT::FLOAT));
+            break;
+
+        case Instruction::AALOAD:
+        {
+            pop(frame, 1);
+            VT array = pop(frame);
+
+            if (   (array.tag == VT::OBJECT)
+                && (array.className.size() > 1) && (array.className[0] == '['))
+            {
+                size_t position = 1;
+                stack.push_back(typeOf(array.className, position));
+            }
+            else stack.push_back(VT(VT::NULL_TYPE));
+            break;
+        }
+
+        case Instruction::IASTORE: case Instruction::FASTORE:
+        case Instruction::BASTORE: case Instruction::CASTORE:
+        case Instruction::AASTORE:
+            pop(frame, 3);
+            break;
+
+        // Compare and branch
+        case Instruction::IFEQ: case Instruction::IFNE:
+        case Instruction::IFLT: case Instruction::IFLE:
+        case Instruction::IFGT: case Instruction::IFGE:
+        case Instruction::LOOKUPSWITCH:
+            pop(frame, 1);
+            break;
+
+        case Instruction::IF_ICMPEQ: case Instruction::IF_ICMPNE:
+        case Instruction::IF_ICMPLT: case Instruction::IF_ICMPLE:
+        case Instruction::IF_ICMPGT: case Instruction::IF_ICMPGE:
+            pop(frame, 2);
+            break;
+
+        case Instruction::FCMPG:
+            pop(frame, 2);
+            stack.push_back(VT(VT::INTEGER));
+            break;
+
+        // Call and return
+        case Instruction::INVOKESTATIC:  case Instruction::INVOKESPECIAL:
+        case Instruction::INVOKEVIRTUAL: case Instruction::INVOKENONVIRTUAL:
+        {
+            string text = code.getText(record.operands[0]);
+            size_t paren = text.find('(');
+            size_t separator = text.find_last_of("/.", paren);
+            string owner = text.substr(0, separator);
+            string name  = text.substr(separator + 1, paren - separator - 1);
+
+            size_t position = paren + 1;
+            while (text[position] != ')')
+            {
+                typeOf(text, position);
+                pop(frame, 1);
+            }
+            position++;
+
+            if (!record.is(INVOKESTATIC))
+            {
+                VT receiver = pop(frame);
+
+                // A constructor call initializes every copy of the object.
+                if (   (name == "<init>")
+                    && (   (receiver.tag == VT::UNINITIALIZED)
+                        || (receiver.tag == VT::UNINITIALIZED_THIS)))
+                {
+                    VT initialized(VT::OBJECT,
+                                   receiver.tag == VT::UNINITIALIZED_THIS
+                                       ? className : owner);
+
+                    for (VT& type : frame.locals)
+                    {
+                        if (type == receiver) type = initialized;
+                    }
+                    for (VT& type : stack)
+                    {
+                        if (type == receiver) type = initialized;
+                    }
+                }
+            }
+
+            if (text[position] != 'V') stack.push_back(typeOf(text, position));
+            break;
+        }
+
+        case Instruction::IRETURN: case Instruction::FRETURN:
+        case Instruction::ARETURN: case Instruction::LRETURN:
+            pop(frame, 1);
+            break;
+
+        default: break;
+    }
+}
+
+string FrameAnalyzer::operandText(const CodeRecord& record) const
+{
+    if (record.form == OperandForm::TEXT_PAIR)
+    {
+        return code.getText(record.operands[0]) + " "
+             + code.getText(record.operands[1]);
+    }
+
+    return code.getText(record.operands[0]);
+}
+
+VT FrameAnalyzer::typeOf(const string& descriptor, size_t& position)
+{
+    size_t start = position;
+    char ch = descriptor[position++];
+
+    switch (ch)
+    {
+        case 'I': case 'Z': case 'B': case 'C': case 'S':
+            return VT(VT::INTEGER);
+
+        case 'F': return VT(VT::FLOAT);
+        case 'J': return VT(VT::LONG);
+        case 'D': return VT(VT::DOUBLE);
+
+        case 'L':
+        {
+            size_t semicolon = descriptor.find(';', position);
+            string name = descriptor.substr(position, semicolon - position);
+            position = semicolon + 1;
+            return VT(VT::OBJECT, name);
+        }
+
+        case '[':
+        {
+            // The class name of an array type is its descriptor.
+            while (descriptor[position] == '[') position++;
+            typeOf(descriptor, position);
+            return VT(VT::OBJECT, descriptor.substr(start, position - start));
+        }
+
+        default: return VT();
+    }
+}
+
+VT FrameAnalyzer::mergeTypes(const VT& a, const VT& b)
+{
+    if (a == b) return a;
+
+    if ((a.tag == VT::NULL_TYPE) && (b.tag == VT::OBJECT)) return b;
+    if ((b.tag == VT::NULL_TYPE) && (a.tag == VT::OBJECT)) return a;
+
+    // Different classes: java/lang/Object is assignable from both.
+    if ((a.tag == VT::OBJECT) && (b.tag == VT::OBJECT))
+    {
+        return VT(VT::OBJECT, "java/lang/Object");
+    }
+
+    return VT();
+}
+
+VT FrameAnalyzer::pop(Frame& frame)
+{
+    if (frame.stack.empty()) return VT();  // reported by the StackAnalyzer
+
+    VT type = frame.stack.back();
+    frame.stack.pop_back();
+
+    return type;
+}
+
+void FrameAnalyzer::pop(Frame& frame, int count)
+{
+    for (int i = 0; i < count; i++) pop(frame);
+}
+
+VT FrameAnalyzer::load(const Frame& frame, int slot)
+{
+    return slot < static_cast<int>(frame.locals.size()) ? frame.locals[slot]
+                                                         : VT();
+}
+
+void FrameAnalyzer::store(Frame& frame, int slot, const VT& type)
+{
+    vector<VT>& locals = frame.locals;
+    if (slot >= static_cast<int>(locals.size())) return;
+
+    // Overwriting the second slot of a long or double kills it.
+    if ((slot > 0) && locals[slot - 1].isWide()) locals[slot - 1] = VT();
+
+    locals[slot] = type;
+    if (type.isWide() && (slot + 1 < static_cast<int>(locals.size())))
+    {
+        locals[slot + 1] = VT();
+    }
+}
+
+}} // namespace backend::compiler
@@ -0,0 +1,195 @@
+/**
+ * <h1>FrameAnalyzer</h1>
+ *
+ * <p>Infer the types of the local variables and the operand stack at
+ * each branch target of a method, for the StackMapTable attribute
+ * that the JVM's type-checking verifier requires.</p>
+ */
+#ifndef FRAMEANALYZER_H_
+#define FRAMEANALYZER_H_
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "MethodCode.h"
+
+namespace backend { namespace compiler {
+
+using namespace std;
+
+/**
+ * A verification type of the StackMapTable attribute.
+ */
+class VerificationType
+{
+public:
+    enum Tag
+    {
+        TOP = 0, INTEGER = 1, FLOAT = 2, DOUBLE = 3, LONG = 4,
+        NULL_TYPE = 5, UNINITIALIZED_THIS = 6, OBJECT = 7, UNINITIALIZED = 8
+    };
+
+    Tag tag;           // the kind of type
+    string className;  // internal class name of an OBJECT
+    int offset;        // offset of the NEW of an UNINITIALIZED
+
+    /**
+     * Constructor.
+     * @param tag the kind of type.
+     * @param className the class name of an OBJECT.
+     * @param offset the offset of the NEW of an UNINITIALIZED.
+     */
+    VerificationType(Tag tag = TOP, string className = "", int offset = 0)
+        : tag(tag), className(className), offset(offset) {}
+
+    /**
+     * Check whether the type takes two local variable slots.
+     * @return true if it does, else false.
+     */
+    bool isWide() const { return (tag == LONG) || (tag == DOUBLE); }
+
+    bool operator == (const VerificationType& other) const
+    {
+        return    (tag == other.tag) && (className == other.className)
+               && (offset == other.offset);
+    }
+
+    bool operator != (const VerificationType& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+/**
+ * The types of the local variables and the operand stack.
+ * Each local variable slot has its own entry, and the second slot
+ * of a long or double is TOP. Each stack value has one entry.
+ */
+class Frame
+{
+public:
+    vector<VerificationType> locals;
+    vector<VerificationType> stack;
+};
+
+class FrameAnalyzer
+{
+private:
+    const MethodCode& code;                 // the method's code
+    const vector<const CodeRecord *>& body; // its instructions and labels
+    const vector<int>& offsets;             // bytecode offset of each
+    string className;                       // name of the method's class
+
+    map<Label *, size_t> positions;  // body index of each label
+    map<size_t, Frame> frames;       // frame at each reached label
+
+public:
+    /**
+     * Constructor.
+     * @param code the method's code.
+     * @param body the method's instructions, labels and switch entries.
+     * @param offsets the bytecode offset of each body element.
+     * @param className the internal name of the method's class.
+     */
+    FrameAnalyzer(const MethodCode& code,
+                  const vector<const CodeRecord *>& body,
+                  const vector<int>& offsets, const string& className)
+        : code(code), body(body), offsets(offsets), className(className) {}
+
+    /**
+     * Compute the frame at each branch target.
+     * @param methodName the name of the method.
+     * @param descriptor the method descriptor.
+     * @param isStatic true if the method is static.
+     * @param maxLocals the count of local variable slots.
+     * @return the frames by bytecode offset.
+     */
+    map<int, Frame> analyze(const string& methodName,
+                            const string& descriptor,
+                            bool isStatic, int maxLocals);
+
+private:
+    /**
+     * Follow the straight-line code starting at a body index.
+     * @param start the index.
+     * @param frame the frame on entry.
+     * @param worklist where to add labels whose frame changed.
+     */
+    void follow(size_t start, Frame frame, vector<size_t>& worklist);
+
+    /**
+     * Merge a frame into the frame of a label.
+     * @param label the label.
+     * @param frame the incoming frame.
+     * @param worklist where to add the label if its frame changed.
+     */
+    void merge(Label *label, const Frame& frame, vector<size_t>& worklist);
+
+    /**
+     * Update a frame by the effect of an instruction.
+     * @param frame the frame.
+     * @param record the instruction record.
+     * @param offset the bytecode offset of the instruction.
+     */
+    void execute(Frame& frame, const CodeRecord& record, int offset);
+
+    /**
+     * Get an instruction's operand text, joining a pair with a blank.
+     * @param record the instruction record.
+     * @return the text.
+     */
+    string operandText(const CodeRecord& record) const;
+
+    /**
+     * Get the verification type of a field or return type descriptor.
+     * @param descriptor the descriptor.
+     * @param position the position of the type, moved past it.
+     * @return the type.
+     */
+    static VerificationType typeOf(const string& descriptor,
+                                   size_t& position);
+
+    /**
+     * Merge two types into one that both are assignable to.
+     * @param a the first type.
+     * @param b the second type.
+     * @return the merged type.
+     */
+    static VerificationType mergeTypes(const VerificationType& a,
+                                       const VerificationType& b);
+
+    /**
+     * Pop a value from the operand stack.
+     * @param frame the frame.
+     * @return the value's type.
+     */
+    static VerificationType pop(Frame& frame);
+
+    /**
+     * Pop values from the operand stack.
+     * @param frame the frame.
+     * @param count the count of values.
+     */
+    static void pop(Frame& frame, int count);
+
+    /**
+     * Get the type of a local variable slot.
+     * @param frame the frame.
+     * @param slot the slot number.
+     * @return the type.
+     */
+    static VerificationType load(const Frame& frame, int slot);
+
+    /**
+     * Store a type into a local variable slot.
+     * @param frame the frame.
+     * @param slot the slot number.
+     * @param type the type.
+     */
+    static void store(Frame& frame, int slot, const VerificationType& type);
+};
+
+}}  // namespace backend::compiler
+
+#endif /* FRAMEANALYZER_H_ */
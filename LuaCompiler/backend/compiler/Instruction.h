@@ -28,7 +28,7 @@ enum class Instruction
     FLOAD_0, FLOAD_1, FLOAD_2, FLOAD_3,
     ALOAD_0, ALOAD_1, ALOAD_2, ALOAD_3,
     LLOAD_0, LLOAD_1, LLOAD_2, LLOAD_3,
-    ILOAD, FLOAD, ALOAD,
+    ILOAD, FLOAD, ALOAD, LLOAD,
     GETSTATIC, GETFIELD,
 
     // Store value or address
@@ -36,16 +36,17 @@ enum class Instruction
     FSTORE_0, FSTORE_1, FSTORE_2, FSTORE_3,
     ASTORE_0, ASTORE_1, ASTORE_2, ASTORE_3,
     LSTORE_0, LSTORE_1, LSTORE_2, LSTORE_3,
-    ISTORE, FSTORE, ASTORE,
+    ISTORE, FSTORE, ASTORE, LSTORE,
     PUTSTATIC, PUTFIELD,
 
     // Operand stack
-    POP, SWAP, DUP, DUP_X1, DUP_X2,
+    POP, POP2, SWAP, DUP, DUP_X1, DUP_X2,
 
     // Arithmetic and logical
     IADD, FADD, ISUB, FSUB, IMUL, FMUL,
     IDIV, FDIV, IREM, FREM, INEG, FNEG,
     IINC, IAND, IOR, IXOR,
+    LADD, LSUB,
 
     // Type conversion and checking
     I2F, I2C, I2D, F2I, F2D, D2F,
@@ -65,7 +66,7 @@ enum class Instruction
     // Call and return
     INVOKESTATIC, INVOKESPECIAL,
     INVOKEVIRTUAL, INVOKENONVIRTUAL,
-    RETURN, IRETURN, FRETURN, ARETURN,
+    RETURN, IRETURN, FRETURN, ARETURN, LRETURN,
 
     // No operation
     NOP
@@ -84,7 +85,7 @@ static const int STACK_USE[] =
     1, 1, 1, 1,
     1, 1, 1, 1,
     2, 2, 2, 2,
-    1, 1, 1,
+    1, 1, 1, 2,
     1, 0,
 
     // Store value or address
@@ -92,19 +93,20 @@ static const int STACK_USE[] =
     -1, -1, -1, -1,
     -1, -1, -1, -1,
     -2, -2, -2, -2,
-    -1, -1, -1,
+    -1, -1, -1, -2,
     -1, -2,
 
     // Operand stack
-    -1, 0, 1, 1, 1,
+    -1, -2, 0, 1, 1, 1,
 
     // Arithmetic and logical
     -1, -1, -1, -1, -1, -1,
     -1, -1, -1, -1, 0, 0,
     0, -1, -1, -1,
+    -2, -2,
 
     // Type conversion and checking
-    0, 0, 0, 0, 0, 0,
+    0, 0, 1, 0, 1, -1,
     0,
 
     // Objects and arrays
@@ -121,7 +123,7 @@ static const int STACK_USE[] =
     // Call and return
     0, 0,
     0, 0,
-    0, -1, -1, -1,
+    0, -1, -1, -1, -2,
 
     // No operation
     0
@@ -145,7 +147,7 @@ static const string INSTRUCTION_STRINGS[] =
     "FLOAD_0", "FLOAD_1", "FLOAD_2", "FLOAD_3",
     "ALOAD_0", "ALOAD_1", "ALOAD_2", "ALOAD_3",
     "LLOAD_0", "LLOAD_1", "LLOAD_2", "LLOAD_3",
-    "ILOAD", "FLOAD", "ALOAD",
+    "ILOAD", "FLOAD", "ALOAD", "LLOAD",
     "GETSTATIC", "GETFIELD",
 
     // Store value or address
@@ -153,16 +155,17 @@ static const string INSTRUCTION_STRINGS[] =
     "FSTORE_0", "FSTORE_1", "FSTORE_2", "FSTORE_3",
     "ASTORE_0", "ASTORE_1", "ASTORE_2", "ASTORE_3",
     "LSTORE_0", "LSTORE_1", "LSTORE_2", "LSTORE_3",
-    "ISTORE", "FSTORE", "ASTORE",
+    "ISTORE", "FSTORE", "ASTORE", "LSTORE",
     "PUTSTATIC", "PUTFIELD",
 
     // Operand stack
-    "POP", "SWAP", "DUP", "DUP_X1", "DUP_X2",
+    "POP", "POP2", "SWAP", "DUP", "DUP_X1", "DUP_X2",
 
     // Arithmetic and logical
     "IADD", "FADD", "ISUB", "FSUB", "IMUL", "FMUL",
     "IDIV", "FDIV", "IREM", "FREM", "INEG", "FNEG",
     "IINC", "IAND", "IOR", "IXOR",
+    "LADD", "LSUB",
 
     // Type conversion and checking
     "I2F", "I2C", "I2D", "F2I", "F2D", "D2F",
@@ -182,7 +185,7 @@ static const string INSTRUCTION_STRINGS[] =
     // Call and return
     "INVOKESTATIC", "INVOKESPECIAL",
     "INVOKEVIRTUAL", "INVOKENONVIRTUAL",
-    "RETURN", "IRETURN", "FRETURN", "ARETURN",
+    "RETURN", "IRETURN", "FRETURN", "ARETURN", "LRETURN",
 
     // No operation
     "NOP"
@@ -224,6 +227,7 @@ constexpr Instruction LLOAD_3   = Instruction::LLOAD_3;
 constexpr Instruction ILOAD     = Instruction::ILOAD;
 constexpr Instruction FLOAD     = Instruction::FLOAD;
 constexpr Instruction ALOAD     = Instruction::ALOAD;
+constexpr Instruction LLOAD     = Instruction::LLOAD;
 constexpr Instruction GETSTATIC = Instruction::GETSTATIC;
 constexpr Instruction GETFIELD  = Instruction::GETFIELD;
 
@@ -247,11 +251,13 @@ constexpr Instruction LSTORE_3  = Instruction::LSTORE_3;
 constexpr Instruction ISTORE    = Instruction::ISTORE;
 constexpr Instruction FSTORE    = Instruction::FSTORE;
 constexpr Instruction ASTORE    = Instruction::ASTORE;
+constexpr Instruction LSTORE    = Instruction::LSTORE;
 constexpr Instruction PUTSTATIC = Instruction::PUTSTATIC;
 constexpr Instruction PUTFIELD  = Instruction::PUTFIELD;
 
 // Operand stack
 constexpr Instruction POP    = Instruction::POP;
+constexpr Instruction POP2   = Instruction::POP2;
 constexpr Instruction SWAP   = Instruction::SWAP;
 constexpr Instruction DUP    = Instruction::DUP;
 constexpr Instruction DUP_X1 = Instruction::DUP_X1;
@@ -274,6 +280,8 @@ constexpr Instruction IINC = Instruction::IINC;
 constexpr Instruction IAND = Instruction::IAND;
 constexpr Instruction IOR  = Instruction::IOR;
 constexpr Instruction IXOR = Instruction::IXOR;
+constexpr Instruction LADD = Instruction::LADD;
+constexpr Instruction LSUB = Instruction::LSUB;
 
 // Type conversion and checking
 constexpr Instruction I2F       = Instruction::I2F;
@@ -326,6 +334,7 @@ constexpr Instruction RETURN           = Instruction::RETURN;
 constexpr Instruction IRETURN          = Instruction::IRETURN;
 constexpr Instruction FRETURN          = Instruction::FRETURN;
 constexpr Instruction ARETURN          = Instruction::ARETURN;
+constexpr Instruction LRETURN          = Instruction::LRETURN;
 
 // No operation
 constexpr Instruction NOP = Instruction::NOP;
@@ -0,0 +1,147 @@
+/**
+ * <h1>JasminWriter</h1>
+ *
+ * <p>Serialize method code records as Jasmin assembly text.</p>
+ */
+#include "JasminWriter.h"
+
+namespace backend { namespace compiler {
+
+using namespace std;
+
+void JasminWriter::write(const MethodCode& code)
+{
+    for (const CodeRecord& record : code.getRecords())
+    {
+        switch (record.kind)
+        {
+            case RecordKind::INSTRUCTION:
+                writeInstruction(code, record);
+                break;
+
+            case RecordKind::DIRECTIVE:
+                writeDirective(code, record);
+                break;
+
+            case RecordKind::LABEL:
+                *objectFile << record.label << ":";
+                objectFile->endLine();
+                break;
+
+            case RecordKind::SWITCH_LABEL:
+            {
+                *objectFile << "\t  ";
+                if (record.form == OperandForm::TEXT)
+                {
+                    *objectFile << code.getText(record.operands[0]);
+                }
+                else *objectFile << record.operands[0];
+                *objectFile << ": " << record.label;
+                objectFile->endLine();
+                break;
+            }
+
+            case RecordKind::CASE:
+                *objectFile << "\t" << "\t" << record.operands[0]
+                            << ": " << record.label;
+                objectFile->endLine();
+                break;
+
+            case RecordKind::DEFAULT_CASE:
+                *objectFile << "\t" << "\t" << "default: " << record.label;
+                objectFile->endLine();
+                objectFile->endLine();
+                break;
+
+            case RecordKind::COMMENT:
+                *objectFile << ";";
+                objectFile->endLine();
+                *objectFile << "; " << code.getText(record.operands[0]);
+                objectFile->endLine();
+                *objectFile << ";";
+                objectFile->endLine();
+                break;
+
+            case RecordKind::BLANK_LINE:
+                objectFile->endLine();
+                break;
+        }
+    }
+}
+
+void JasminWriter::writeInstruction(const MethodCode& code,
+                                    const CodeRecord& record)
+{
+    *objectFile << "\t" << record.instruction;
+
+    switch (record.form)
+    {
+        case OperandForm::NONE: break;
+
+        case OperandForm::INTEGER:
+            *objectFile << "\t" << record.operands[0];
+            break;
+
+        case OperandForm::INTEGER_PAIR:
+            *objectFile << "\t" << record.operands[0] << " "
+                                << record.operands[1];
+            break;
+
+        case OperandForm::REAL:
+            *objectFile << "\t" << record.real;
+            break;
+
+        case OperandForm::TEXT:
+            *objectFile << "\t" << code.getText(record.operands[0]);
+            break;
+
+        case OperandForm::TEXT_PAIR:
+            *objectFile << "\t" << code.getText(record.operands[0]) << " "
+                                << code.getText(record.operands[1]);
+            break;
+
+        case OperandForm::LABEL:
+            *objectFile << "\t" << record.label;
+            break;
+
+        default: break;
+    }
+
+    objectFile->endLine();
+}
+
+void JasminWriter::writeDirective(const MethodCode& code,
+                                  const CodeRecord& record)
+{
+    *objectFile << record.directive;
+
+    switch (record.form)
+    {
+        case OperandForm::NONE: break;
+
+        case OperandForm::INTEGER:
+            *objectFile << " " << record.operands[0];
+            break;
+
+        case OperandForm::TEXT:
+            *objectFile << " " << code.getText(record.operands[0]);
+            break;
+
+        case OperandForm::TEXT_PAIR:
+            *objectFile << " " << code.getText(record.operands[0])
+                        << " " << code.getText(record.operands[1]);
+            break;
+
+        case OperandForm::TEXT_TRIPLE:
+            *objectFile << " " << code.getText(record.operands[0])
+                        << " " << code.getText(record.operands[1])
+                        << " " << code.getText(record.operands[2]);
+            break;
+
+        default: break;
+    }
+
+    objectFile->endLine();
+}
+
+}} // namespace backend::compiler
@@ -0,0 +1,52 @@
+/**
+ * <h1>JasminWriter</h1>
+ *
+ * <p>Serialize method code records as Jasmin assembly text.</p>
+ */
+#ifndef JASMINWRITER_H_
+#define JASMINWRITER_H_
+
+#include "MethodCode.h"
+#include "ObjectFile.h"
+
+namespace backend { namespace compiler {
+
+using namespace std;
+
+class JasminWriter
+{
+private:
+    ObjectFile *objectFile;  // where to write the assembly text
+
+public:
+    /**
+     * Constructor.
+     * @param objectFile the object file to write to.
+     */
+    JasminWriter(ObjectFile *objectFile) : objectFile(objectFile) {}
+
+    /**
+     * Write the Jasmin text of a method's code records.
+     * @param code the method code.
+     */
+    void write(const MethodCode& code);
+
+private:
+    /**
+     * Write an instruction record.
+     * @param code the method code that contains the record.
+     * @param record the record.
+     */
+    void writeInstruction(const MethodCode& code, const CodeRecord& record);
+
+    /**
+     * Write a directive record.
+     * @param code the method code that contains the record.
+     * @param record the record.
+     */
+    void writeDirective(const MethodCode& code, const CodeRecord& record);
+};
+
+}}  // namespace backend::compiler
+
+#endif /* JASMINWRITER_H_ */
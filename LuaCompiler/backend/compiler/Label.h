@@ -20,17 +20,17 @@ using namespace std;
 class Label
 {
 private:
-    static int index;  // index for generating label strings
     string label;      // the label string
 
 public:
     /**
      * Constructor.
+     * @param index the label's index within its method.
      */
-    Label()
+    Label(int index)
     {
         stringstream ss;
-        ss << setw(3) << setfill('0') << ++index;
+        ss << setw(3) << setfill('0') << index;
         label = "L" + ss.str();
     }
 
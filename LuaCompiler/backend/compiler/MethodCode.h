@@ -0,0 +1,467 @@
+/**
+ * <h1>MethodCode</h1>
+ *
+ * <p>In-memory instruction stream of a method. The code generators
+ * append compact records here instead of formatting text, so that the
+ * code can be examined and rewritten before it is written out.</p>
+ */
+#ifndef METHODCODE_H_
+#define METHODCODE_H_
+
+#include <string>
+#include <vector>
+#include <deque>
+
+#include "Instruction.h"
+#include "Directive.h"
+#include "Label.h"
+
+namespace backend { namespace compiler {
+
+using namespace std;
+
+/**
+ * What a code record represents.
+ */
+enum class RecordKind
+{
+    INSTRUCTION,   // a JVM instruction
+    DIRECTIVE,     // a Jasmin directive
+    LABEL,         // a branch target
+    SWITCH_LABEL,  // a value and label in a switch table
+    CASE,          // a case value and label
+    DEFAULT_CASE,  // the default label
+    COMMENT,       // a comment block
+    BLANK_LINE     // a blank line
+};
+
+/**
+ * The form of a code record's operands.
+ */
+enum class OperandForm
+{
+    NONE,          // no operands
+    INTEGER,       // operands[0] is an integer value
+    INTEGER_PAIR,  // operands[0] and operands[1] are integer values
+    REAL,          // real is the value
+    TEXT,          // operands[0] indexes the text table
+    TEXT_PAIR,     // operands[0] and operands[1] index the text table
+    TEXT_TRIPLE,   // operands[0] through operands[2] index the text table
+    LABEL          // label is the operand
+};
+
+class CodeRecord
+{
+public:
+    RecordKind kind;          // what the record represents
+    Instruction instruction;  // operation code of an INSTRUCTION
+    Directive directive;      // directive code of a DIRECTIVE
+    OperandForm form;         // form of the operands
+    int operands[3];          // integer values or text table indexes
+    double real;              // real operand value
+    Label *label;             // label operand or label definition
+
+    /**
+     * Constructor.
+     * @param kind what the record represents.
+     */
+    CodeRecord(RecordKind kind)
+        : kind(kind), instruction(NOP), directive(LINE),
+          form(OperandForm::NONE), operands{0, 0, 0}, real(0.0),
+          label(nullptr) {}
+
+    /**
+     * Check whether this record is an instruction.
+     * @return true if it is, else false.
+     */
+    bool isInstruction() const { return kind == RecordKind::INSTRUCTION; }
+
+    /**
+     * Check whether this record is a given instruction.
+     * @param op the operation code.
+     * @return true if it is, else false.
+     */
+    bool is(Instruction op) const
+    {
+        return (kind == RecordKind::INSTRUCTION) && (instruction == op);
+    }
+};
+
+class MethodCode
+{
+private:
+    vector<CodeRecord> records;  // the method's code records
+    vector<string> texts;        // text operands of the records
+    deque<Label> labels;         // the method's labels
+    Label *exitLabel;            // where its returns branch, or null
+
+public:
+    /**
+     * Constructor.
+     */
+    MethodCode() : exitLabel(nullptr) {}
+
+    /**
+     * Getter.
+     * @return the code records.
+     */
+    vector<CodeRecord>& getRecords() { return records; }
+
+    /**
+     * Getter.
+     * @return the code records.
+     */
+    const vector<CodeRecord>& getRecords() const { return records; }
+
+    /**
+     * Get a text operand.
+     * @param index the index into the text table.
+     * @return the text.
+     */
+    const string& getText(int index) const { return texts[index]; }
+
+    /**
+     * Enter a text operand into the text table.
+     * @param text the text.
+     * @return its index.
+     */
+    int addText(const string& text)
+    {
+        texts.push_back(text);
+        return texts.size() - 1;
+    }
+
+    /**
+     * Check whether there is any code.
+     * @return true if there are no records, else false.
+     */
+    bool isEmpty() const { return records.empty(); }
+
+    /**
+     * Remove all the code.
+     */
+    void clear()
+    {
+        records.clear();
+        texts.clear();
+        labels.clear();
+        exitLabel = nullptr;
+    }
+
+    /**
+     * Create a new label. Labels are numbered within each method
+     * and are owned by the method code until it is cleared.
+     * @return the label.
+     */
+    Label *newLabel()
+    {
+        labels.emplace_back(labels.size() + 1);
+        return &labels.back();
+    }
+
+    /**
+     * Get the label of the method's exit, where each return statement
+     * branches. It is created the first time that it is needed.
+     * @return the label.
+     */
+    Label *getExitLabel()
+    {
+        if (exitLabel == nullptr) exitLabel = newLabel();
+        return exitLabel;
+    }
+
+    /**
+     * Check whether any return statement branches to the method's exit.
+     * @return true if one does, else false.
+     */
+    bool hasExitLabel() const { return exitLabel != nullptr; }
+
+    // ============
+    // Instructions
+    // ============
+
+    /**
+     * Append a 0-operand instruction.
+     * @param instruction the operation code.
+     */
+    void appendInstruction(Instruction instruction)
+    {
+        append(instructionRecord(instruction));
+    }
+
+    /**
+     * Append a 1-operand instruction.
+     * @param instruction the operation code.
+     * @param operand the operand text.
+     */
+    void appendInstruction(Instruction instruction, const string& operand)
+    {
+        CodeRecord record = instructionRecord(instruction);
+        record.form = OperandForm::TEXT;
+        record.operands[0] = addText(operand);
+        append(record);
+    }
+
+    /**
+     * Append a 1-operand instruction.
+     * @param instruction the operation code.
+     * @param operand the operand value.
+     */
+    void appendInstruction(Instruction instruction, int operand)
+    {
+        CodeRecord record = instructionRecord(instruction);
+        record.form = OperandForm::INTEGER;
+        record.operands[0] = operand;
+        append(record);
+    }
+
+    /**
+     * Append a 1-operand instruction.
+     * @param instruction the operation code.
+     * @param operand the operand value.
+     */
+    void appendInstruction(Instruction instruction, double operand)
+    {
+        CodeRecord record = instructionRecord(instruction);
+        record.form = OperandForm::REAL;
+        record.real = operand;
+        append(record);
+    }
+
+    /**
+     * Append a branch instruction.
+     * @param instruction the operation code.
+     * @param label the label operand.
+     */
+    void appendInstruction(Instruction instruction, Label *label)
+    {
+        CodeRecord record = instructionRecord(instruction);
+        record.form = OperandForm::LABEL;
+        record.label = label;
+        append(record);
+    }
+
+    /**
+     * Append a 2-operand instruction.
+     * @param instruction the operation code.
+     * @param operand1 the value of the first operand.
+     * @param operand2 the value of the second operand.
+     */
+    void appendInstruction(Instruction instruction, int operand1, int operand2)
+    {
+        CodeRecord record = instructionRecord(instruction);
+        record.form = OperandForm::INTEGER_PAIR;
+        record.operands[0] = operand1;
+        record.operands[1] = operand2;
+        append(record);
+    }
+
+    /**
+     * Append a 2-operand instruction.
+     * @param instruction the operation code.
+     * @param operand1 the text of the first operand.
+     * @param operand2 the text of the second operand.
+     */
+    void appendInstruction(Instruction instruction,
+                           const string& operand1, const string& operand2)
+    {
+        CodeRecord record = instructionRecord(instruction);
+        record.form = OperandForm::TEXT_PAIR;
+        record.operands[0] = addText(operand1);
+        record.operands[1] = addText(operand2);
+        append(record);
+    }
+
+    // ==========
+    // Directives
+    // ==========
+
+    /**
+     * Append a directive.
+     * @param directive the directive code.
+     */
+    void appendDirective(Directive directive)
+    {
+        append(directiveRecord(directive));
+    }
+
+    /**
+     * Append a 1-operand directive.
+     * @param directive the directive code.
+     * @param operand the operand text.
+     */
+    void appendDirective(Directive directive, const string& operand)
+    {
+        CodeRecord record = directiveRecord(directive);
+        record.form = OperandForm::TEXT;
+        record.operands[0] = addText(operand);
+        append(record);
+    }
+
+    /**
+     * Append a 1-operand directive.
+     * @param directive the directive code.
+     * @param operand the operand value.
+     */
+    void appendDirective(Directive directive, int operand)
+    {
+        CodeRecord record = directiveRecord(directive);
+        record.form = OperandForm::INTEGER;
+        record.operands[0] = operand;
+        append(record);
+    }
+
+    /**
+     * Append a 2-operand directive.
+     * @param directive the directive code.
+     * @param operand1 the first operand.
+     * @param operand2 the second operand.
+     */
+    void appendDirective(Directive directive,
+                         const string& operand1, const string& operand2)
+    {
+        CodeRecord record = directiveRecord(directive);
+        record.form = OperandForm::TEXT_PAIR;
+        record.operands[0] = addText(operand1);
+        record.operands[1] = addText(operand2);
+        append(record);
+    }
+
+    /**
+     * Append a 3-operand directive.
+     * @param directive the directive code.
+     * @param operand1 the first operand.
+     * @param operand2 the second operand.
+     * @param operand3 the third operand.
+     */
+    void appendDirective(Directive directive, const string& operand1,
+                         const string& operand2, const string& operand3)
+    {
+        CodeRecord record = directiveRecord(directive);
+        record.form = OperandForm::TEXT_TRIPLE;
+        record.operands[0] = addText(operand1);
+        record.operands[1] = addText(operand2);
+        record.operands[2] = addText(operand3);
+        append(record);
+    }
+
+    // ======================
+    // Labels and annotations
+    // ======================
+
+    /**
+     * Append a label definition.
+     * @param label the label.
+     */
+    void appendLabel(Label *label)
+    {
+        CodeRecord record(RecordKind::LABEL);
+        record.label = label;
+        append(record);
+    }
+
+    /**
+     * Append a label preceded by an integer value for a switch table.
+     * @param value the value.
+     * @param label the label.
+     */
+    void appendSwitchLabel(int value, Label *label)
+    {
+        CodeRecord record(RecordKind::SWITCH_LABEL);
+        record.form = OperandForm::INTEGER;
+        record.operands[0] = value;
+        record.label = label;
+        append(record);
+    }
+
+    /**
+     * Append a label preceded by a string value for a switch table.
+     * @param value the value.
+     * @param label the label.
+     */
+    void appendSwitchLabel(const string& value, Label *label)
+    {
+        CodeRecord record(RecordKind::SWITCH_LABEL);
+        record.form = OperandForm::TEXT;
+        record.operands[0] = addText(value);
+        record.label = label;
+        append(record);
+    }
+
+    /**
+     * Append a case value and label.
+     * @param value the case value.
+     * @param label the label.
+     */
+    void appendCase(int value, Label *label)
+    {
+        CodeRecord record(RecordKind::CASE);
+        record.form = OperandForm::INTEGER;
+        record.operands[0] = value;
+        record.label = label;
+        append(record);
+    }
+
+    /**
+     * Append the default case label.
+     * @param label the label.
+     */
+    void appendDefaultCase(Label *label)
+    {
+        CodeRecord record(RecordKind::DEFAULT_CASE);
+        record.label = label;
+        append(record);
+    }
+
+    /**
+     * Append a comment.
+     * @param text the comment text.
+     */
+    void appendComment(const string& text)
+    {
+        CodeRecord record(RecordKind::COMMENT);
+        record.form = OperandForm::TEXT;
+        record.operands[0] = addText(text);
+        append(record);
+    }
+
+    /**
+     * Append a blank line.
+     */
+    void appendBlankLine() { append(CodeRecord(RecordKind::BLANK_LINE)); }
+
+private:
+    /**
+     * Append a record.
+     * @param record the record.
+     */
+    void append(const CodeRecord& record) { records.push_back(record); }
+
+    /**
+     * Create an instruction record without operands.
+     * @param instruction the operation code.
+     * @return the record.
+     */
+    static CodeRecord instructionRecord(Instruction instruction)
+    {
+        CodeRecord record(RecordKind::INSTRUCTION);
+        record.instruction = instruction;
+        return record;
+    }
+
+    /**
+     * Create a directive record without operands.
+     * @param directive the directive code.
+     * @return the record.
+     */
+    static CodeRecord directiveRecord(Directive directive)
+    {
+        CodeRecord record(RecordKind::DIRECTIVE);
+        record.directive = directive;
+        return record;
+    }
+};
+
+}}  // namespace backend::compiler
+
+#endif /* METHODCODE_H_ */
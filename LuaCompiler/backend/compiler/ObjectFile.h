@@ -0,0 +1,153 @@
+/**
+ * <h1>ObjectFile</h1>
+ *
+ * <p>Buffered output sink for the generated object code. Text is
+ * collected in memory and written to disk in large chunks, or
+ * line by line in synchronous (debugging) mode.</p>
+ */
+#ifndef OBJECTFILE_H_
+#define OBJECTFILE_H_
+
+#include <string>
+#include <sstream>
+#include <fstream>
+
+#include "intermediate/util/Tracer.h"
+
+namespace backend { namespace compiler {
+
+using namespace std;
+
+class ObjectFile
+{
+private:
+    ofstream file;         // the object file on disk
+    ostringstream buffer;  // text not yet written to the file
+    size_t bufferSize;     // spill threshold, or 0 to write once at close
+    bool syncOutput;       // true to flush after every line
+    int lineCount;         // count of emitted lines
+    size_t byteCount;      // count of emitted bytes
+    int instructionCount;  // count of emitted instructions
+
+public:
+    /**
+     * Constructor.
+     * @param fileName the name of the object file.
+     * @param bufferSize the buffer size in bytes, or 0 for a single write.
+     * @param syncOutput true to write and flush after every line.
+     */
+    ObjectFile(string fileName, size_t bufferSize, bool syncOutput)
+        : file(fileName, ios::binary), bufferSize(bufferSize),
+          syncOutput(syncOutput), lineCount(0), byteCount(0),
+          instructionCount(0) {}
+
+    /**
+     * Check whether the object file was successfully opened.
+     * @return true if open, else false.
+     */
+    bool isOpen() const { return file.is_open(); }
+
+    /**
+     * Get the count of emitted lines.
+     * @return the count.
+     */
+    int getLineCount() const { return lineCount; }
+
+    /**
+     * Get the count of emitted instructions.
+     * @return the count.
+     */
+    int getInstructionCount() const { return instructionCount; }
+
+    /**
+     * Count emitted instructions.
+     * @param count the count to add.
+     */
+    void countInstructions(int count) { instructionCount += count; }
+
+    /**
+     * Get the count of emitted bytes.
+     * @return the count.
+     */
+    size_t getByteCount()
+    {
+        return byteCount + static_cast<size_t>(buffer.tellp());
+    }
+
+    /**
+     * Append a value to the current line.
+     * @param value the value to append.
+     * @return this object file.
+     */
+    template <typename T>
+    ObjectFile& operator << (const T& value)
+    {
+        buffer << value;
+        return *this;
+    }
+
+    /**
+     * End the current line.
+     */
+    void endLine()
+    {
+        buffer << '\n';
+        lineCount++;
+
+        if (syncOutput)
+        {
+            spill();
+            file.flush();
+        }
+        else if (   (bufferSize > 0)
+                 && (static_cast<size_t>(buffer.tellp()) >= bufferSize))
+        {
+            spill();
+        }
+    }
+
+    /**
+     * Append binary data.
+     * @param data the data.
+     * @param size the count of bytes.
+     */
+    void write(const char *data, size_t size)
+    {
+        buffer.write(data, size);
+
+        if (   syncOutput
+            || (   (bufferSize > 0)
+                && (static_cast<size_t>(buffer.tellp()) >= bufferSize)))
+        {
+            spill();
+        }
+    }
+
+    /**
+     * Write any buffered text and close the object file.
+     */
+    void close()
+    {
+        spill();
+        file.close();
+    }
+
+private:
+    /**
+     * Write the buffered text to the object file.
+     */
+    void spill()
+    {
+        intermediate::util::TraceSpan span("io", "ObjectFile::write");
+
+        string text = buffer.str();
+        span.arg("bytes", (long) text.size());
+        file.write(text.data(), text.size());
+        byteCount += text.size();
+        buffer.str("");
+    }
+};
+
+}}  // namespace backend::compiler
+
+#endif /* OBJECTFILE_H_ */
@@ -0,0 +1,531 @@
+/**
+ * <h1>PeepholeOptimizer</h1>
+ *
+ * <p>Rewrite short instruction sequences of a method's code
+ * into shorter or faster equivalents.</p>
+ */
+#include <iomanip>
+#include <set>
+
+#include "PeepholeOptimizer.h"
+
+namespace backend { namespace compiler {
+
+using namespace std;
+
+PeepholeOptimizer::PeepholeOptimizer()
+    : instructionsRemoved(0), records(nullptr)
+{
+    // The pattern table. At each record, the rules are tried in order.
+    rules.push_back(Rule("compare-branch",   &PeepholeOptimizer::fuseCompareBranch));
+    rules.push_back(Rule("constant-branch",  &PeepholeOptimizer::foldConstantBranch));
+    rules.push_back(Rule("store-load-return",&PeepholeOptimizer::removeStoreLoadReturn));
+    rules.push_back(Rule("store-load",       &PeepholeOptimizer::replaceStoreLoad));
+    rules.push_back(Rule("load-store",       &PeepholeOptimizer::removeLoadStore));
+    rules.push_back(Rule("goto-next",        &PeepholeOptimizer::removeGotoNext));
+    rules.push_back(Rule("jump-chain",       &PeepholeOptimizer::collapseJumpChain));
+    rules.push_back(Rule("unreachable",      &PeepholeOptimizer::removeUnreachable));
+    rules.push_back(Rule("dead-label",       &PeepholeOptimizer::removeDeadLabel));
+}
+
+void PeepholeOptimizer::optimize(MethodCode& code)
+{
+    records = &code.getRecords();
+    bool changed = true;
+
+    // Repeat until no rule applies, since one rewrite
+    // can expose an opportunity for another.
+    while (changed)
+    {
+        changed = false;
+        dead.assign(records->size(), false);
+        scanLabels();
+
+        for (size_t i = 0; i < records->size(); i++)
+        {
+            for (Rule& rule : rules)
+            {
+                if (dead[i]) break;
+
+                if ((this->*rule.apply)(i))
+                {
+                    rule.hits++;
+                    changed = true;
+                }
+            }
+        }
+
+        // Compact the live records.
+        size_t live = 0;
+        for (size_t i = 0; i < records->size(); i++)
+        {
+            if (!dead[i]) (*records)[live++] = (*records)[i];
+        }
+        records->erase(records->begin() + live, records->end());
+    }
+
+    records = nullptr;
+}
+
+void PeepholeOptimizer::addStatistics(const PeepholeOptimizer& other)
+{
+    for (size_t i = 0; i < rules.size(); i++) rules[i].hits += other.rules[i].hits;
+    instructionsRemoved += other.instructionsRemoved;
+}
+
+void PeepholeOptimizer::printStatistics(ostream& out) const
+{
+    out << endl << "===== PEEPHOLE OPTIMIZATIONS =====" << endl << endl;
+    out << left << setw(20) << "Rule" << right << setw(8) << "Hits" << endl;
+    out << left << setw(20) << "----" << right << setw(8) << "----" << endl;
+
+    for (const Rule& rule : rules)
+    {
+        out << left << setw(20) << rule.name
+            << right << setw(8) << rule.hits << endl;
+    }
+
+    out << endl << instructionsRemoved << " instructions removed." << endl;
+}
+
+// =====
+// Rules
+// =====
+
+bool PeepholeOptimizer::fuseCompareBranch(size_t index)
+{
+    CodeRecord& compare = (*records)[index];
+    if (!compare.isInstruction()) return false;
+
+    switch (compare.instruction)
+    {
+        case Instruction::IFEQ:
+        case Instruction::IFNE:
+        case Instruction::IFLT:
+        case Instruction::IFLE:
+        case Instruction::IFGT:
+        case Instruction::IFGE:
+        case Instruction::IF_ICMPEQ:
+        case Instruction::IF_ICMPNE:
+        case Instruction::IF_ICMPLT:
+        case Instruction::IF_ICMPLE:
+        case Instruction::IF_ICMPGT:
+        case Instruction::IF_ICMPGE:
+            break;
+
+        default: return false;
+    }
+
+    Label *trueLabel = compare.label;
+
+    size_t falseIndex = next(index);
+    if (!isAt(falseIndex, ICONST_0)) return false;
+
+    size_t gotoIndex = next(falseIndex);
+    if (!isAt(gotoIndex, GOTO)) return false;
+    Label *exitLabel = (*records)[gotoIndex].label;
+
+    size_t trueLabelIndex = next(gotoIndex);
+    if (   (trueLabelIndex == records->size())
+        || ((*records)[trueLabelIndex].kind != RecordKind::LABEL)
+        || ((*records)[trueLabelIndex].label != trueLabel))
+    {
+        return false;
+    }
+
+    size_t trueIndex = next(trueLabelIndex);
+    if (!isAt(trueIndex, ICONST_1)) return false;
+
+    size_t exitLabelIndex = next(trueIndex);
+    if (   (exitLabelIndex == records->size())
+        || ((*records)[exitLabelIndex].kind != RecordKind::LABEL)
+        || ((*records)[exitLabelIndex].label != exitLabel))
+    {
+        return false;
+    }
+
+    size_t testIndex = next(exitLabelIndex);
+    if (!isAt(testIndex, IFEQ) && !isAt(testIndex, IFNE)) return false;
+
+    // Nothing else may branch into the middle of the sequence.
+    if ((references[trueLabel] != 1) || (references[exitLabel] != 1))
+    {
+        return false;
+    }
+
+    // IFNE branches when the comparison is true,
+    // IFEQ branches when it is false.
+    Label *target = (*records)[testIndex].label;
+    if ((*records)[testIndex].is(IFEQ))
+    {
+        compare.instruction = negate(compare.instruction);
+    }
+
+    references[trueLabel]--;
+    references[target]++;
+    compare.label = target;
+
+    kill(falseIndex);
+    kill(gotoIndex);
+    kill(trueLabelIndex);
+    kill(trueIndex);
+    kill(exitLabelIndex);
+    kill(testIndex);
+
+    return true;
+}
+
+bool PeepholeOptimizer::foldConstantBranch(size_t index)
+{
+    if (!isAt(index, ICONST_0) && !isAt(index, ICONST_1)) return false;
+
+    size_t testIndex = next(index);
+    if (!isAt(testIndex, IFEQ) && !isAt(testIndex, IFNE)) return false;
+
+    bool isZero = (*records)[index].is(ICONST_0);
+    bool taken  = (*records)[testIndex].is(IFEQ) ? isZero : !isZero;
+
+    kill(index);
+
+    if (taken) (*records)[testIndex].instruction = GOTO;
+    else       kill(testIndex);
+
+    return true;
+}
+
+bool PeepholeOptimizer::removeStoreLoadReturn(size_t index)
+{
+    char storeType, loadType;
+    int storeSlot, loadSlot;
+
+    if (!decodeLocal((*records)[index], true, storeType, storeSlot))
+    {
+        return false;
+    }
+
+    size_t loadIndex = next(index);
+    if (   (loadIndex == records->size())
+        || !decodeLocal((*records)[loadIndex], false, loadType, loadSlot)
+        || (loadType != storeType) || (loadSlot != storeSlot))
+    {
+        return false;
+    }
+
+    Instruction returnOp = storeType == 'I' ? IRETURN
+                         : storeType == 'F' ? FRETURN
+                         :                    ARETURN;
+    if (!isAt(next(loadIndex), returnOp)) return false;
+
+    // The local variable is dead after the return.
+    kill(index);
+    kill(loadIndex);
+
+    return true;
+}
+
+bool PeepholeOptimizer::replaceStoreLoad(size_t index)
+{
+    char storeType, loadType;
+    int storeSlot, loadSlot;
+
+    if (!decodeLocal((*records)[index], true, storeType, storeSlot))
+    {
+        return false;
+    }
+
+    size_t loadIndex = next(index);
+    if (   (loadIndex == records->size())
+        || !decodeLocal((*records)[loadIndex], false, loadType, loadSlot)
+        || (loadType != storeType) || (loadSlot != storeSlot))
+    {
+        return false;
+    }
+
+    CodeRecord store = (*records)[index];
+    CodeRecord dup(RecordKind::INSTRUCTION);
+    dup.instruction = DUP;
+
+    (*records)[index]     = dup;
+    (*records)[loadIndex] = store;
+
+    return true;
+}
+
+bool PeepholeOptimizer::removeLoadStore(size_t index)
+{
+    char loadType, storeType;
+    int loadSlot, storeSlot;
+
+    if (!decodeLocal((*records)[index], false, loadType, loadSlot))
+    {
+        return false;
+    }
+
+    size_t storeIndex = next(index);
+    if (   (storeIndex == records->size())
+        || !decodeLocal((*records)[storeIndex], true, storeType, storeSlot)
+        || (storeType != loadType) || (storeSlot != loadSlot))
+    {
+        return false;
+    }
+
+    kill(index);
+    kill(storeIndex);
+
+    return true;
+}
+
+bool PeepholeOptimizer::removeGotoNext(size_t index)
+{
+    if (!isAt(index, GOTO)) return false;
+
+    Label *target = (*records)[index].label;
+
+    // Look through any labels that immediately follow.
+    for (size_t i = next(index);
+         (i < records->size()) && ((*records)[i].kind == RecordKind::LABEL);
+         i = next(i))
+    {
+        if ((*records)[i].label == target)
+        {
+            kill(index);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool PeepholeOptimizer::collapseJumpChain(size_t index)
+{
+    CodeRecord& branch = (*records)[index];
+    if (dead[index] || !isBranch(branch)) return false;
+
+    Label *target = branch.label;
+    set<Label *> visited;
+    visited.insert(target);
+
+    // Follow the chain of GOTOs to its end.
+    for (;;)
+    {
+        size_t i = firstInstructionAt(target);
+        if ((i == records->size()) || !(*records)[i].is(GOTO)) break;
+
+        Label *nextTarget = (*records)[i].label;
+        if (visited.find(nextTarget) != visited.end()) return false;  // loop
+
+        visited.insert(nextTarget);
+        target = nextTarget;
+    }
+
+    if (target == branch.label) return false;
+
+    references[branch.label]--;
+    references[target]++;
+    branch.label = target;
+
+    return true;
+}
+
+bool PeepholeOptimizer::removeUnreachable(size_t index)
+{
+    if (dead[index] || !isUnconditional((*records)[index])) return false;
+
+    bool removed = false;
+
+    for (size_t i = next(index);
+         (i < records->size()) && (*records)[i].isInstruction();
+         i = next(i))
+    {
+        kill(i);
+        removed = true;
+    }
+
+    return removed;
+}
+
+bool PeepholeOptimizer::removeDeadLabel(size_t index)
+{
+    const CodeRecord& record = (*records)[index];
+    if (record.kind != RecordKind::LABEL) return false;
+    if (references[record.label] > 0) return false;
+
+    kill(index);
+    return true;
+}
+
+// =========
+// Utilities
+// =========
+
+void PeepholeOptimizer::scanLabels()
+{
+    references.clear();
+    positions.clear();
+
+    for (size_t i = 0; i < records->size(); i++)
+    {
+        const CodeRecord& record = (*records)[i];
+
+        switch (record.kind)
+        {
+            case RecordKind::LABEL:
+                positions[record.label] = i;
+                break;
+
+            case RecordKind::INSTRUCTION:
+                if (isBranch(record)) references[record.label]++;
+                break;
+
+            // Switch table entries also refer to labels.
+            case RecordKind::SWITCH_LABEL:
+            case RecordKind::CASE:
+            case RecordKind::DEFAULT_CASE:
+                references[record.label]++;
+                break;
+
+            default: break;
+        }
+    }
+}
+
+size_t PeepholeOptimizer::next(size_t index) const
+{
+    size_t i = index + 1;
+
+    while (   (i < records->size())
+           && (   dead[i]
+               || ((*records)[i].kind == RecordKind::COMMENT)
+               || ((*records)[i].kind == RecordKind::BLANK_LINE)))
+    {
+        i++;
+    }
+
+    return i;
+}
+
+size_t PeepholeOptimizer::firstInstructionAt(Label *label) const
+{
+    auto it = positions.find(label);
+    if ((it == positions.end()) || dead[it->second]) return records->size();
+
+    size_t i = it->second;
+    while (   (i < records->size())
+           && ((*records)[i].kind == RecordKind::LABEL))
+    {
+        i = next(i);
+    }
+
+    return i;
+}
+
+void PeepholeOptimizer::kill(size_t index)
+{
+    const CodeRecord& record = (*records)[index];
+
+    if (record.kind == RecordKind::LABEL) positions.erase(record.label);
+    else if (record.isInstruction())
+    {
+        if (isBranch(record)) references[record.label]--;
+        instructionsRemoved++;
+    }
+
+    dead[index] = true;
+}
+
+bool PeepholeOptimizer::isAt(size_t index, Instruction op) const
+{
+    return (index < records->size()) && !dead[index]
+                                     && (*records)[index].is(op);
+}
+
+bool PeepholeOptimizer::decodeLocal(const CodeRecord& record, bool store,
+                                    char& type, int& slot)
+{
+    if (!record.isInstruction()) return false;
+
+    static const Instruction LOADS[] =
+    {
+        ILOAD_0, ILOAD_1, ILOAD_2, ILOAD_3,
+        FLOAD_0, FLOAD_1, FLOAD_2, FLOAD_3,
+        ALOAD_0, ALOAD_1, ALOAD_2, ALOAD_3
+    };
+    static const Instruction STORES[] =
+    {
+        ISTORE_0, ISTORE_1, ISTORE_2, ISTORE_3,
+        FSTORE_0, FSTORE_1, FSTORE_2, FSTORE_3,
+        ASTORE_0, ASTORE_1, ASTORE_2, ASTORE_3
+    };
+    static const char TYPES[] = { 'I', 'F', 'A' };
+
+    const Instruction *shortForms = store ? STORES : LOADS;
+    for (int i = 0; i < 12; i++)
+    {
+        if (record.instruction == shortForms[i])
+        {
+            type = TYPES[i/4];
+            slot = i%4;
+            return true;
+        }
+    }
+
+    if (record.form != OperandForm::INTEGER) return false;
+    slot = record.operands[0];
+
+    switch (record.instruction)
+    {
+        case Instruction::ILOAD:  type = 'I'; return !store;
+        case Instruction::FLOAD:  type = 'F'; return !store;
+        case Instruction::ALOAD:  type = 'A'; return !store;
+        case Instruction::ISTORE: type = 'I'; return store;
+        case Instruction::FSTORE: type = 'F'; return store;
+        case Instruction::ASTORE: type = 'A'; return store;
+        default: return false;
+    }
+}
+
+bool PeepholeOptimizer::isBranch(const CodeRecord& record)
+{
+    return record.isInstruction() && (record.form == OperandForm::LABEL);
+}
+
+bool PeepholeOptimizer::isUnconditional(const CodeRecord& record)
+{
+    if (!record.isInstruction()) return false;
+
+    switch (record.instruction)
+    {
+        case Instruction::GOTO:
+        case Instruction::LOOKUPSWITCH:
+        case Instruction::RETURN:
+        case Instruction::IRETURN:
+        case Instruction::FRETURN:
+        case Instruction::ARETURN:
+        case Instruction::LRETURN:
+            return true;
+
+        default: return false;
+    }
+}
+
+Instruction PeepholeOptimizer::negate(Instruction op)
+{
+    switch (op)
+    {
+        case Instruction::IFEQ:      return IFNE;
+        case Instruction::IFNE:      return IFEQ;
+        case Instruction::IFLT:      return IFGE;
+        case Instruction::IFGE:      return IFLT;
+        case Instruction::IFGT:      return IFLE;
+        case Instruction::IFLE:      return IFGT;
+        case Instruction::IF_ICMPEQ: return IF_ICMPNE;
+        case Instruction::IF_ICMPNE: return IF_ICMPEQ;
+        case Instruction::IF_ICMPLT: return IF_ICMPGE;
+        case Instruction::IF_ICMPGE: return IF_ICMPLT;
+        case Instruction::IF_ICMPGT: return IF_ICMPLE;
+        case Instruction::IF_ICMPLE: return IF_ICMPGT;
+        default:                     return op;
+    }
+}
+
+}} // namespace backend::compiler
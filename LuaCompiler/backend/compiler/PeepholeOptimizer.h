@@ -0,0 +1,204 @@
+/**
+ * <h1>PeepholeOptimizer</h1>
+ *
+ * <p>Rewrite short instruction sequences of a method's code
+ * into shorter or faster equivalents.</p>
+ */
+#ifndef PEEPHOLEOPTIMIZER_H_
+#define PEEPHOLEOPTIMIZER_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+
+#include "MethodCode.h"
+
+namespace backend { namespace compiler {
+
+using namespace std;
+
+class PeepholeOptimizer
+{
+private:
+    typedef bool (PeepholeOptimizer::*RuleFunction)(size_t index);
+
+    /**
+     * An entry of the pattern table.
+     */
+    class Rule
+    {
+    public:
+        string name;         // rule name for the statistics
+        RuleFunction apply;  // match and rewrite at a record index
+        int hits;            // count of rewrites
+
+        Rule(string name, RuleFunction apply)
+            : name(name), apply(apply), hits(0) {}
+    };
+
+    vector<Rule> rules;         // the pattern table
+    int instructionsRemoved;    // total count of removed instructions
+
+    vector<CodeRecord> *records;      // records of the method being optimized
+    vector<bool> dead;                // true for each removed record
+    map<Label *, int> references;     // count of branches to each label
+    map<Label *, size_t> positions;   // record index of each label
+
+public:
+    /**
+     * Constructor.
+     */
+    PeepholeOptimizer();
+
+    /**
+     * Optimize the code of a method.
+     * @param code the method code.
+     */
+    void optimize(MethodCode& code);
+
+    /**
+     * Get the count of removed instructions.
+     * @return the count.
+     */
+    int getInstructionsRemoved() const { return instructionsRemoved; }
+
+    /**
+     * Add the rule hits and removals of another optimizer to this one's.
+     * @param other the other optimizer.
+     */
+    void addStatistics(const PeepholeOptimizer& other);
+
+    /**
+     * Print the hit count of each rule.
+     * @param out the output stream.
+     */
+    void printStatistics(ostream& out) const;
+
+private:
+    // =====
+    // Rules
+    // =====
+
+    /**
+     * IFxx|IF_ICMPxx T / ICONST_0 / GOTO E / T: ICONST_1 / E: IFEQ|IFNE F
+     * becomes a single IFxx|IF_ICMPxx (possibly negated) to F.
+     */
+    bool fuseCompareBranch(size_t index);
+
+    /**
+     * ICONST_0|ICONST_1 / IFEQ|IFNE F becomes GOTO F or nothing.
+     */
+    bool foldConstantBranch(size_t index);
+
+    /**
+     * xSTORE n / xLOAD n / xRETURN becomes xRETURN.
+     */
+    bool removeStoreLoadReturn(size_t index);
+
+    /**
+     * xSTORE n / xLOAD n becomes DUP / xSTORE n.
+     */
+    bool replaceStoreLoad(size_t index);
+
+    /**
+     * xLOAD n / xSTORE n is removed.
+     */
+    bool removeLoadStore(size_t index);
+
+    /**
+     * GOTO L immediately followed by L: is removed.
+     */
+    bool removeGotoNext(size_t index);
+
+    /**
+     * A branch to L where L: GOTO M is retargeted to M.
+     */
+    bool collapseJumpChain(size_t index);
+
+    /**
+     * Instructions between an unconditional transfer and the next
+     * label can never execute and are removed.
+     */
+    bool removeUnreachable(size_t index);
+
+    /**
+     * A label that no instruction branches to is removed.
+     */
+    bool removeDeadLabel(size_t index);
+
+    // =========
+    // Utilities
+    // =========
+
+    /**
+     * Compute the reference count and position of each label.
+     */
+    void scanLabels();
+
+    /**
+     * Find the next live code record after a given index,
+     * skipping comments and blank lines.
+     * @param index the starting index.
+     * @return the index of the next code record, or the record count.
+     */
+    size_t next(size_t index) const;
+
+    /**
+     * Find the first instruction at or after a label,
+     * skipping any other labels.
+     * @param label the label.
+     * @return the index of the instruction, or the record count.
+     */
+    size_t firstInstructionAt(Label *label) const;
+
+    /**
+     * Remove a record.
+     * @param index the index of the record.
+     */
+    void kill(size_t index);
+
+    /**
+     * Check whether an index is a live instruction with a given opcode.
+     * @param index the index.
+     * @param op the operation code.
+     * @return true if so, else false.
+     */
+    bool isAt(size_t index, Instruction op) const;
+
+    /**
+     * Decode a local variable load or store instruction.
+     * @param record the instruction record.
+     * @param store true to decode a store, false to decode a load.
+     * @param type set to the type letter: 'I', 'F' or 'A'.
+     * @param slot set to the local variable slot number.
+     * @return true if the record is such an instruction, else false.
+     */
+    static bool decodeLocal(const CodeRecord& record, bool store,
+                            char& type, int& slot);
+
+    /**
+     * Check whether an instruction branches to a label.
+     * @param record the instruction record.
+     * @return true if it does, else false.
+     */
+    static bool isBranch(const CodeRecord& record);
+
+    /**
+     * Check whether control never falls through an instruction.
+     * @param record the instruction record.
+     * @return true if it never does, else false.
+     */
+    static bool isUnconditional(const CodeRecord& record);
+
+    /**
+     * Return the compare-and-branch with the opposite condition.
+     * @param op the compare-and-branch operation code.
+     * @return the negated operation code.
+     */
+    static Instruction negate(Instruction op);
+};
+
+}}  // namespace backend::compiler
+
+#endif /* PEEPHOLEOPTIMIZER_H_ */
@@ -1,8 +1,13 @@
 #include <vector>
+#include <mutex>
+#include <memory>
+#include <cstdio>
 
 #include "LuaBaseVisitor.h"
 #include "antlr4-runtime.h"
 
+#include "intermediate/util/WorkStealingPool.h"
+#include "intermediate/util/Tracer.h"
 #include "Directive.h"
 #include "Instruction.h"
 #include "Compiler.h"
@@ -11,10 +16,11 @@
 namespace backend { namespace compiler {
 
 using namespace std;
+using namespace intermediate::util;
 
-void ProgramGenerator::emitProgram(LuaParser::ChunkContext *ctx)
+void ProgramGenerator::emitProgram(const ProgramNode *program)
 {
-    localVariables = new LocalVariables(programLocalsCount);
+    localVariables.reset(new LocalVariables(programLocalsCount));
 
     emitDirective(CLASS_PUBLIC, programName);
     emitDirective(SUPER, "java/lang/Object");
@@ -23,14 +29,27 @@ void ProgramGenerator::emitProgram(LuaParser::ChunkContext *ctx)
     emitInputScanner();
     emitConstructor();
 
-    int i = 0;
+    vector<const RoutineNode *> routines;
 
-    while (ctx->block()->stat(i)->functiondef() != nullptr){
-    	emitRoutine(ctx->block()->stat(i)->functiondef());
-    	i++;
+    for (const RoutineNode *routine = program->routines; routine != nullptr;
+         routine = routine->next)
+    {
+    	routines.push_back(routine);
     }
 
-    emitMainMethod(ctx);
+    if ((options.routineJobs > 1) && (routines.size() > 1))
+    {
+    	emitRoutinesInParallel(routines);
+    }
+    else
+    {
+    	for (const RoutineNode *routine : routines)
+    	{
+    		emitRoutine(routine);
+    	}
+    }
+
+    emitMainMethod(program);
 }
 
 void ProgramGenerator::emitProgramVariables()
@@ -42,6 +61,25 @@ void ProgramGenerator::emitProgramVariables()
     emitLine();
     emitDirective(FIELD_PRIVATE_STATIC, "_sysin", "Ljava/util/Scanner;");
 
+    // Runtime timer, and a call counter and timer for each function.
+    if (options.timing != RuntimeTiming::OFF)
+    {
+        emitDirective(FIELD_PRIVATE_STATIC, "_start", "J");
+    }
+    if (options.timing == RuntimeTiming::NS)
+    {
+        for (SymtabEntry *id : ids)
+        {
+            if (id->getKind() == FUNCTION)
+            {
+                emitDirective(FIELD_PRIVATE_STATIC,
+                              "_calls_" + id->getName(), "I");
+                emitDirective(FIELD_PRIVATE_STATIC,
+                              "_nanos_" + id->getName(), "J");
+            }
+        }
+    }
+
     // Loop over all the program's identifiers and
     // emit a .field directive for each variable.
     for (SymtabEntry *id : ids)
@@ -72,8 +110,6 @@ void ProgramGenerator::emitInputScanner()
     emitDirective(LIMIT_LOCALS, 0);
     emitDirective(LIMIT_STACK,  3);
     emitDirective(END_METHOD);
-
-    localStack->reset();
 }
 
 void ProgramGenerator::emitConstructor()
@@ -92,12 +128,12 @@ void ProgramGenerator::emitConstructor()
     emitDirective(LIMIT_LOCALS, 1);
     emitDirective(LIMIT_STACK,  1);
     emitDirective(END_METHOD);
-
-    localStack->reset();
 }
 
-void ProgramGenerator::emitMainMethod(LuaParser::ChunkContext *ctx)
+void ProgramGenerator::emitMainMethod(const ProgramNode *program)
 {
+    TraceSpan span("codegen", "ProgramGenerator::emitMainMethod");
+
     emitLine();
     emitComment("MAIN");
     emitDirective(METHOD_PUBLIC_STATIC,
@@ -106,11 +142,9 @@ void ProgramGenerator::emitMainMethod(LuaParser::ChunkContext *ctx)
     emitMainPrologue(programId);
     emitLine();
 
-    for (long unsigned int i=0; i<ctx->block()->children.size(); i++){
-    	if (ctx->block()->stat(i)->functiondef() == nullptr)
-    		compiler->visitChildren(ctx->block()->stat(i));
-    }
+    compiler->compileBlock(program->block);
 
+    if (methodCode->hasExitLabel()) emitLabel(methodCode->getExitLabel());
     emitComment("END MAIN");
     emitMainEpilogue(programLocalsCount);
 }
@@ -118,84 +152,250 @@ void ProgramGenerator::emitMainMethod(LuaParser::ChunkContext *ctx)
 void ProgramGenerator::emitMainPrologue(SymtabEntry *programId)
 {
     emitDirective(VAR, "0 is args [Ljava/lang/String;");
-    emitDirective(VAR, "1 is _start Ljava/time/Instant;");
-    emitDirective(VAR, "2 is _end Ljava/time/Instant;");
-    emitDirective(VAR, "3 is _elapsed J");
+
+    // A dynamic variable is nil until it is assigned, but
+    // a long field starts as 0, which is the tagged double 0.0.
+    for (SymtabEntry *id : programId->getRoutineSymtab()->sortedEntries())
+    {
+        if ((id->getKind() == VARIABLE) && isTagged(id->getType()))
+        {
+            emitLoadDefault(id->getType());
+            emit(PUTSTATIC, programName + "/" + id->getName(),
+                 typeDescriptor(id));
+        }
+    }
 
     // Runtime timer.
-    emitLine();
-    emit(INVOKESTATIC, "java/time/Instant/now()Ljava/time/Instant;");
-    localStack->increase(1);
-    emit(ASTORE_1);
+    if (options.timing != RuntimeTiming::OFF)
+    {
+        emitLine();
+        emit(INVOKESTATIC, "java/lang/System/nanoTime()J");
+        emit(PUTSTATIC, programName + "/_start J");
+    }
 }
 
 void ProgramGenerator::emitMainEpilogue(int max_local_vars)
 {
+    // Programs time themselves only on request. The runtime
+    // benchmark harness measures them from outside instead.
+    emitTimingReport();
+
+    emitLine();
+    emit(RETURN);
+    emitLine();
+
+
+    emitDirective(LIMIT_LOCALS, localVariables->count() + max_local_vars);
+    emitDirective(LIMIT_STACK,  0);  // set by the stack analyzer
+    emitDirective(END_METHOD);
+
+    close();  // the object file
+}
+
+void ProgramGenerator::emitTimingReport()
+{
+    if (options.timing == RuntimeTiming::OFF) return;
+
+    bool nanos = options.timing == RuntimeTiming::NS;
+
     // Print the execution time.
     emitLine();
-    emit(INVOKESTATIC, "java/time/Instant/now()Ljava/time/Instant;");
-    localStack->increase(1);
-    emit(ASTORE_2);
-    emit(ALOAD_1);
-    emit(ALOAD_2);
-    emit(INVOKESTATIC,
-         string("java/time/Duration/between(Ljava/time/temporal/Temporal;") +
-         string("Ljava/time/temporal/Temporal;)Ljava/time/Duration;"));
-    localStack->decrease(1);
-    emit(INVOKEVIRTUAL, "java/time/Duration/toMillis()J");
-    localStack->increase(1);
-    emit(LSTORE_3);
-    emit(GETSTATIC, "java/lang/System/out Ljava/io/PrintStream;");
-    emit(LDC, "\"\\n[%,d milliseconds execution time.]\\n\"");
-    emit(ICONST_1);
+    emitPrintf(nanos ? "%n[%,d nanoseconds execution time.]%n"
+                     : "%n[%,d milliseconds execution time.]%n",
+               1, [this, nanos] (int)
+    {
+        emit(INVOKESTATIC, "java/lang/System/nanoTime()J");
+        emit(GETSTATIC, programName + "/_start J");
+        emit(LSUB);
+
+        if (!nanos)
+        {
+            emit(INVOKESTATIC,
+                 "java/time/Duration/ofNanos(J)Ljava/time/Duration;");
+            emit(INVOKEVIRTUAL, "java/time/Duration/toMillis()J");
+        }
+
+        emit(INVOKESTATIC, "java/lang/Long/valueOf(J)Ljava/lang/Long;");
+    });
+
+    if (!nanos) return;
+
+    vector<SymtabEntry *> functionIds;
+    for (SymtabEntry *id : programId->getRoutineSymtab()->sortedEntries())
+    {
+        if (id->getKind() == FUNCTION) functionIds.push_back(id);
+    }
+    if (functionIds.empty()) return;
+
+    // Print the call count and time of each function. The time of a
+    // call includes the calls that it makes, and so recursive calls
+    // are counted again for each enclosing call.
+    char line[160];
+    snprintf(line, sizeof(line), "%%n%-24s %14s %18s%%n",
+             "Function", "Calls", "Nanoseconds");
+    emitPrintf(line, 0, nullptr);
+
+    for (SymtabEntry *id : functionIds)
+    {
+        string name = id->getName();
+
+        snprintf(line, sizeof(line), "%-24s %%,14d %%,18d%%n", name.c_str());
+        emitPrintf(line, 2, [this, &name] (int i)
+        {
+            if (i == 0)
+            {
+                emit(GETSTATIC, programName + "/_calls_" + name + " I");
+                emit(INVOKESTATIC,
+                     "java/lang/Integer/valueOf(I)Ljava/lang/Integer;");
+            }
+            else
+            {
+                emit(GETSTATIC, programName + "/_nanos_" + name + " J");
+                emit(INVOKESTATIC,
+                     "java/lang/Long/valueOf(J)Ljava/lang/Long;");
+            }
+        });
+    }
+}
+
+void ProgramGenerator::emitPrintf(const string& format, int arguments,
+                                  const function<void (int)>& pushArgument)
+{
+    // The report goes to the standard error, apart from the output.
+    emit(GETSTATIC, "java/lang/System/err Ljava/io/PrintStream;");
+    emit(LDC, "\"" + format + "\"");
+    emitLoadConstant(arguments);
     emit(ANEWARRAY, "java/lang/Object");
-    emit(DUP);
-    emit(ICONST_0);
-    emit(LLOAD_3);
-    emit(INVOKESTATIC, "java/lang/Long/valueOf(J)Ljava/lang/Long;");
-    emit(AASTORE);
+
+    for (int i = 0; i < arguments; i++)
+    {
+        emit(DUP);
+        emitLoadConstant(i);
+        pushArgument(i);
+        emit(AASTORE);
+    }
+
     emit(INVOKEVIRTUAL,
          string("java/io/PrintStream/printf(Ljava/lang/String;") +
          string("[Ljava/lang/Object;)Ljava/io/PrintStream;"));
-    localStack->decrease(2);
     emit(POP);
+}
 
-    emitLine();
-    emit(RETURN);
-    emitLine();
+void ProgramGenerator::emitRoutineProfileEntry(const string& routineName)
+{
+    string calls = programName + "/_calls_" + routineName + " I";
+    string nanos = programName + "/_nanos_" + routineName + " J";
 
+    // Count the call, and subtract the start time from the
+    // total so that adding the end time adds the elapsed time.
+    emitLine();
+    emit(GETSTATIC, calls);
+    emit(ICONST_1);
+    emit(IADD);
+    emit(PUTSTATIC, calls);
+    emit(GETSTATIC, nanos);
+    emit(INVOKESTATIC, "java/lang/System/nanoTime()J");
+    emit(LSUB);
+    emit(PUTSTATIC, nanos);
+}
 
-    emitDirective(LIMIT_LOCALS, localVariables->count() + max_local_vars);
-    emitDirective(LIMIT_STACK,  localStack->capacity());
-    emitDirective(END_METHOD);
+void ProgramGenerator::emitRoutineProfileExit(const string& routineName)
+{
+    string nanos = programName + "/_nanos_" + routineName + " J";
 
-    close();  // the object file
+    emitLine();
+    emit(GETSTATIC, nanos);
+    emit(INVOKESTATIC, "java/lang/System/nanoTime()J");
+    emit(LADD);
+    emit(PUTSTATIC, nanos);
 }
 
-void ProgramGenerator::emitRoutine(LuaParser::FunctiondefContext *ctx)
+void ProgramGenerator::emitRoutine(const RoutineNode *routine)
 {
-	string routineName = ctx->funcname()->getText();
-    SymtabEntry *routineId = programId->getRoutineSymtab()->lookup(routineName);
+    SymtabEntry *routineId = routine->entry;
+    const string& routineName = routineId->getName();
+    TraceSpan span("codegen", "ProgramGenerator::emitRoutine", routineName);
+    span.arg("line", (long) routine->line);
+
     Symtab *routineSymtab = routineId->getRoutineSymtab();
 
     emitRoutineHeader(routineId);
     emitRoutineLocals(routineId);
-    localVariables = new LocalVariables(routineSymtab->getMaxSlotNumber());
+    localVariables.reset(
+        new LocalVariables(routineSymtab->getMaxSlotNumber()));
+    emitLocalsInitialization(routineId);
+
+    bool profile =    (options.timing == RuntimeTiming::NS)
+                   && (routineId->getKind() == FUNCTION);
+    if (profile) emitRoutineProfileEntry(routineName);
 
     // Emit code for the compound statement.
-    LuaParser::BlockContext *blockCtx = (LuaParser::BlockContext *) routineId->getExecutable();
-    compiler->visit(blockCtx);
+    compiler->compileBlock(routine->block);
 
+    // The returns branch here, so that the exit is profiled too.
+    if (methodCode->hasExitLabel()) emitLabel(methodCode->getExitLabel());
+    if (profile) emitRoutineProfileExit(routineName);
 
     emitRoutineReturn(routineId);
     emitRoutineEpilogue();
 }
 
+void ProgramGenerator::emitRoutinesInParallel(
+                        const vector<const RoutineNode *>& routines)
+{
+    int count = routines.size();
+    vector<vector<MethodCode>> codes(count);
+    mutex statisticsLock;
+
+    {
+        WorkStealingPool pool(min(options.routineJobs, count));
+
+        for (int i = 0; i < count; i++)
+        {
+            pool.submit([&, i] (int worker)
+            {
+                // Private code buffer, analyzers, local variables
+                // and label numbering for this routine.
+                MethodCode routineCode;
+                StackAnalyzer routineStack;
+                unique_ptr<PeepholeOptimizer> routinePeephole(
+                    peephole != nullptr ? new PeepholeOptimizer() : nullptr);
+
+                CodeGenerator routineGenerator(this, &routineCode,
+                                               &routineStack,
+                                               routinePeephole.get(),
+                                               &codes[i]);
+                Compiler routineCompiler(compiler, &routineGenerator);
+                routineCompiler.compileRoutine(routines[i]);
+
+                lock_guard<mutex> guard(statisticsLock);
+                stackAnalyzer->addErrors(routineStack);
+                if (routinePeephole != nullptr)
+                {
+                    peephole->addStatistics(*routinePeephole);
+                }
+            });
+        }
+
+        pool.wait();
+    }
+
+    // Splice the routines in source order, the same as a serial build.
+    for (vector<MethodCode>& code : codes) splice(code);
+}
+
 void ProgramGenerator::emitRoutineHeader(SymtabEntry *routineId)
 {
     string routineName = routineId->getName();
 
     string header(routineName + "(");
+    SymtabEntries *parmIds = routineId->getRoutineParameters();
+
+    if (parmIds != nullptr)
+    {
+        for (SymtabEntry *parmId : *parmIds) header += typeDescriptor(parmId);
+    }
+
     header += ")" + typeDescriptor(routineId);
     emitLine();
     emitComment("FUNCTION " + routineName);
@@ -216,15 +416,29 @@ void ProgramGenerator::emitRoutineLocals(SymtabEntry *routineId)
     {
         Kind kind = id->getKind();
 
-        if ((kind == VARIABLE) || (kind == TYPE))
+        if ((kind == VARIABLE) || (kind == VALUE_PARAMETER))
         {
-            int i = 0;
-            emitDirective(VAR, (i++) + " is " + id->getName(),
+            emitDirective(VAR, to_string(id->getSlotNumber()) + " is "
+                               + id->getName(),
                           typeDescriptor(id));
         }
     }
 }
 
+void ProgramGenerator::emitLocalsInitialization(SymtabEntry *routineId)
+{
+    // A variable is nil until it is assigned. Giving each one its
+    // initial value also lets the verifier see it set on every path.
+    for (SymtabEntry *id : routineId->getRoutineSymtab()->sortedEntries())
+    {
+        if (id->getKind() == VARIABLE)
+        {
+            emitLoadDefault(id->getType());
+            emitStoreLocal(id->getType(), id->getSlotNumber());
+        }
+    }
+}
+
 void ProgramGenerator::emitRoutineReturn(SymtabEntry *routineId)
 {
     emitLine();
@@ -237,8 +451,8 @@ void ProgramGenerator::emitRoutineReturn(SymtabEntry *routineId)
         // Get the slot number of the function variable.
         string varName = routineId->getName();
         SymtabEntry *varId = routineId->getRoutineSymtab()->lookup(varName);
-        emitStoreLocal(type, varId->getSlotNumber());
-        emitLoadLocal(type, varId->getSlotNumber());
+        emitLoadLocal(varId->getType(), varId->getSlotNumber());
+        emitConvert(varId->getType(), type);
         emitReturnValue(type);
     }
 
@@ -250,7 +464,7 @@ void ProgramGenerator::emitRoutineEpilogue()
 {
     emitLine();
     emitDirective(LIMIT_LOCALS, localVariables->count());
-    emitDirective(LIMIT_STACK,  localStack->capacity());
+    emitDirective(LIMIT_STACK,  0);  // set by the stack analyzer
     emitDirective(END_METHOD);
 }
 
@@ -1,10 +1,15 @@
 #ifndef PROGRAMGENERATOR_H_
 #define PROGRAMGENERATOR_H_
 
+#include <functional>
+
 #include "CodeGenerator.h"
+#include "intermediate/ast/StatNode.h"
 
 namespace backend { namespace compiler {
 
+using namespace intermediate::ast;
+
 class ProgramGenerator : public CodeGenerator
 {
 private:
@@ -21,22 +26,28 @@ public:
      */
     ProgramGenerator(CodeGenerator *parent, Compiler *compiler, SymtabEntry *pid)
         : CodeGenerator(parent, compiler),
-          programId(pid), programLocalsCount(5), programFuncCount(0) // 5 because _elapsed is long
+          programId(pid), programLocalsCount(1), programFuncCount(0) // only args
     {
-        localStack = new LocalStack();
     }
 
     /*
      * Emit code for a program.
-     * @param *ctx the ProgramContext.
+     * @param program the program node.
      */
-    void emitProgram(LuaParser::ChunkContext *ctx);
+    void emitProgram(const ProgramNode *program);
 
     /*
      * Emit code for a declared procedure or function
-     * @param routineId the symbol table entry of the routine's name.
+     * @param routine the routine node.
+     */
+    void emitRoutine(const RoutineNode *routine);
+
+    /*
+     * Emit code for the routines on worker threads, each into its own
+     * buffer, and then write the buffers in source order.
+     * @param routines the routine nodes.
      */
-    void emitRoutine(LuaParser::FunctiondefContext *ctx);
+    void emitRoutinesInParallel(const vector<const RoutineNode *>& routines);
 
 private:
     /*
@@ -61,9 +72,9 @@ private:
 //
 //    /*
 //     * Emit code for the program body as the main method.
-//     * @param *ctx the ProgramContext.
+//     * @param program the program node.
 //     */
-    void emitMainMethod(LuaParser::ChunkContext *ctx);
+    void emitMainMethod(const ProgramNode *program);
 
     /*
      * Emit the main method prologue.
@@ -76,6 +87,32 @@ private:
      */
     void emitMainEpilogue(int max_local_vars);
 
+    /*
+     * Emit the report of the runtime timing, if any, at the end of main.
+     */
+    void emitTimingReport();
+
+    /*
+     * Emit code that prints a formatted line to the standard error.
+     * @param format the format string, without quotes.
+     * @param arguments the count of arguments.
+     * @param pushArgument emits code that pushes argument i as an Object.
+     */
+    void emitPrintf(const string& format, int arguments,
+                    const function<void (int)>& pushArgument);
+
+    /*
+     * Emit code that counts a call of a routine and starts its timer.
+     * @param routineName the routine's name.
+     */
+    void emitRoutineProfileEntry(const string& routineName);
+
+    /*
+     * Emit code that stops a routine's timer.
+     * @param routineName the routine's name.
+     */
+    void emitRoutineProfileExit(const string& routineName);
+
     /*
      * Emit the routine header.
      * @param routineId the symbol table entry of the routine's name.
@@ -88,6 +125,12 @@ private:
      */
     void emitRoutineLocals(SymtabEntry *routineId);
 
+    /*
+     * Emit code to give each local variable its initial value.
+     * @param routineId the symbol table entry of the routine's name.
+     */
+    void emitLocalsInitialization(SymtabEntry *routineId);
+
     /*
      * Emit the routine's return code.
      * @param routineId the symbol table entry of the routine's name.
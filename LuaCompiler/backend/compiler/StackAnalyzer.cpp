@@ -0,0 +1,247 @@
+/**
+ * <h1>StackAnalyzer</h1>
+ *
+ * <p>Compute the exact operand stack depth of a method by following
+ * its control flow, and set the method's .limit stack.</p>
+ */
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+
+#include "StackAnalyzer.h"
+
+namespace backend { namespace compiler {
+
+using namespace std;
+
+int StackAnalyzer::analyze(MethodCode& methodCode)
+{
+    vector<CodeRecord>& records = methodCode.getRecords();
+
+    code = &methodCode;
+    methodName = "";
+    positions.clear();
+    depths.assign(records.size(), -1);
+
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        const CodeRecord& record = records[i];
+
+        if (record.kind == RecordKind::LABEL) positions[record.label] = i;
+        else if (   (record.kind == RecordKind::DIRECTIVE)
+                 && (record.form == OperandForm::TEXT)
+                 && (   (record.directive == METHOD_PUBLIC)
+                     || (record.directive == METHOD_STATIC)
+                     || (record.directive == METHOD_PUBLIC_STATIC)
+                     || (record.directive == METHOD_PRIVATE_STATIC)))
+        {
+            string header = methodCode.getText(record.operands[0]);
+            methodName = header.substr(0, header.find('('));
+        }
+    }
+
+    // Follow each path from the method entry and every branch target.
+    vector<pair<size_t, int>> worklist;
+    worklist.push_back(make_pair(0, 0));
+    int maxDepth = 0;
+
+    while (!worklist.empty())
+    {
+        pair<size_t, int> start = worklist.back();
+        worklist.pop_back();
+
+        maxDepth = max(maxDepth, follow(start.first, start.second, worklist));
+    }
+
+    for (CodeRecord& record : records)
+    {
+        if (   (record.kind == RecordKind::DIRECTIVE)
+            && (record.directive == LIMIT_STACK))
+        {
+            record.operands[0] = maxDepth;
+        }
+    }
+
+    code = nullptr;
+    return maxDepth;
+}
+
+int StackAnalyzer::follow(size_t start, int depth,
+                          vector<pair<size_t, int>>& worklist)
+{
+    const vector<CodeRecord>& records = code->getRecords();
+    int maxDepth = depth;
+
+    for (size_t i = start; i < records.size(); i++)
+    {
+        const CodeRecord& record = records[i];
+
+        // Falling through into code that was already followed.
+        if (record.kind == RecordKind::LABEL)
+        {
+            if ((i != start) && !reach(i, depth)) break;
+            continue;
+        }
+
+        if (!record.isInstruction()) continue;
+
+        depth += stackEffect(*code, record);
+        if (depth < 0)
+        {
+            ostringstream message;
+            message << "Stack underflow at " << record.instruction;
+            error(message.str());
+            depth = 0;
+        }
+        maxDepth = max(maxDepth, depth);
+
+        if (record.is(LOOKUPSWITCH))
+        {
+            // Branch to each case label and the default label.
+            for (size_t j = i + 1; j < records.size(); j++)
+            {
+                const CodeRecord& entry = records[j];
+
+                if (   (entry.kind == RecordKind::CASE)
+                    || (entry.kind == RecordKind::SWITCH_LABEL)
+                    || (entry.kind == RecordKind::DEFAULT_CASE))
+                {
+                    auto it = positions.find(entry.label);
+                    if (it == positions.end())
+                    {
+                        error("Undefined label " + entry.label->getString());
+                    }
+                    else if (reach(it->second, depth))
+                    {
+                        worklist.push_back(make_pair(it->second, depth));
+                    }
+                }
+
+                if (entry.kind == RecordKind::DEFAULT_CASE) break;
+            }
+
+            break;
+        }
+
+        if (record.form == OperandForm::LABEL)
+        {
+            auto it = positions.find(record.label);
+            if (it == positions.end())
+            {
+                error("Undefined label " + record.label->getString());
+            }
+            else if (reach(it->second, depth))
+            {
+                worklist.push_back(make_pair(it->second, depth));
+            }
+        }
+
+        // Control never falls through these.
+        if (   record.is(GOTO)    || record.is(RETURN)
+            || record.is(IRETURN) || record.is(FRETURN)
+            || record.is(ARETURN) || record.is(LRETURN))
+        {
+            break;
+        }
+    }
+
+    return maxDepth;
+}
+
+bool StackAnalyzer::reach(size_t index, int depth)
+{
+    if (depths[index] < 0)
+    {
+        depths[index] = depth;
+        return true;
+    }
+
+    if (depths[index] != depth)
+    {
+        error("Stack depths " + to_string(depths[index]) + " and "
+              + to_string(depth) + " merge at label "
+              + code->getRecords()[index].label->getString());
+    }
+
+    return false;
+}
+
+void StackAnalyzer::error(const string& message)
+{
+    cout << "ERROR: " << message << " in method " << methodName << "."
+         << endl;
+    errorCount++;
+}
+
+int StackAnalyzer::stackEffect(const MethodCode& code,
+                               const CodeRecord& record)
+{
+    switch (record.instruction)
+    {
+        case Instruction::GETSTATIC:
+        case Instruction::GETFIELD:
+        case Instruction::PUTSTATIC:
+        case Instruction::PUTFIELD:
+        {
+            // The field descriptor follows the blank.
+            string descriptor =
+                record.form == OperandForm::TEXT_PAIR
+                    ? code.getText(record.operands[1])
+                    : code.getText(record.operands[0]);
+            size_t position = descriptor.rfind(' ') + 1;
+            int words = typeWords(descriptor, position);
+
+            return record.is(GETSTATIC) ?  words
+                 : record.is(GETFIELD)  ?  words - 1
+                 : record.is(PUTSTATIC) ? -words
+                 :                        -words - 1;
+        }
+
+        case Instruction::INVOKESTATIC:
+        case Instruction::INVOKESPECIAL:
+        case Instruction::INVOKEVIRTUAL:
+        case Instruction::INVOKENONVIRTUAL:
+        {
+            string descriptor = code.getText(record.operands[0]);
+            size_t position = descriptor.find('(') + 1;
+            int effect = record.is(INVOKESTATIC) ? 0 : -1;  // the receiver
+
+            while (descriptor[position] != ')')
+            {
+                effect -= typeWords(descriptor, position);
+            }
+            position++;
+
+            return effect + typeWords(descriptor, position);
+        }
+
+        case Instruction::MULTIANEWARRAY:
+            return 1 - stoi(code.getText(record.operands[1]));
+
+        default: return stackUse(record.instruction);
+    }
+}
+
+int StackAnalyzer::typeWords(const string& descriptor, size_t& position)
+{
+    char ch = descriptor[position++];
+
+    switch (ch)
+    {
+        case 'J': case 'D': return 2;
+        case 'V':           return 0;
+
+        case 'L':
+            position = descriptor.find(';', position) + 1;
+            return 1;
+
+        case '[':
+            while (descriptor[position] == '[') position++;
+            typeWords(descriptor, position);
+            return 1;
+
+        default: return 1;
+    }
+}
+
+}} // namespace backend::compiler
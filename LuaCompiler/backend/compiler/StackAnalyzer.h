@@ -0,0 +1,104 @@
+/**
+ * <h1>StackAnalyzer</h1>
+ *
+ * <p>Compute the exact operand stack depth of a method by following
+ * its control flow, and set the method's .limit stack.</p>
+ */
+#ifndef STACKANALYZER_H_
+#define STACKANALYZER_H_
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "MethodCode.h"
+
+namespace backend { namespace compiler {
+
+using namespace std;
+
+class StackAnalyzer
+{
+private:
+    const MethodCode *code;           // the method being analyzed
+    string methodName;                // its name, for error messages
+    map<Label *, size_t> positions;   // record index of each label
+    vector<int> depths;               // stack depth at each label, or -1
+    int errorCount;                   // count of stack errors
+
+public:
+    /**
+     * Constructor.
+     */
+    StackAnalyzer() : code(nullptr), errorCount(0) {}
+
+    /**
+     * Get the count of stack errors.
+     * @return the count.
+     */
+    int getErrorCount() const { return errorCount; }
+
+    /**
+     * Add the count of stack errors of another analyzer,
+     * such as one that analyzed a routine on its own thread.
+     * @param other the other analyzer.
+     */
+    void addErrors(const StackAnalyzer& other)
+    {
+        errorCount += other.errorCount;
+    }
+
+    /**
+     * Compute the maximum stack depth of a method and
+     * set the operand of its .limit stack directive.
+     * @param methodCode the method code.
+     * @return the maximum stack depth.
+     */
+    int analyze(MethodCode& methodCode);
+
+    /**
+     * Compute the net stack effect of an instruction in words.
+     * @param code the method code that contains the record.
+     * @param record the instruction record.
+     * @return the count of words pushed minus the count popped.
+     */
+    static int stackEffect(const MethodCode& code, const CodeRecord& record);
+
+private:
+    /**
+     * Follow the straight-line code starting at a record.
+     * @param start the index of the first record.
+     * @param depth the stack depth on entry.
+     * @param worklist where to add the branch targets.
+     * @return the maximum stack depth along the way.
+     */
+    int follow(size_t start, int depth,
+               vector<pair<size_t, int>>& worklist);
+
+    /**
+     * Record the stack depth at a label reached by a branch
+     * or by falling through.
+     * @param index the record index of the label.
+     * @param depth the stack depth.
+     * @return true if the label was not reached before, else false.
+     */
+    bool reach(size_t index, int depth);
+
+    /**
+     * Report a stack error.
+     * @param message the error message.
+     */
+    void error(const string& message);
+
+    /**
+     * Count the words of the type at a position in a descriptor.
+     * @param descriptor the type or method descriptor.
+     * @param position the position, moved past the type.
+     * @return 2 for long and double, 0 for void, else 1.
+     */
+    static int typeWords(const string& descriptor, size_t& position);
+};
+
+}}  // namespace backend::compiler
+
+#endif /* STACKANALYZER_H_ */
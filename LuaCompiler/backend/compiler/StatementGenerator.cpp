@@ -16,78 +16,90 @@ using namespace std;
 using namespace intermediate;
 
 
-void StatementGenerator::emitAssignment(LuaParser::AssignStatContext *ctx)
+void StatementGenerator::emitAssignment(const StatNode *stat)
 {
 	emitComment("ASSIGNMENT");
-    LuaParser::ExpContext *exprCtx = ctx->exp();
-    SymtabEntry *varId = ctx->var_()->entry;
+    const ExpNode *exprNode = stat->exp;
+    SymtabEntry *varId = stat->entry;
 
     // Emit code to evaluate the expression.
-    compiler->visit(exprCtx);
+    compiler->compileExpression(exprNode);
 
     // Emit code to store the expression value into the target variable.
-    emitStoreValue(varId, Predefined::numberType);
+    emitConvert(exprNode->type, varId->getType());
+    emitStoreValue(varId, varId->getType());
 }
 
-void StatementGenerator::emitIf(LuaParser::IfStatContext *ctx)
+void StatementGenerator::emitIf(const StatNode *stat)
 {
 	emitComment("IF");
-	int num_of_expressions = ctx->exp().size();
-	bool hasElse = (ctx->block().size() == num_of_expressions+1);
-
-	Label *trueLabel = new Label();
-	Label *falseLabel = new Label();
-
-	for (int i=0; i<num_of_expressions; i++){
-		if (i>0)
+	Label *exitLabel = newLabel();
+
+	// Each test that fails branches to the next one. Each block
+	// that executes branches past the rest of the statement.
+	for (const ClauseNode *clause = stat->clauses; clause != nullptr;
+	     clause = clause->next){
+		if (clause->test == nullptr){
+			emitComment("ELSE");
+			compiler->compileBlock(clause->block);
+			break;
+		}
+		if (clause != stat->clauses)
 			emitComment("ELSE IF");
-		compiler->visit(ctx->exp(i));
-		emit(IFEQ, falseLabel);
-		compiler->visit(ctx->block(i));
-		emitLabel(falseLabel);
-	}
-	if (hasElse){
-		emitComment("ELSE");
-		emit(GOTO, trueLabel);
-		emitLabel(falseLabel);
-		compiler->visit(ctx->block(num_of_expressions));
-		emitLabel(trueLabel);
+		Label *nextLabel = newLabel();
+		compiler->compileExpression(clause->test);
+		emitTruth(clause->test->type);
+		emit(IFEQ, nextLabel);
+		compiler->compileBlock(clause->block);
+		emit(GOTO, exitLabel);
+		emitLabel(nextLabel);
 	}
+	emitLabel(exitLabel);
 }
 
 
-void StatementGenerator::emitRepeat(LuaParser::RepeatStatContext *ctx)
+void StatementGenerator::emitRepeat(const StatNode *stat)
 {
 	emitComment("REPEAT");
-    Label *loopTopLabel  = new Label();
-    Label *loopExitLabel = new Label();
+    Label *loopTopLabel  = newLabel();
+    Label *loopExitLabel = newLabel();
 
     emitLabel(loopTopLabel);
 
-    compiler->visitBlock(ctx->block());
+    compiler->compileBlock(stat->block);
     emitComment("UNTIL");
-    compiler->visitExp(ctx->exp());
+    compiler->compileExpression(stat->exp);
+    emitTruth(stat->exp->type);
     emit(IFNE, loopExitLabel);
     emit(GOTO, loopTopLabel);
 
     emitLabel(loopExitLabel);
 }
 
-void StatementGenerator::emitFunctionCall(LuaParser::FunctioncallContext *ctx, SymtabEntry* functionId)
+void StatementGenerator::emitFunctionCall(const ExpNode *node)
 {
 	emitComment("FUNCTION CALL");
-	string name = ctx->varOrExp()->var_()->getText();
-	bool no_args = ctx->nameAndArgs(0)->args()->explist() == nullptr;
-	string call = programName + "/" + name;
-
-	if(no_args){
-		call = call + "()";
-		call = call + typeDescriptor(functionId);
-		cout << "invoking static\n";
-		emit(INVOKESTATIC, call);
-		return;
+	SymtabEntry *functionId = node->entry;
+	SymtabEntries *parmIds = functionId->getRoutineParameters();
+	size_t parmCount = parmIds != nullptr ? parmIds->size() : 0;
+	size_t argCount = 0;
+
+	// Convert each argument to its parameter's type. Extra
+	// arguments are evaluated and dropped, and missing ones are nil.
+	for (const ExpNode *argNode = node->left; argNode != nullptr;
+	     argNode = argNode->next){
+		compiler->compileExpression(argNode);
+		if (argCount < parmCount)
+			emitConvert(argNode->type, (*parmIds)[argCount]->getType());
+		else
+			emitPop(argNode->type);
+		argCount++;
 	}
 
+	for (; argCount < parmCount; argCount++){
+		emit(ACONST_NULL);
+		emitConvert(Predefined::nilType, (*parmIds)[argCount]->getType());
+	}
 
 	emitCall(functionId);
 }
@@ -96,13 +108,13 @@ void StatementGenerator::emitCall(SymtabEntry *routineId)
 {
 	string name = routineId->getName();
 	string call = programName + "/" + name + "(";
-	vector<SymtabEntry *> *parmIds = routineId->getRoutineParameters();
+	SymtabEntries *parmIds = routineId->getRoutineParameters();
 
     if (parmIds != nullptr)
     {
-        for (long unsigned int i=0; i< parmIds->size(); i++)
+        for (SymtabEntry *parmId : *parmIds)
         {
-            call += typeDescriptor(routineId);
+            call += typeDescriptor(parmId);
         }
     }
 
@@ -112,28 +124,27 @@ void StatementGenerator::emitCall(SymtabEntry *routineId)
     emit(INVOKESTATIC, call);
 }
 
-void StatementGenerator::emitWrite(LuaParser::PrintStatContext *ctx)
+void StatementGenerator::emitWrite(const StatNode *stat)
 {
 	emitComment("PRINT");
-    emitWrite(ctx->printArguments());
+    emitWrite(stat->exp);
 }
 
-void StatementGenerator::emitWrite(LuaParser::PrintArgumentsContext *argsCtx)
+void StatementGenerator::emitWrite(const ExpNode *arguments)
 {
     emit(GETSTATIC, "java/lang/System/out", "Ljava/io/PrintStream;");
 
     // WRITELN with no arguments.
-    if (argsCtx == nullptr)
+    if (arguments == nullptr)
     {
         emit(INVOKEVIRTUAL, "java/io/PrintStream.println()V");
-        localStack->decrease(1);
     }
 
     // Generate code for the arguments.
     else
     {
         string format;
-        int exprCount = createWriteFormat(argsCtx, format);
+        int exprCount = createWriteFormat(arguments, format);
 
         // Load the format string.
         emit(LDC, format);
@@ -141,44 +152,39 @@ void StatementGenerator::emitWrite(LuaParser::PrintArgumentsContext *argsCtx)
         // Emit the arguments array.
        if (exprCount > 0)
         {
-            emitArgumentsArray(argsCtx, exprCount);
+            emitArgumentsArray(arguments, exprCount);
 
             emit(INVOKEVIRTUAL,
                         string("java/io/PrintStream/printf(Ljava/lang/String;")
                       + string("[Ljava/lang/Object;)")
                       + string("Ljava/io/PrintStream;"));
-            localStack->decrease(2);
             emit(POP);
         }
         else
         {
             emit(INVOKEVIRTUAL,
                  "java/io/PrintStream/print(Ljava/lang/String;)V");
-            localStack->decrease(2);
         }
     }
 }
 
-int StatementGenerator::createWriteFormat(LuaParser::PrintArgumentsContext *argsCtx, string& format)
+int StatementGenerator::createWriteFormat(const ExpNode *arguments, string& format)
 {
     int exprCount = 0;
     format += "\"";
 
-    Typespec *type = Predefined::nilType;
-	string argText = argsCtx->getText();
-
-	// Append any literal strings.
-	if (argText[0] == '\'') format += convertString(argText, true);
-
-	// For any other expressions, append a field specifier.
-	else
+	// Append a field specifier for each expression,
+	// separated by tabs as Lua does.
+	for (const ExpNode *argNode = arguments; argNode != nullptr;
+	     argNode = argNode->next)
 	{
-		exprCount++;
+		Typespec *type = argNode->type;
+
+		if (exprCount++ > 0) format += "\\t";
 		format.append("%");
 		string typeFlag = type == Predefined::numberType ? "d"
-						: type == Predefined::boolType    ? "b"
-						: type == Predefined::stringType ? "s"
-						:                                  "n";
+						: type == Predefined::boolType   ? "b"
+						:                                  "s";
 		format += typeFlag;
     }
 
@@ -187,28 +193,70 @@ int StatementGenerator::createWriteFormat(LuaParser::PrintArgumentsContext *args
     return exprCount;
 }
 
-void StatementGenerator::emitArgumentsArray(LuaParser::PrintArgumentsContext *argsCtx, int exprCount)
+void StatementGenerator::emitArgumentsArray(const ExpNode *arguments, int exprCount)
 {
     // Create the arguments array.
     emitLoadConstant(exprCount);
     emit(ANEWARRAY, "java/lang/Object");
 
     int index = 0;
-	string argText = argsCtx->getText();
-	LuaParser::ExpContext *exprCtx = argsCtx->exp(0);
-
-	// Skip string constants, which were made part of
-	// the format string.
-	if (argText[0] != '\'')
+	for (const ExpNode *argNode = arguments; argNode != nullptr;
+	     argNode = argNode->next)
 	{
+		Typespec *type = argNode->type;
+
 		emit(DUP);
 		emitLoadConstant(index++);
 
-		compiler->visit(exprCtx);
+		compiler->compileExpression(argNode);
+
+		// Numbers and booleans are boxed, and the runtime
+		// formats a dynamic value as Lua prints it.
+		if (isPrimitive(type)) emitConvert(type, Predefined::nilType);
+		else if (isTagged(type))
+		{
+			emit(INVOKESTATIC, "LuaValue/toString(J)Ljava/lang/String;");
+		}
+
+		// Nil prints as nil.
+		else if (type != Predefined::stringType)
+		{
+			emit(LDC, "\"nil\"");
+			emit(INVOKESTATIC, string("java/util/Objects/toString(")
+			                 + string("Ljava/lang/Object;Ljava/lang/String;)")
+			                 + string("Ljava/lang/String;"));
+		}
 
 		// Store the value into the array.
 		emit(AASTORE);
 	}
 }
+
+void StatementGenerator::emitReturn(const StatNode *stat)
+{
+	emitComment("RETURN");
+	const ExpNode *exprNode = stat->exp;
+	SymtabEntry *routineId = stat->entry;
+	Typespec *type = Predefined::nilType;
+
+	if (exprNode != nullptr){
+		compiler->compileExpression(exprNode);
+		type = exprNode->type;
+	}
+	else emit(ACONST_NULL);
+
+	// A function's result goes into its implied variable,
+	// which the function returns at its exit.
+	if (routineId->getKind() == FUNCTION){
+		SymtabEntry *resultId =
+			routineId->getRoutineSymtab()->lookup(routineId->getName());
+
+		emitConvert(type, resultId->getType());
+		emitStoreLocal(resultId->getType(), resultId->getSlotNumber());
+	}
+	else emitPop(type);
+
+	emit(GOTO, methodCode->getExitLabel());
+}
 }
 }// namespace backend::compiler
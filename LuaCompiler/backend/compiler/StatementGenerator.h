@@ -5,10 +5,13 @@
 #include <map>
 
 #include "CodeGenerator.h"
+#include "intermediate/ast/ExpNode.h"
+#include "intermediate/ast/StatNode.h"
 
 namespace backend { namespace compiler {
 
 using namespace std;
+using namespace intermediate::ast;
 
 class StatementGenerator : public CodeGenerator
 {
@@ -23,34 +26,39 @@ public:
 
     /**
      * Emit code for an assignment statement.
-     * @param ctx the AssignmentStatementContext.
+     * @param stat the ASSIGN statement node.
      */
-    void emitAssignment(LuaParser::AssignStatContext *ctx);
+    void emitAssignment(const StatNode *stat);
 
     /**
      * Emit code for an IF statement.
-     * @param ctx the IfStatementContext.
+     * @param stat the IF statement node.
      */
-    void emitIf(LuaParser::IfStatContext *ctx);
+    void emitIf(const StatNode *stat);
 
     /*
      * Emit code for a REPEAT statement.
-     * @param ctx the RepeatStatementContext.
+     * @param stat the REPEAT statement node.
      */
-    void emitRepeat(LuaParser::RepeatStatContext *ctx);
+    void emitRepeat(const StatNode *stat);
 
     /**
-     * Emit code for a function call statement.
-     * @param ctx the FunctionCallContext.
+     * Emit code for a function call.
+     * @param node the CALL expression node.
      */
-    void emitFunctionCall(LuaParser::FunctioncallContext *ctx, SymtabEntry *ptr);
+    void emitFunctionCall(const ExpNode *node);
 
     /**
      * Emit code for a WRITE statement.
-     * @param ctx the WriteStatementContext.
+     * @param stat the PRINT statement node.
      */
-    void emitWrite(LuaParser::PrintStatContext *ctx);
+    void emitWrite(const StatNode *stat);
 
+    /**
+     * Emit code for a RETURN statement.
+     * @param stat the RETURN statement node.
+     */
+    void emitReturn(const StatNode *stat);
 
 
 private:
@@ -62,25 +70,25 @@ private:
 
     /**
      * Emit code for a call to PRINT
-     * @param argsCtx the print arguments context.
+     * @param arguments the first argument node, or null.
 
      */
-    void emitWrite(LuaParser::PrintArgumentsContext *argsCtx);
+    void emitWrite(const ExpNode *arguments);
 
     /**
      * Create the printf format string.
-     * @param argsCtx the print arguments context.
+     * @param arguments the first argument node.
      * @param format the format string to create.
      * @return the count of expression arguments.
      */
-    int createWriteFormat(LuaParser::PrintArgumentsContext *argsCtx, string& format);
+    int createWriteFormat(const ExpNode *arguments, string& format);
 
     /**
      * Emit the print arguments array.
-     * @param argsCtx
+     * @param arguments
      * @param exprCount
      */
-    void emitArgumentsArray(LuaParser::PrintArgumentsContext *argsCtx, int exprCount);
+    void emitArgumentsArray(const ExpNode *arguments, int exprCount);
 
 
 };
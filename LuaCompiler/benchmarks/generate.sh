@@ -0,0 +1,103 @@
+#!/bin/bash
+#
+# Generate a synthetic Lua program that stresses one part of the compiler.
+#
+# USAGE: benchmarks/generate.sh kind size [seed] > program.lua
+#
+# Kinds:
+#   expr       20 assignments, each a chain of size binary operations
+#   globals    size global variables, assigned and then summed
+#   functions  size function definitions, each called once
+#   nesting    if and repeat statements nested size levels deep
+#   strings    size assignments of 1000-character string literals,
+#              alternating short and long bracket forms
+#
+# The output depends only on the arguments, so the same command always
+# produces the same program. The seed varies the operators and constants.
+
+KIND=$1
+SIZE=$2
+SEED=${3:-1}
+
+if [ -z "$KIND" ] || [ -z "$SIZE" ]; then
+    echo "USAGE: $0 expr|globals|functions|nesting|strings size [seed]" >&2
+    exit 2
+fi
+
+awk -v kind="$KIND" -v size="$SIZE" -v seed="$SEED" '
+# A deterministic pseudo-random integer in [0, n).
+function next_int(n) {
+    state = (state*1103515245 + 12345) % 2147483648
+    return int(state/65536) % n
+}
+
+function op() { return substr("+-*", next_int(3) + 1, 1) }
+
+function expr_chain(terms,    text, i) {
+    text = "a"
+    for (i = 1; i <= terms; i++) {
+        text = text " " op() " " (i % 2 ? "b" : next_int(9) + 1)
+        if (i % 10 == 0) text = text "\n   "
+    }
+    return text
+}
+
+BEGIN {
+    state = seed
+    print "-- Generated by benchmarks/generate.sh " kind " " size " " seed
+
+    if (kind == "expr") {
+        print "a = 3"
+        print "b = 5"
+        for (s = 1; s <= 20; s++) print "x" s " = " expr_chain(size)
+        print "print(x1)"
+    }
+    else if (kind == "globals") {
+        for (i = 1; i <= size; i++) printf "g%05d = %d\n", i, next_int(1000)
+        print "total = 0"
+        for (i = 1; i <= size; i++) printf "total = total + g%05d\n", i
+        print "print(total)"
+    }
+    else if (kind == "functions") {
+        for (i = 1; i <= size; i++) {
+            printf "function f%05d(p, q)\n", i
+            printf "\tr = p %s q %s %d\n", op(), op(), next_int(100) + 1
+            print  "\tif r > q then"
+            print  "\t\treturn r - q"
+            print  "\tend"
+            print  "\treturn r"
+            print  "end"
+        }
+        for (i = 1; i <= size; i++) printf "v%05d = f%05d(%d, %d)\n", i, i, i, next_int(50)
+        print "print(v00001)"
+    }
+    else if (kind == "nesting") {
+        print "n = 0"
+        for (i = 1; i <= size; i++) {
+            indent = sprintf("%" (i - 1) "s", "")
+            if (i % 2) printf "%sif n < %d then\n", indent, i + next_int(10)
+            else       printf "%srepeat\n", indent
+            printf "%s n = n + 1\n", indent
+        }
+        for (i = size; i >= 1; i--) {
+            indent = sprintf("%" (i - 1) "s", "")
+            if (i % 2) printf "%send\n", indent
+            else       printf "%suntil n > 0\n", indent
+        }
+        print "print(n)"
+    }
+    else if (kind == "strings") {
+        for (i = 1; i <= size; i++) {
+            text = ""
+            while (length(text) < 1000) text = text sprintf("word%d ", next_int(1000))
+            text = substr(text, 1, 1000)
+            if (i % 2) printf "s%05d = \"%s\"\n", i, text
+            else       printf "s%05d = [[%s]]\n", i, text
+        }
+        print "print(s00001)"
+    }
+    else {
+        print "unknown kind " kind > "/dev/stderr"
+        exit 2
+    }
+}'
@@ -0,0 +1,12 @@
+-- Mixed integer arithmetic in a loop.
+i = 1
+x = 0
+repeat
+	x = x + i * 3 - i / 2
+	x = x - (x / 7) * 3
+	if x > 1000000 then
+		x = x / 3
+	end
+	i = i + 1
+until i > 2000000
+print(x)
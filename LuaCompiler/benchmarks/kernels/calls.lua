@@ -0,0 +1,20 @@
+-- Function calls, simple and recursive.
+function add(a, b)
+	return a + b
+end
+
+function fib(n)
+	if n < 2 then
+		return n
+	end
+	return fib(n - 1) + fib(n - 2)
+end
+
+i = 0
+s = 0
+repeat
+	s = add(s, i - s / 2)
+	i = i + 1
+until i >= 1000000
+print(s)
+print(fib(25))
@@ -0,0 +1,12 @@
+-- Nested counting loops.
+i = 0
+total = 0
+repeat
+	j = 0
+	repeat
+		total = total + j
+		j = j + 1
+	until j >= 1000
+	i = i + 1
+until i >= 1000
+print(total)
@@ -0,0 +1,7 @@
+-- Printing numbers and strings.
+i = 0
+repeat
+	print(i)
+	print("line", i)
+	i = i + 1
+until i >= 20000
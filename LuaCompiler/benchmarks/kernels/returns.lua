@@ -0,0 +1,31 @@
+-- Early returns: from a recursive function, from inside a loop,
+-- and from the main chunk.
+function depth(n)
+	if n == 0 then
+		return 0
+	end
+	return 1 + depth(n - 1)
+end
+
+function firstSquareAbove(limit)
+	k = 0
+	repeat
+		k = k + 1
+		if k * k > limit then
+			return k
+		end
+	until k > limit
+	return 0
+end
+
+i = 0
+s = 0
+repeat
+	s = s + depth(20) + firstSquareAbove(i)
+	i = i + 1
+until i >= 100000
+print(s)
+if s > 0 then
+	return
+end
+print(0)
@@ -0,0 +1,57 @@
+#!/bin/bash
+#
+# Startup-to-exit latency of the Lua compiler on a small file.
+#
+# USAGE: benchmarks/latency.sh [path/to/Lua] [source.lua] [runs]
+#
+# Runs the compiler repeatedly and prints the minimum, median, mean
+# and maximum wall-clock time of the whole process in milliseconds.
+# Exits with status 1 if the median is not under 10 ms.
+
+LUA=${1:-./Lua}
+SOURCE=${2:-testProgram.lua}
+RUNS=${3:-50}
+
+if [ ! -x "$LUA" ]; then
+    echo "ERROR: compiler binary $LUA not found."
+    exit 2
+fi
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+cp "$SOURCE" "$WORK/"
+SOURCE_NAME=$(basename "$SOURCE")
+LUA=$(cd "$(dirname "$LUA")" && pwd)/$(basename "$LUA")
+
+# One warm-up run to fill the file system cache.
+(cd "$WORK" && "$LUA" "$SOURCE_NAME" > /dev/null) || exit 2
+
+times=()
+for ((i = 0; i < RUNS; i++)); do
+    start=$(date +%s%N)
+    (cd "$WORK" && "$LUA" "$SOURCE_NAME" > /dev/null)
+    end=$(date +%s%N)
+    times+=($(( (end - start)/1000 )))
+done
+
+sorted=($(printf "%s\n" "${times[@]}" | sort -n))
+sum=0
+for t in "${sorted[@]}"; do sum=$((sum + t)); done
+
+min=${sorted[0]}
+max=${sorted[$((RUNS - 1))]}
+median=${sorted[$((RUNS/2))]}
+mean=$((sum/RUNS))
+
+ms() { printf "%d.%03d" $(($1/1000)) $(($1%1000)); }
+
+echo "Latency of $SOURCE_NAME over $RUNS runs (ms):"
+echo "  min    $(ms $min)"
+echo "  median $(ms $median)"
+echo "  mean   $(ms $mean)"
+echo "  max    $(ms $max)"
+
+if [ "$median" -ge 10000 ]; then
+    echo "Median latency is not under 10 ms."
+    exit 1
+fi
@@ -0,0 +1,104 @@
+#!/bin/bash
+#
+# Check that the compile server's memory does not grow across requests.
+#
+# USAGE: benchmarks/memory.sh [path/to/Lua] [source.lua] [compiles] [slack KB]
+#
+# Starts the compiler with --serve and sends it the given number of
+# COMPILE requests for the same file over one connection. Whatever a
+# compile frees is reused by the next, so the server's peak resident set
+# size settles after the first few requests. Prints the peak after the
+# first tenth of the requests and after the last, from the server's
+# /proc status, and exits with status 1 if it grew by more than the
+# slack (by default 1024 KB).
+
+LUA=${1:-./Lua}
+SOURCE=${2:-testProgram.lua}
+COMPILES=${3:-500}
+SLACK=${4:-1024}
+PYTHON=${PYTHON:-python3}
+
+if [ ! -x "$LUA" ]; then
+    echo "ERROR: compiler binary $LUA not found."
+    exit 2
+fi
+
+WORK=$(mktemp -d)
+SERVER=
+trap '[ -n "$SERVER" ] && kill $SERVER 2> /dev/null; rm -rf "$WORK"' EXIT
+cp "$SOURCE" "$WORK/"
+SOURCE_NAME=$(basename "$SOURCE")
+LUA=$(cd "$(dirname "$LUA")" && pwd)/$(basename "$LUA")
+SOCKET="$WORK/server.sock"
+
+(cd "$WORK" && exec "$LUA" --serve="$SOCKET" -j 1 > /dev/null) &
+SERVER=$!
+
+for ((i = 0; i < 100; i++)); do
+    [ -S "$SOCKET" ] && break
+    sleep 0.05
+done
+if [ ! -S "$SOCKET" ]; then
+    echo "ERROR: the server did not start."
+    exit 2
+fi
+
+# Send the requests and read the server's peak resident set size in KB
+# after the first tenth of them and after the last.
+peaks=($("$PYTHON" - "$SOCKET" "$SERVER" "$WORK/$SOURCE_NAME" "$COMPILES" <<'EOF'
+import socket, sys
+
+path, pid, source, compiles = sys.argv[1], sys.argv[2], sys.argv[3], int(sys.argv[4])
+client = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+client.connect(path)
+replies = client.makefile("rb")
+
+def peak():
+    with open("/proc/%s/status" % pid) as status:
+        for line in status:
+            if line.startswith("VmHWM:"):
+                return int(line.split()[1])
+
+def compile():
+    client.sendall(("COMPILE %s\n" % source).encode())
+    ok = False
+    while True:
+        line = replies.readline()
+        if not line:
+            sys.exit("the server closed the connection")
+        line = line.decode().rstrip("\n")
+        if line == "STATUS ok":
+            ok = True
+        elif line.startswith("DIAGNOSTICS "):
+            replies.read(int(line.split()[1]))
+        elif line == "END":
+            break
+    if not ok:
+        sys.exit("%s did not compile" % source)
+
+for i in range(compiles):
+    compile()
+    if i == compiles//10:
+        print(peak())
+print(peak())
+
+client.sendall(b"SHUTDOWN\n")
+EOF
+)) || {
+    echo "ERROR: the requests failed."
+    exit 2
+}
+
+settled=${peaks[0]}
+last=${peaks[1]}
+growth=$((last - settled))
+
+echo "Peak resident set size of the server over $COMPILES compiles of $SOURCE_NAME (KB):"
+echo "  after $((COMPILES/10 + 1)) $settled"
+echo "  after $COMPILES $last"
+echo "  growth $growth"
+
+if [ "$growth" -gt "$SLACK" ]; then
+    echo "Memory grew by more than $SLACK KB across compiles."
+    exit 1
+fi
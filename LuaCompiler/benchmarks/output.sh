@@ -0,0 +1,80 @@
+#!/bin/bash
+#
+# Object file emission rate with buffered and synchronous output.
+#
+# USAGE: benchmarks/output.sh [path/to/Lua] [scale] [runs]
+#
+# Compiles programs of benchmarks/generate.sh to Jasmin in three output
+# modes, and takes the best of several runs of the lines per second
+# that the compiler reports for pass 3:
+#
+#   buffered  the default, which spills the buffer every 64 KiB
+#   single    --output-buffer=0, a single write at close
+#   sync      --sync-output, a write and a flush after every line
+#
+# The results go to stdout as tab-separated lines in a fixed order:
+#
+#   kind  lines  mode  ms  lines/sec  vs sync
+#
+# The scale multiplies every program size. Exits with status 1 if the
+# buffered output is slower than the synchronous output on any program.
+
+LUA=${1:-./Lua}
+SCALE=${2:-1}
+RUNS=${3:-5}
+
+if [ ! -x "$LUA" ]; then
+    echo "ERROR: compiler binary $LUA not found."
+    exit 2
+fi
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+LUA=$(cd "$(dirname "$LUA")" && pwd)/$(basename "$LUA")
+
+# kind and base size of each program.
+PROGRAMS="globals:5000 functions:1000 expr:500"
+MODES="buffered: single:--output-buffer=0 sync:--sync-output"
+
+printf "kind\tlines\tmode\tms\tlines/sec\tvs sync\n"
+STATUS=0
+
+for program in $PROGRAMS; do
+    kind=${program%%:*}
+    size=$(( ${program#*:} * SCALE ))
+    "$HERE/generate.sh" "$kind" "$size" > "$WORK/$kind.lua" || exit 2
+
+    results=()
+    for mode in $MODES; do
+        option=${mode#*:}
+
+        # The fastest run, from the "N lines emitted in X ms" line.
+        best=$(for ((run = 0; run < RUNS; run++)); do
+                   (cd "$WORK" && "$LUA" $option "$kind.lua") \
+                       | awk '/lines emitted in/ { print $1, $5 }'
+               done | sort -k2 -g | head -1)
+        if [ -z "$best" ]; then
+            echo "ERROR: $kind.lua did not compile."
+            exit 2
+        fi
+        results+=("${mode%%:*} $best")
+    done
+
+    # The sync mode is last.
+    sync_ms=$(echo "${results[2]}" | awk '{ print $3 }')
+    for result in "${results[@]}"; do
+        echo "$result" | awk -v kind="$kind" -v sync="$sync_ms" '{
+            printf "%s\t%d\t%s\t%.3f\t%.0f\t%.2fx\n", kind, $2, $1, $3,
+                   ($3 > 0 ? $2/($3/1000) : 0), ($3 > 0 ? sync/$3 : 0)
+        }'
+    done
+
+    buffered_ms=$(echo "${results[0]}" | awk '{ print $3 }')
+    if awk -v b="$buffered_ms" -v s="$sync_ms" 'BEGIN { exit !(b > s) }'; then
+        echo "Buffered output of $kind.lua is slower than synchronous output."
+        STATUS=1
+    fi
+done
+
+exit $STATUS
@@ -0,0 +1,114 @@
+#!/bin/bash
+#
+# Run time of compiled Lua kernels on the local JVM.
+#
+# USAGE: benchmarks/runtime.sh [path/to/Lua] [forks] [warmup] [runs] [kernel.lua ...]
+#
+# Compiles each kernel (by default benchmarks/kernels/*.lua) to a class
+# file, then runs benchmarks/runtime/LuaBench in several fresh JVMs.
+# Each JVM runs every kernel's main method warmup times unmeasured and
+# then runs times measured. The programs do not time themselves.
+#
+# Prints the summary of each JVM, and then tab-separated lines over
+# all the JVMs' samples, one per kernel, in a fixed order:
+#
+#   kernel  samples  mean ms  median ms  stddev ms  ci95 ms  min ms  fork spread %
+#
+# ci95 is the half-width of the 95% confidence interval of the mean.
+# The fork spread is the range of the JVMs' means relative to the
+# overall mean; when it is large compared to ci95, differences between
+# JVM runs dominate and more forks are needed.
+
+LUA=${1:-./Lua}
+FORKS=${2:-5}
+WARMUP=${3:-10}
+RUNS=${4:-30}
+shift $(( $# < 4 ? $# : 4 ))
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+KERNELS=("$@")
+[ ${#KERNELS[@]} -eq 0 ] && KERNELS=("$HERE"/kernels/*.lua)
+
+if [ ! -x "$LUA" ]; then
+    echo "ERROR: compiler binary $LUA not found." >&2
+    exit 2
+fi
+for tool in java javac; do
+    if ! command -v $tool > /dev/null; then
+        echo "ERROR: $tool not found." >&2
+        exit 2
+    fi
+done
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+LUA=$(cd "$(dirname "$LUA")" && pwd)/$(basename "$LUA")
+
+# The class name is the source file name, so compile in place.
+classes=()
+for kernel in "${KERNELS[@]}"; do
+    name=$(basename "$kernel" .lua)
+    cp "$kernel" "$WORK/$name.lua"
+    (cd "$WORK" && "$LUA" --quiet --emit=class "$name.lua" > /dev/null) || {
+        echo "ERROR: $kernel did not compile." >&2
+        exit 2
+    }
+    classes+=("$name")
+done
+
+# Compiled programs keep dynamic values with the LuaValue runtime.
+javac -d "$WORK" "$HERE/runtime/LuaBench.java" \
+      "$HERE/../runtime/LuaValue.java" || exit 2
+
+for ((fork = 1; fork <= FORKS; fork++)); do
+    echo "== JVM $fork of $FORKS"
+    java -cp "$WORK" LuaBench --warmup="$WARMUP" --runs="$RUNS" \
+         --samples="$WORK/samples.txt" "${classes[@]}" || exit 2
+    awk -v fork=$fork '{ print $0, fork }' "$WORK/samples.txt" >> "$WORK/all.txt"
+    : > "$WORK/samples.txt"
+done
+
+echo
+printf "kernel\tsamples\tmean ms\tmedian ms\tstddev ms\tci95 ms\tmin ms\tfork spread %%\n"
+for name in "${classes[@]}"; do
+    awk -v name="$name" '$1 == name { print $2, $3 }' "$WORK/all.txt" \
+        | sort -n | awk -v name="$name" '
+        {
+            t[++n] = $1
+            sum += $1
+            forkSum[$2] += $1
+            forkCount[$2]++
+        }
+        END {
+            mean = sum/n
+            for (i = 1; i <= n; i++) ss += (t[i] - mean)^2
+            sd = n > 1 ? sqrt(ss/(n - 1)) : 0
+            median = (n % 2) ? t[(n + 1)/2] : (t[n/2] + t[n/2 + 1])/2
+
+            # Student t for n - 1 degrees of freedom. Between the
+            # rows past 30, the lower row gives a slightly wider interval.
+            split("12.706 4.303 3.182 2.776 2.571 2.447 2.365 2.306 " \
+                  "2.262 2.228 2.201 2.179 2.160 2.145 2.131 2.120 " \
+                  "2.110 2.101 2.093 2.086 2.080 2.074 2.069 2.064 " \
+                  "2.060 2.056 2.052 2.048 2.045 2.042", student, " ")
+            df = n - 1
+            tq = df <= 30 ? student[df] \
+               : df < 40  ? 2.042 \
+               : df < 60  ? 2.021 \
+               : df < 120 ? 2.000 \
+               :            1.980
+            ci = n > 1 ? tq*sd/sqrt(n) : 0
+
+            first = 1
+            for (f in forkSum) {
+                m = forkSum[f]/forkCount[f]
+                if (first || (m < low))  low = m
+                if (first || (m > high)) high = m
+                first = 0
+            }
+
+            printf "%s\t%d\t%.3f\t%.3f\t%.3f\t%.3f\t%.3f\t%.1f\n", name, n,
+                   mean/1e6, median/1e6, sd/1e6, ci/1e6, t[1]/1e6,
+                   (mean > 0 ? 100*(high - low)/mean : 0)
+        }'
+done
@@ -0,0 +1,163 @@
+import java.io.FileWriter;
+import java.io.OutputStream;
+import java.io.PrintStream;
+import java.io.PrintWriter;
+import java.lang.reflect.InvocationTargetException;
+import java.lang.reflect.Method;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+
+/**
+ * <h1>LuaBench</h1>
+ *
+ * <p>Run compiled Lua programs in this JVM and time them. Each program's
+ * main method runs a number of warm-up times, so that the JIT compiler
+ * has settled, and then a number of measured times. Output that the
+ * programs print is discarded while they run.</p>
+ *
+ * <p>USAGE: java LuaBench [--warmup=N] [--runs=N] [--samples=file]
+ * className ...</p>
+ *
+ * <p>Prints one summary line per program, and with --samples appends
+ * each measured time in nanoseconds to the file as "className time".</p>
+ */
+public class LuaBench
+{
+    private static final PrintStream NULL_OUT =
+        new PrintStream(new OutputStream() {
+            @Override public void write(int b) {}
+            @Override public void write(byte[] b, int off, int len) {}
+        });
+
+    public static void main(String[] args) throws Exception
+    {
+        int warmup = 10;
+        int runs = 30;
+        String samplesFile = null;
+        List<String> classNames = new ArrayList<>();
+
+        for (String arg : args)
+        {
+            if      (arg.startsWith("--warmup="))  warmup = Integer.parseInt(arg.substring(9));
+            else if (arg.startsWith("--runs="))    runs = Integer.parseInt(arg.substring(7));
+            else if (arg.startsWith("--samples=")) samplesFile = arg.substring(10);
+            else classNames.add(arg);
+        }
+
+        if (classNames.isEmpty() || (runs < 1))
+        {
+            System.out.println("USAGE: java LuaBench [--warmup=N] [--runs=N] "
+                               + "[--samples=file] className ...");
+            System.exit(2);
+        }
+
+        PrintWriter samples = samplesFile != null
+                            ? new PrintWriter(new FileWriter(samplesFile, true))
+                            : null;
+
+        System.out.printf("%-16s %6s %12s %12s %12s %12s %12s%n", "kernel",
+                          "runs", "mean ms", "median ms", "stddev ms",
+                          "ci95 ms", "min ms");
+
+        for (String className : classNames)
+        {
+            Method main = Class.forName(className)
+                               .getMethod("main", String[].class);
+            long[] times = measure(main, warmup, runs);
+
+            if (samples != null)
+            {
+                for (long time : times) samples.println(className + " " + time);
+            }
+
+            report(className, times);
+        }
+
+        if (samples != null) samples.close();
+    }
+
+    /**
+     * Run a program's main method and time the measured runs.
+     * @param main the main method.
+     * @param warmup the count of runs that are not measured.
+     * @param runs the count of measured runs.
+     * @return the time of each measured run in nanoseconds.
+     */
+    private static long[] measure(Method main, int warmup, int runs)
+        throws IllegalAccessException, InvocationTargetException
+    {
+        PrintStream out = System.out;
+        long[] times = new long[runs];
+        Object[] mainArgs = { new String[0] };
+
+        System.setOut(NULL_OUT);
+        try
+        {
+            for (int i = 0; i < warmup; i++) main.invoke(null, mainArgs);
+
+            for (int i = 0; i < runs; i++)
+            {
+                long start = System.nanoTime();
+                main.invoke(null, mainArgs);
+                times[i] = System.nanoTime() - start;
+            }
+        }
+        finally
+        {
+            System.setOut(out);
+        }
+
+        return times;
+    }
+
+    /**
+     * Print the summary statistics of a program's run times.
+     * @param className the program's class name.
+     * @param times the run times in nanoseconds.
+     */
+    private static void report(String className, long[] times)
+    {
+        int n = times.length;
+        long[] sorted = times.clone();
+        Arrays.sort(sorted);
+
+        double mean = 0;
+        for (long time : times) mean += time;
+        mean /= n;
+
+        double variance = 0;
+        for (long time : times) variance += (time - mean)*(time - mean);
+        double stddev = n > 1 ? Math.sqrt(variance/(n - 1)) : 0;
+
+        double median = (n % 2 == 1) ? sorted[n/2]
+                                     : (sorted[n/2 - 1] + sorted[n/2])/2.0;
+        double ci95 = tCritical(n - 1)*stddev/Math.sqrt(n);
+
+        System.out.printf("%-16s %6d %12.3f %12.3f %12.3f %12.3f %12.3f%n",
+                          className, n, mean/1e6, median/1e6, stddev/1e6,
+                          ci95/1e6, sorted[0]/1e6);
+    }
+
+    /**
+     * Get the two-sided 95% critical value of Student's t distribution.
+     * @param df the degrees of freedom.
+     * @return the critical value.
+     */
+    static double tCritical(int df)
+    {
+        final double[] TABLE = {
+            12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262,
+            2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101,
+            2.093, 2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052,
+            2.048, 2.045, 2.042
+        };
+
+        if (df < 1)             return 0;
+        if (df <= TABLE.length) return TABLE[df - 1];
+        if (df <= 40)           return 2.021;
+        if (df <= 60)           return 2.000;
+        if (df <= 120)          return 1.980;
+        return 1.960;
+    }
+}
@@ -0,0 +1,209 @@
+import java.lang.management.ManagementFactory;
+import java.lang.management.ThreadMXBean;
+import java.util.Arrays;
+
+/**
+ * <h1>ValueBench</h1>
+ *
+ * <p>Compare the two representations of a Lua value whose type varies:
+ * a boxed Object, and a tagged long of the LuaValue runtime. Each kernel
+ * does what compiled code does with a dynamic variable, which is a
+ * static field: load it, convert it, operate, and store it back.</p>
+ *
+ * <p>USAGE: java ValueBench [--warmup=N] [--runs=N] [--ops=N]</p>
+ *
+ * <p>Prints one line per kernel and representation, with the time and
+ * the bytes allocated per operation. The bytes are measured when the
+ * JVM can count the allocations of a thread, else they are -1.</p>
+ */
+public class ValueBench
+{
+    // The dynamic variables, as compiled programs declare them.
+    static Object boxed;
+    static long tagged;
+
+    interface Kernel
+    {
+        void run(int ops);
+    }
+
+    public static void main(String[] args)
+    {
+        int warmup = 10;
+        int runs = 30;
+        int ops = 1_000_000;
+
+        for (String arg : args)
+        {
+            if      (arg.startsWith("--warmup=")) warmup = Integer.parseInt(arg.substring(9));
+            else if (arg.startsWith("--runs="))   runs = Integer.parseInt(arg.substring(7));
+            else if (arg.startsWith("--ops="))    ops = Integer.parseInt(arg.substring(6));
+            else
+            {
+                System.out.println("USAGE: java ValueBench [--warmup=N] "
+                                   + "[--runs=N] [--ops=N]");
+                System.exit(2);
+            }
+        }
+
+        System.out.printf("%-16s %-8s %12s %12s %12s%n", "kernel", "value",
+                          "median ns/op", "min ns/op", "bytes/op");
+
+        // s = s + i
+        bench("int-add", warmup, runs, ops,
+              n -> {
+                  boxed = Integer.valueOf(0);
+                  for (int i = 0; i < n; i++)
+                  {
+                      boxed = Integer.valueOf((Integer) boxed + i);
+                  }
+              },
+              n -> {
+                  tagged = LuaValue.ofInt(0);
+                  for (int i = 0; i < n; i++)
+                  {
+                      tagged = LuaValue.ofInt(LuaValue.toInt(tagged) + i);
+                  }
+              });
+
+        // x = x + 0.5
+        bench("double-add", warmup, runs, ops,
+              n -> {
+                  boxed = Double.valueOf(0);
+                  for (int i = 0; i < n; i++)
+                  {
+                      boxed = Double.valueOf((Double) boxed + 0.5);
+                  }
+              },
+              n -> {
+                  tagged = LuaValue.ofDouble(0);
+                  for (int i = 0; i < n; i++)
+                  {
+                      tagged = LuaValue.ofDouble(LuaValue.toDouble(tagged) + 0.5);
+                  }
+              });
+
+        // if x then x = nil else x = i end
+        bench("nil-or-int", warmup, runs, ops,
+              n -> {
+                  boxed = null;
+                  for (int i = 0; i < n; i++)
+                  {
+                      boolean truth =    (boxed != null)
+                                      && !Boolean.FALSE.equals(boxed);
+                      boxed = truth ? null : Integer.valueOf(i);
+                  }
+              },
+              n -> {
+                  tagged = LuaValue.NIL;
+                  for (int i = 0; i < n; i++)
+                  {
+                      tagged = LuaValue.truth(tagged) ? LuaValue.NIL
+                                                      : LuaValue.ofInt(i);
+                  }
+              });
+
+        // if x == i then ... end
+        bench("int-equal", warmup, runs, ops,
+              n -> {
+                  int count = 0;
+                  for (int i = 0; i < n; i++)
+                  {
+                      boxed = Integer.valueOf(i & 1023);
+                      if (boxed.equals(Integer.valueOf(i & 511))) count++;
+                  }
+                  if (count < 0) System.out.println(count);
+              },
+              n -> {
+                  int count = 0;
+                  for (int i = 0; i < n; i++)
+                  {
+                      tagged = LuaValue.ofInt(i & 1023);
+                      if (LuaValue.equal(tagged, LuaValue.ofInt(i & 511))) count++;
+                  }
+                  if (count < 0) System.out.println(count);
+              });
+    }
+
+    /**
+     * Time a kernel with both representations and print the results.
+     * @param name the kernel's name.
+     * @param warmup the count of runs that are not measured.
+     * @param runs the count of measured runs.
+     * @param ops the count of operations in each run.
+     * @param boxedKernel the kernel with boxed values.
+     * @param taggedKernel the kernel with tagged values.
+     */
+    private static void bench(String name, int warmup, int runs, int ops,
+                              Kernel boxedKernel, Kernel taggedKernel)
+    {
+        report(name, "boxed",  measure(boxedKernel,  warmup, runs, ops), ops);
+        report(name, "tagged", measure(taggedKernel, warmup, runs, ops), ops);
+    }
+
+    /**
+     * Run a kernel and time the measured runs.
+     * @param kernel the kernel.
+     * @param warmup the count of runs that are not measured.
+     * @param runs the count of measured runs.
+     * @param ops the count of operations in each run.
+     * @return the time of each run in nanoseconds, followed by the
+     *         bytes allocated by all the runs, or -1 if unknown.
+     */
+    private static long[] measure(Kernel kernel, int warmup, int runs, int ops)
+    {
+        long[] results = new long[runs + 1];
+
+        for (int i = 0; i < warmup; i++) kernel.run(ops);
+
+        long bytes = allocatedBytes();
+        for (int i = 0; i < runs; i++)
+        {
+            long start = System.nanoTime();
+            kernel.run(ops);
+            results[i] = System.nanoTime() - start;
+        }
+        results[runs] = bytes < 0 ? -1 : allocatedBytes() - bytes;
+
+        return results;
+    }
+
+    /**
+     * Print the results of a kernel with one representation.
+     * @param name the kernel's name.
+     * @param value the representation.
+     * @param results the run times, followed by the allocated bytes.
+     * @param ops the count of operations in each run.
+     */
+    private static void report(String name, String value, long[] results,
+                               int ops)
+    {
+        int runs = results.length - 1;
+        long[] times = Arrays.copyOf(results, runs);
+        Arrays.sort(times);
+
+        double median = (runs % 2 == 1) ? times[runs/2]
+                                        : (times[runs/2 - 1] + times[runs/2])/2.0;
+        long bytes = results[runs];
+
+        System.out.printf("%-16s %-8s %12.3f %12.3f %12.2f%n", name, value,
+                          median/ops, (double) times[0]/ops,
+                          bytes < 0 ? -1.0 : (double) bytes/((long) runs*ops));
+    }
+
+    /**
+     * Get the count of bytes that this thread has allocated.
+     * @return the count, or -1 if the JVM does not count them.
+     */
+    private static long allocatedBytes()
+    {
+        ThreadMXBean bean = ManagementFactory.getThreadMXBean();
+
+        if (bean instanceof com.sun.management.ThreadMXBean)
+        {
+            return ((com.sun.management.ThreadMXBean) bean)
+                        .getThreadAllocatedBytes(Thread.currentThread().getId());
+        }
+        return -1;
+    }
+}
@@ -0,0 +1,48 @@
+#!/bin/bash
+#
+# Scaling of parallel multi-file compilation with the thread count.
+#
+# USAGE: benchmarks/scaling.sh [path/to/Lua] [source.lua] [files] [max threads]
+#
+# Compiles copies of one source file with -j 1, 2, 4, ... up to the
+# maximum thread count, and prints the wall-clock time, throughput
+# and speedup over one thread of each run.
+
+LUA=${1:-./Lua}
+SOURCE=${2:-testProgram.lua}
+FILES=${3:-500}
+MAX_THREADS=${4:-$(nproc)}
+
+if [ ! -x "$LUA" ]; then
+    echo "ERROR: compiler binary $LUA not found."
+    exit 2
+fi
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+LUA=$(cd "$(dirname "$LUA")" && pwd)/$(basename "$LUA")
+
+# Each copy needs its own name, since it becomes the class name.
+for ((i = 1; i <= FILES; i++)); do
+    cp "$SOURCE" "$WORK/prog$(printf %05d $i).lua"
+done
+(cd "$WORK" && ls prog*.lua > manifest.txt)
+
+threads=()
+for ((t = 1; t < MAX_THREADS; t *= 2)); do threads+=($t); done
+threads+=($MAX_THREADS)
+
+printf "%8s %10s %12s %8s\n" "Threads" "Seconds" "Files/sec" "Speedup"
+base=0
+for t in "${threads[@]}"; do
+    start=$(date +%s%N)
+    (cd "$WORK" && "$LUA" --quiet -j "$t" --manifest=manifest.txt > /dev/null)
+    end=$(date +%s%N)
+
+    us=$(( (end - start)/1000 ))
+    [ "$base" -eq 0 ] && base=$us
+    awk -v t="$t" -v us="$us" -v files="$FILES" -v base="$base" 'BEGIN {
+        printf "%8d %10.3f %12.0f %7.2fx\n",
+               t, us/1e6, files/(us/1e6), base/us
+    }'
+done
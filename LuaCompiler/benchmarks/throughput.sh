@@ -0,0 +1,139 @@
+#!/bin/bash
+#
+# Compile throughput of each pass on generated Lua programs.
+#
+# USAGE: benchmarks/throughput.sh [path/to/Lua] [scale] [baseline.tsv]
+#
+# For each program kind of benchmarks/generate.sh, measures the
+# source lines per second of every pass that --time-passes-json
+# reports, on two paths:
+#
+#   cold   a new process compiles the single file, best of 5 runs
+#   warm   one process compiles 20 copies in a batch, so the lexer and
+#          parser caches are warm; the first copy is not counted
+#
+# The results go to stdout as tab-separated lines in a fixed order:
+#
+#   kind  size  path  pass  lines  ms  lines/sec
+#
+# The scale multiplies every program size. With a baseline file from
+# an earlier run, each line also gets the ratio to the baseline's
+# lines/sec, and lines more than 10% slower are marked REGRESSION.
+# The exit status is then 1 if there is any regression.
+
+LUA=${1:-./Lua}
+SCALE=${2:-1}
+BASELINE=$3
+COLD_RUNS=5
+WARM_FILES=20
+
+if [ ! -x "$LUA" ]; then
+    echo "ERROR: compiler binary $LUA not found." >&2
+    exit 2
+fi
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+LUA=$(cd "$(dirname "$LUA")" && pwd)/$(basename "$LUA")
+
+# kind and base size of each program.
+PROGRAMS="expr:200 globals:2000 functions:500 nesting:100 strings:500"
+
+# Print "pass ms" for every pass of every file in a JSON report,
+# skipping the first skip files.
+passes() {
+    awk -v skip="$2" '
+    /"file":/ {
+        if (++file <= skip) next
+        line = $0
+        while (match(line, /"name": "[^"]*", "wall_ms": [0-9.]+/)) {
+            span = substr(line, RSTART, RLENGTH)
+            line = substr(line, RSTART + RLENGTH)
+            split(span, part, "\"")
+            ms = span
+            sub(/.*"wall_ms": /, "", ms)
+            print part[4], ms
+        }
+    }' "$1"
+}
+
+results="$WORK/results.tsv"
+: > "$results"
+
+for program in $PROGRAMS; do
+    kind=${program%%:*}
+    size=$(( ${program#*:} * SCALE ))
+    dir="$WORK/$kind"
+    mkdir -p "$dir"
+
+    "$HERE/generate.sh" "$kind" "$size" > "$dir/$kind.lua" || exit 2
+    lines=$(wc -l < "$dir/$kind.lua")
+
+    # Cold: the fastest of several single-file runs, pass by pass.
+    for ((run = 0; run < COLD_RUNS; run++)); do
+        (cd "$dir" && "$LUA" --quiet --time-passes-json=cold.json \
+                             "$kind.lua" > /dev/null) || exit 2
+        passes "$dir/cold.json" 0
+    done | awk -v kind="$kind" -v size="$size" -v lines="$lines" '
+        {
+            if (!($1 in best)) names[++count] = $1
+            if (!($1 in best) || ($2 < best[$1])) best[$1] = $2
+        }
+        END {
+            for (i = 1; i <= count; i++) {
+                ms = best[names[i]]
+                printf "%s\t%d\tcold\t%s\t%d\t%.3f\t%.0f\n", kind, size,
+                       names[i], lines, ms, (ms > 0 ? lines/(ms/1000) : 0)
+            }
+        }' >> "$results"
+
+    # Warm: copies in one batch. Each copy needs its own name,
+    # since it becomes the class name.
+    : > "$dir/manifest.txt"
+    for ((i = 1; i <= WARM_FILES; i++)); do
+        name=$(printf "%s%03d.lua" "$kind" $i)
+        cp "$dir/$kind.lua" "$dir/$name"
+        echo "$name" >> "$dir/manifest.txt"
+    done
+    (cd "$dir" && "$LUA" --quiet --time-passes-json=warm.json \
+                         --manifest=manifest.txt > /dev/null) || exit 2
+    passes "$dir/warm.json" 1 | awk -v kind="$kind" -v size="$size" \
+                                    -v lines="$lines" -v files=$((WARM_FILES - 1)) '
+        {
+            if (!($1 in total)) names[++count] = $1
+            total[$1] += $2
+        }
+        END {
+            for (i = 1; i <= count; i++) {
+                ms = total[names[i]]/files
+                printf "%s\t%d\twarm\t%s\t%d\t%.3f\t%.0f\n", kind, size,
+                       names[i], lines, ms, (ms > 0 ? lines/(ms/1000) : 0)
+            }
+        }' >> "$results"
+done
+
+if [ -z "$BASELINE" ]; then
+    printf "kind\tsize\tpath\tpass\tlines\tms\tlines/sec\n"
+    cat "$results"
+    exit 0
+fi
+
+# Compare with the baseline, matching lines by kind, size, path and pass.
+awk -F '\t' '
+    NR == FNR { if (FNR > 1) base[$1 FS $2 FS $3 FS $4] = $7; next }
+    FNR == 1 {
+        printf "kind\tsize\tpath\tpass\tlines\tms\tlines/sec\tratio\n"
+    }
+    {
+        key = $1 FS $2 FS $3 FS $4
+        line = $0
+        if ((key in base) && (base[key] > 0)) {
+            ratio = $7/base[key]
+            line = line sprintf("\t%.2f", ratio)
+            if (ratio < 0.90) { line = line "\tREGRESSION"; regressions++ }
+        }
+        else line = line "\tnew"
+        print line
+    }
+    END { exit regressions > 0 }' "$BASELINE" "$results"
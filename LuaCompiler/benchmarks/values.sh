@@ -0,0 +1,34 @@
+#!/bin/bash
+#
+# Cost of the two representations of dynamic Lua values on the local JVM.
+#
+# USAGE: benchmarks/values.sh [warmup] [runs] [ops]
+#
+# Runs benchmarks/runtime/ValueBench, which compares boxed Objects with
+# the tagged longs of runtime/LuaValue on the same kernels, and prints
+# per kernel and representation:
+#
+#   kernel  value  median ns/op  min ns/op  bytes/op
+#
+# The tagged kernels should allocate nothing.
+
+WARMUP=${1:-10}
+RUNS=${2:-30}
+OPS=${3:-1000000}
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+
+for tool in java javac; do
+    if ! command -v $tool > /dev/null; then
+        echo "ERROR: $tool not found." >&2
+        exit 2
+    fi
+done
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+javac -d "$WORK" "$HERE/runtime/ValueBench.java" \
+      "$HERE/../runtime/LuaValue.java" || exit 2
+
+java -cp "$WORK" ValueBench --warmup="$WARMUP" --runs="$RUNS" --ops="$OPS"
@@ -0,0 +1,70 @@
+#include <cstdlib>
+#include <new>
+#include <atomic>
+
+#include "AllocationCounter.h"
+
+namespace driver {
+
+// None of these has dynamic initialization, so operator new
+// can use them before main().
+static thread_local long allocations = 0;
+static std::atomic<bool> countingProcess(false);
+static std::atomic<long> processAllocations(0);
+
+long allocationCount() { return allocations; }
+
+void countProcessAllocations(bool on)
+{
+    countingProcess.store(on, std::memory_order_relaxed);
+}
+
+long processAllocationCount()
+{
+    return processAllocations.load(std::memory_order_relaxed);
+}
+
+} // namespace driver
+
+// Replacements of the global allocation functions. The array and
+// sized forms that are not replaced call these by default.
+
+void *operator new(std::size_t size)
+{
+    driver::allocations++;
+    if (driver::countingProcess.load(std::memory_order_relaxed))
+    {
+        driver::processAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (size == 0) size = 1;
+
+    for (;;)
+    {
+        if (void *block = std::malloc(size)) return block;
+
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void *operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return operator new(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void operator delete(void *block) noexcept { std::free(block); }
+
+void operator delete(void *block, std::size_t) noexcept { std::free(block); }
+
+void operator delete(void *block, const std::nothrow_t&) noexcept
+{
+    std::free(block);
+}
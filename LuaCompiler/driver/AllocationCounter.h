@@ -0,0 +1,35 @@
+/**
+ * <h1>AllocationCounter</h1>
+ *
+ * <p>Count the heap allocations made by each thread and, on request,
+ * by the whole process. The counting replaces the global operator new,
+ * so it is always on. It costs one thread-local increment per allocation,
+ * plus one shared atomic increment while the process is counted.</p>
+ */
+#ifndef ALLOCATIONCOUNTER_H_
+#define ALLOCATIONCOUNTER_H_
+
+namespace driver {
+
+/**
+ * Get the count of heap allocations made so far by the calling thread.
+ * @return the count.
+ */
+long allocationCount();
+
+/**
+ * Start or stop counting the heap allocations of every thread.
+ * @param on true to count them.
+ */
+void countProcessAllocations(bool on);
+
+/**
+ * Get the count of heap allocations made by every thread while the
+ * process was being counted.
+ * @return the count.
+ */
+long processAllocationCount();
+
+} // namespace driver
+
+#endif /* ALLOCATIONCOUNTER_H_ */
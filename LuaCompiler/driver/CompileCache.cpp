@@ -0,0 +1,360 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <ctime>
+#include <cerrno>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#include "intermediate/util/Sha256.h"
+#include "CompileCache.h"
+
+namespace driver {
+
+using namespace std;
+using namespace intermediate::util;
+
+const char *CompileCache::VERSION = "LuaCompiler 1.0 (built " __DATE__ " " __TIME__ ")";
+
+/**
+ * A cache entry file found by a directory scan.
+ */
+struct EntryFile
+{
+    string path;    // the file name
+    time_t used;    // when it was last stored or found
+    size_t bytes;   // its size
+};
+
+/**
+ * Create a directory and any missing parent directories.
+ * @param path the directory name.
+ * @return true if the directory exists afterwards, else false.
+ */
+static bool makeDirectories(const string& path)
+{
+    for (size_t i = 1; i <= path.size(); i++)
+    {
+        if ((i == path.size()) || (path[i] == '/'))
+        {
+            string prefix = path.substr(0, i);
+            if ((mkdir(prefix.c_str(), 0777) != 0) && (errno != EEXIST))
+            {
+                return false;
+            }
+        }
+    }
+
+    struct stat info;
+    return (stat(path.c_str(), &info) == 0) && S_ISDIR(info.st_mode);
+}
+
+/**
+ * Find the files in a directory and its subdirectories.
+ * @param path the directory name.
+ * @param files the vector to append the files to.
+ */
+static void scanFiles(const string& path, vector<EntryFile>& files)
+{
+    DIR *dir = opendir(path.c_str());
+    if (dir == nullptr) return;
+
+    while (struct dirent *item = readdir(dir))
+    {
+        string name = item->d_name;
+        if ((name == ".") || (name == "..")) continue;
+
+        string child = path + "/" + name;
+        struct stat info;
+        if (stat(child.c_str(), &info) != 0) continue;  // removed meanwhile
+
+        if (S_ISDIR(info.st_mode)) scanFiles(child, files);
+        else files.push_back({child, info.st_mtime, (size_t) info.st_size});
+    }
+
+    closedir(dir);
+}
+
+CompileCache::CompileCache(const string& directory)
+    : directory(directory), hits(0), misses(0), stores(0)
+{
+    if (   !makeDirectories(directory + "/entries")
+        || !makeDirectories(directory + "/tmp"))
+    {
+        cout << "ERROR: Failed to create cache directory \""
+             << directory << "\"." << endl;
+        exit(-1);
+    }
+}
+
+string CompileCache::defaultDirectory()
+{
+    const char *cacheDir = getenv("LUA_CACHE_DIR");
+    if ((cacheDir != nullptr) && (*cacheDir != '\0')) return cacheDir;
+
+    const char *home = getenv("HOME");
+    if ((home != nullptr) && (*home != '\0'))
+    {
+        return string(home) + "/.cache/luacompiler";
+    }
+
+    return ".luacache";
+}
+
+string CompileCache::key(const string& source, const string& programName,
+                         const CompilerOptions& options, bool fold)
+{
+    // Only the flags that change the object file are part of the key.
+    // The buffering and the worker count do not.
+    Sha256 hash;
+    hash.add(VERSION);
+    hash.add(programName);
+    hash.add(options.emit == EmitFormat::CLASS ? "class" : "jasmin");
+    hash.add(options.peephole ? "peephole" : "no-peephole");
+    hash.add(fold ? "fold" : "no-fold");
+    hash.add(  options.timing == RuntimeTiming::MS ? "timing-ms"
+             : options.timing == RuntimeTiming::NS ? "timing-ns"
+             :                                       "timing-off");
+    hash.add(source.data(), source.size());
+
+    return hash.hex();
+}
+
+string CompileCache::entryFileName(const string& key) const
+{
+    // Spread the entries over subdirectories by their first two digits.
+    return directory + "/entries/" + key.substr(0, 2) + "/" + key + ".entry";
+}
+
+bool CompileCache::lookup(const string& key, CacheEntry& entry)
+{
+    string fileName = entryFileName(key);
+    ifstream ins(fileName, ios::binary);
+    if (ins.fail())
+    {
+        misses++;
+        return false;
+    }
+
+    // The header, then the diagnostics and the object bytes.
+    string magic;
+    size_t diagnosticsSize = 0, objectSize = 0;
+    string field;
+    getline(ins, magic);
+    ins >> field >> entry.syntaxErrors
+        >> field >> entry.semanticErrors
+        >> field >> entry.objectLines
+        >> field >> diagnosticsSize
+        >> field >> objectSize;
+    ins.get();  // the newline after the header
+
+    // The sizes must fit in the rest of the file, or
+    // a damaged header could ask for any amount of memory.
+    streampos bodyStart = ins.tellg();
+    ins.seekg(0, ios::end);
+    streamoff bodySize = ins.tellg() - bodyStart;
+    ins.seekg(bodyStart);
+
+    if (   ins.fail() || (bodySize < 0)
+        || (diagnosticsSize > (size_t) bodySize)
+        || (objectSize > (size_t) bodySize - diagnosticsSize))
+    {
+        misses++;
+        return false;
+    }
+
+    entry.diagnostics.resize(diagnosticsSize);
+    entry.object.resize(objectSize);
+    ins.read(&entry.diagnostics[0], diagnosticsSize);
+    ins.read(&entry.object[0], objectSize);
+
+    // A damaged entry is simply a miss.
+    if ((magic != "LUACACHE 1") || ins.fail() || (ins.peek() != EOF))
+    {
+        misses++;
+        return false;
+    }
+
+    // Mark the entry as recently used for eviction.
+    utimensat(AT_FDCWD, fileName.c_str(), nullptr, 0);
+
+    hits++;
+    return true;
+}
+
+void CompileCache::store(const string& key, const CacheEntry& entry)
+{
+    string fileName = entryFileName(key);
+    if (!makeDirectories(fileName.substr(0, fileName.rfind('/')))) return;
+
+    // Write a private temporary file on the same file system, and then
+    // rename it into place. The rename is atomic, so a concurrent
+    // reader sees either the whole old entry or the whole new one.
+    static atomic<int> sequence(0);
+    string tempName = directory + "/tmp/" + key + "." + to_string(getpid())
+                                + "." + to_string(sequence++);
+    {
+        ofstream outs(tempName, ios::binary);
+        outs << "LUACACHE 1\n"
+             << "syntax "      << entry.syntaxErrors       << "\n"
+             << "semantic "    << entry.semanticErrors     << "\n"
+             << "lines "       << entry.objectLines        << "\n"
+             << "diagnostics " << entry.diagnostics.size() << "\n"
+             << "object "      << entry.object.size()      << "\n";
+        outs.write(entry.diagnostics.data(), entry.diagnostics.size());
+        outs.write(entry.object.data(), entry.object.size());
+        outs.close();
+
+        if (outs.fail())
+        {
+            unlink(tempName.c_str());
+            return;
+        }
+    }
+
+    if (rename(tempName.c_str(), fileName.c_str()) != 0)
+    {
+        unlink(tempName.c_str());
+        return;
+    }
+
+    stores++;
+}
+
+int CompileCache::lock() const
+{
+    string lockName = directory + "/lock";
+    int fd = open(lockName.c_str(), O_RDWR | O_CREAT, 0666);
+    if (fd < 0) return -1;
+
+    if (flock(fd, LOCK_EX) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+void CompileCache::unlock(int fd) const
+{
+    if (fd < 0) return;
+
+    flock(fd, LOCK_UN);
+    close(fd);
+}
+
+void CompileCache::readStatistics(long& savedHits, long& savedMisses) const
+{
+    savedHits = savedMisses = 0;
+
+    ifstream ins(directory + "/stats");
+    string field;
+    ins >> field >> savedHits >> field >> savedMisses;
+    if (ins.fail()) savedHits = savedMisses = 0;
+}
+
+void CompileCache::saveStatistics()
+{
+    if ((hits == 0) && (misses == 0)) return;
+
+    int fd = lock();
+    if (fd < 0) return;
+
+    long savedHits, savedMisses;
+    readStatistics(savedHits, savedMisses);
+
+    string statsName = directory + "/stats";
+    string tempName = statsName + "." + to_string(getpid());
+    {
+        ofstream outs(tempName);
+        outs << "hits "   << savedHits + hits     << "\n"
+             << "misses " << savedMisses + misses << "\n";
+    }
+    rename(tempName.c_str(), statsName.c_str());
+
+    unlock(fd);
+}
+
+int CompileCache::evict(size_t maxBytes)
+{
+    int fd = lock();
+    if (fd < 0) return 0;
+
+    time_t now = time(nullptr);
+    int removed = 0;
+
+    // Temporary files that are an hour old were left by a crash.
+    vector<EntryFile> files;
+    scanFiles(directory + "/tmp", files);
+    for (const EntryFile& file : files)
+    {
+        if (now - file.used > 60*60) unlink(file.path.c_str());
+    }
+
+    files.clear();
+    scanFiles(directory + "/entries", files);
+
+    size_t totalBytes = 0;
+    for (const EntryFile& file : files) totalBytes += file.bytes;
+
+    // Remove the least recently used entries first.
+    sort(files.begin(), files.end(),
+         [] (const EntryFile& a, const EntryFile& b)
+         {
+             return a.used < b.used;
+         });
+
+    for (size_t i = 0; (i < files.size()) && (totalBytes > maxBytes); i++)
+    {
+        if (unlink(files[i].path.c_str()) == 0)
+        {
+            totalBytes -= files[i].bytes;
+            removed++;
+        }
+    }
+
+    unlock(fd);
+    return removed;
+}
+
+void CompileCache::printStatistics(ostream& out)
+{
+    long savedHits, savedMisses;
+    readStatistics(savedHits, savedMisses);
+
+    vector<EntryFile> files;
+    scanFiles(directory + "/entries", files);
+
+    size_t totalBytes = 0;
+    for (const EntryFile& file : files) totalBytes += file.bytes;
+
+    int lookups = hits + misses;
+    long savedLookups = savedHits + savedMisses;
+
+    char line[128];
+    out << endl << "===== COMPILE CACHE =====" << endl << endl;
+    out << "Directory " << directory << endl;
+    snprintf(line, sizeof(line), "%8d hits, %d misses (%.1f%%), %d stored this run\n",
+             hits.load(), misses.load(),
+             lookups > 0 ? 100.0*hits/lookups : 0.0, stores.load());
+    out << line;
+    snprintf(line, sizeof(line), "%8ld hits, %ld misses (%.1f%%) in all runs\n",
+             savedHits, savedMisses,
+             savedLookups > 0 ? 100.0*savedHits/savedLookups : 0.0);
+    out << line;
+    snprintf(line, sizeof(line), "%8zu entries, %zu bytes\n",
+             files.size(), totalBytes);
+    out << line;
+}
+
+} // namespace driver
@@ -0,0 +1,141 @@
+/**
+ * <h1>CompileCache</h1>
+ *
+ * <p>An on-disk cache of compilation outcomes. Each entry is keyed by
+ * a hash of the source bytes, the compiler version and the flags that
+ * affect the output, and it holds the object file contents and the
+ * diagnostics. Entries are written to a temporary file and renamed
+ * into place, so processes on the same machine can share the cache
+ * directory without further coordination. Updates of the statistics
+ * file and eviction hold an exclusive lock on the directory.</p>
+ */
+#ifndef COMPILECACHE_H_
+#define COMPILECACHE_H_
+
+#include <string>
+#include <atomic>
+#include <ostream>
+
+#include "backend/compiler/CompilerOptions.h"
+
+namespace driver {
+
+using namespace std;
+using namespace backend::compiler;
+
+/**
+ * A cached compilation outcome.
+ */
+struct CacheEntry
+{
+    int    syntaxErrors = 0;    // count of syntax errors
+    int    semanticErrors = 0;  // count of semantic errors
+    int    objectLines = 0;     // count of object file lines
+    string diagnostics;         // the printed error reports
+    string object;              // the object file contents, if any
+};
+
+class CompileCache
+{
+private:
+    string directory;           // the cache directory
+    atomic<int> hits;           // lookups found in this run
+    atomic<int> misses;         // lookups not found in this run
+    atomic<int> stores;         // entries written in this run
+
+public:
+    /**
+     * The compiler version that is part of every key. It includes the
+     * build time, so rebuilding the compiler invalidates the entries.
+     */
+    static const char *VERSION;
+
+    /**
+     * Constructor.
+     * @param directory the cache directory, created if necessary.
+     */
+    CompileCache(const string& directory);
+
+    /**
+     * Get the default cache directory: $LUA_CACHE_DIR if it is set,
+     * else $HOME/.cache/luacompiler, else .luacache.
+     * @return the directory name.
+     */
+    static string defaultDirectory();
+
+    /**
+     * Compute the key of a compilation.
+     * @param source the source bytes.
+     * @param programName the program name, which appears in the output.
+     * @param options the code generation options.
+     * @param fold true if constant folding is on.
+     * @return the key.
+     */
+    static string key(const string& source, const string& programName,
+                      const CompilerOptions& options, bool fold);
+
+    /**
+     * Look up an entry and mark it as recently used.
+     * @param key the entry key.
+     * @param entry set to the entry if it is found.
+     * @return true if it is found, else false.
+     */
+    bool lookup(const string& key, CacheEntry& entry);
+
+    /**
+     * Store an entry, replacing any entry with the same key.
+     * @param key the entry key.
+     * @param entry the entry.
+     */
+    void store(const string& key, const CacheEntry& entry);
+
+    /**
+     * Add this run's hits and misses to the statistics file.
+     */
+    void saveStatistics();
+
+    /**
+     * Remove the least recently used entries until the cache
+     * is no larger than a given size.
+     * @param maxBytes the size limit in bytes.
+     * @return the count of entries removed.
+     */
+    int evict(size_t maxBytes);
+
+    /**
+     * Print this run's and the saved statistics and the cache size.
+     * @param out the output stream.
+     */
+    void printStatistics(ostream& out);
+
+private:
+    /**
+     * Get the file name of an entry.
+     * @param key the entry key.
+     * @return the file name.
+     */
+    string entryFileName(const string& key) const;
+
+    /**
+     * Hold an exclusive lock on the cache directory.
+     * @return the lock file descriptor, or -1 if it cannot be locked.
+     */
+    int lock() const;
+
+    /**
+     * Release the lock on the cache directory.
+     * @param fd the lock file descriptor.
+     */
+    void unlock(int fd) const;
+
+    /**
+     * Read the saved statistics.
+     * @param hits set to the saved count of hits.
+     * @param misses set to the saved count of misses.
+     */
+    void readStatistics(long& hits, long& misses) const;
+};
+
+} // namespace driver
+
+#endif /* COMPILECACHE_H_ */
@@ -0,0 +1,373 @@
+#include <iostream>
+#include <string>
+#include <sstream>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <csignal>
+#include <cerrno>
+#include <cstring>
+
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "intermediate/util/WorkStealingPool.h"
+#include "CompileServer.h"
+
+namespace driver {
+
+using namespace std;
+using namespace intermediate::util;
+
+static volatile sig_atomic_t signalled = 0;  // set by SIGINT or SIGTERM
+
+static void onSignal(int) { signalled = 1; }
+
+/**
+ * A client's connection. The server thread reads its requests, and
+ * a worker serves one of them at a time and writes the response.
+ */
+struct Session
+{
+    int fd;               // the connection's file descriptor
+    string buffer;        // bytes read but not yet consumed
+    atomic<bool> busy;    // true while a worker serves a request
+    atomic<bool> broken;  // true if a response could not be written
+    bool closed;          // true after the client closed its end
+
+    Session(int fd) : fd(fd), busy(false), broken(false), closed(false) {}
+};
+
+/**
+ * A complete request.
+ */
+struct Request
+{
+    string line;    // the request line, without its newline
+    string source;  // the source text of a SOURCE request
+    chrono::steady_clock::time_point startTime;  // when it was complete
+};
+
+/**
+ * Take a complete request from the bytes read from a connection.
+ * @param buffer the bytes, from which the request is removed.
+ * @param request set to the request.
+ * @return true if there was a complete request, else false.
+ */
+static bool takeRequest(string& buffer, Request& request)
+{
+    size_t end = buffer.find('\n');
+    if (end == string::npos) return false;
+
+    string line = buffer.substr(0, end);
+    if (!line.empty() && (line.back() == '\r')) line.pop_back();
+    size_t length = end + 1;
+
+    // A SOURCE request is complete only with its source text.
+    istringstream header(line);
+    string command, path;
+    size_t size = 0;
+    header >> command;
+    request.source.clear();
+
+    if (command == "SOURCE")
+    {
+        header >> path >> size;
+        if (!header.fail())
+        {
+            if (buffer.size() - length < size) return false;
+
+            request.source = buffer.substr(length, size);
+            length += size;
+        }
+    }
+
+    request.line = line;
+    request.startTime = chrono::steady_clock::now();
+    buffer.erase(0, length);
+    return true;
+}
+
+/**
+ * Write all of a text to a connection.
+ * @param fd the connection's file descriptor.
+ * @param text the text.
+ * @return true if it was written, else false.
+ */
+static bool writeAll(int fd, const string& text)
+{
+    size_t written = 0;
+    while (written < text.size())
+    {
+        ssize_t count = send(fd, text.data() + written,
+                             text.size() - written, MSG_NOSIGNAL);
+        if (count < 0)
+        {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        written += count;
+    }
+
+    return true;
+}
+
+string CompileServer::defaultSocketPath()
+{
+    const char *path = getenv("LUA_SERVE_SOCKET");
+    if ((path != nullptr) && (*path != '\0')) return path;
+
+    return "/tmp/luacompiler-" + to_string(getuid()) + ".sock";
+}
+
+CompileServer::CompileServer(const string& socketPath,
+                             const DriverOptions& options,
+                             CompileCache *cache, int jobs)
+    : socketPath(socketPath), jobs(jobs < 1 ? 1 : jobs), wakeup{-1, -1},
+      stopping(false)
+{
+    // Requests print nothing but their errors.
+    DriverOptions serverOptions = options;
+    serverOptions.quiet = true;
+
+    for (int i = 0; i < this->jobs; i++)
+    {
+        drivers.emplace_back(new Driver(serverOptions, cache));
+    }
+}
+
+int CompileServer::run()
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (socketPath.size() >= sizeof(address.sun_path))
+    {
+        cout << "ERROR: Socket path \"" << socketPath
+             << "\" is too long." << endl;
+        return -1;
+    }
+    strcpy(address.sun_path, socketPath.c_str());
+
+    // Replace the socket left by a server that did not shut down,
+    // but never any other kind of file.
+    struct stat info;
+    if ((stat(socketPath.c_str(), &info) == 0) && S_ISSOCK(info.st_mode))
+    {
+        unlink(socketPath.c_str());
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (   (listener < 0)
+        || (bind(listener, (struct sockaddr *) &address, sizeof(address)) != 0)
+        || (listen(listener, 64) != 0))
+    {
+        cout << "ERROR: Failed to listen on socket \"" << socketPath
+             << "\": " << strerror(errno) << "." << endl;
+        if (listener >= 0) close(listener);
+        return -1;
+    }
+
+    // Workers wake the server thread through a pipe that never blocks.
+    if (pipe(wakeup) != 0)
+    {
+        cout << "ERROR: Failed to create a pipe: " << strerror(errno)
+             << "." << endl;
+        close(listener);
+        return -1;
+    }
+    fcntl(wakeup[0], F_SETFL, O_NONBLOCK);
+    fcntl(wakeup[1], F_SETFL, O_NONBLOCK);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onSignal;
+    sigaction(SIGINT,  &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    cout << "Serving on \"" << socketPath << "\" with " << jobs
+         << (jobs == 1 ? " worker." : " workers.") << endl;
+
+    vector<unique_ptr<Session>> sessions;
+
+    {
+        WorkStealingPool pool(jobs);
+
+        while (!stopping && !signalled)
+        {
+            // Queue the next complete request of each idle connection,
+            // and close the connections that are done.
+            for (auto it = sessions.begin(); it != sessions.end(); )
+            {
+                Session *session = it->get();
+                Request request;
+
+                if (session->busy) it++;
+                else if (!session->broken && takeRequest(session->buffer, request))
+                {
+                    session->busy = true;
+                    pool.submit([this, session, request] (int worker)
+                    {
+                        string response = serve(request, drivers[worker].get());
+                        if (!response.empty() && !writeAll(session->fd, response))
+                        {
+                            session->broken = true;
+                        }
+                        session->busy = false;
+
+                        // A full pipe wakes the server already.
+                        char byte = 0;
+                        if (write(wakeup[1], &byte, 1) < 0) return;
+                    });
+                    it++;
+                }
+                else if (session->closed || session->broken)
+                {
+                    close(session->fd);
+                    it = sessions.erase(it);
+                }
+                else it++;
+            }
+
+            // Wait for a new connection, more bytes from an idle one,
+            // or a worker that finished.
+            vector<struct pollfd> ready;
+            vector<Session *> reading;
+            ready.push_back({listener, POLLIN, 0});
+            ready.push_back({wakeup[0], POLLIN, 0});
+            for (unique_ptr<Session>& session : sessions)
+            {
+                if (!session->busy && !session->closed && !session->broken)
+                {
+                    ready.push_back({session->fd, POLLIN, 0});
+                    reading.push_back(session.get());
+                }
+            }
+
+            if (poll(ready.data(), ready.size(), 200) <= 0) continue;
+
+            if (ready[1].revents != 0)
+            {
+                char bytes[64];
+                while (read(wakeup[0], bytes, sizeof(bytes)) > 0) {}
+            }
+
+            if (ready[0].revents != 0)
+            {
+                int fd = accept(listener, nullptr, nullptr);
+                if (fd >= 0) sessions.emplace_back(new Session(fd));
+            }
+
+            for (size_t i = 0; i < reading.size(); i++)
+            {
+                if (ready[i + 2].revents == 0) continue;
+
+                char chunk[64*1024];
+                ssize_t count = recv(reading[i]->fd, chunk, sizeof(chunk), 0);
+
+                if (count > 0) reading[i]->buffer.append(chunk, count);
+                else if ((count == 0) || (errno != EINTR)) reading[i]->closed = true;
+            }
+        }
+
+        pool.wait();
+    }
+
+    for (unique_ptr<Session>& session : sessions) close(session->fd);
+    close(wakeup[0]);
+    close(wakeup[1]);
+    close(listener);
+    unlink(socketPath.c_str());
+
+    cout << endl << "===== REQUEST LATENCY =====" << endl << endl
+         << statistics();
+    return 0;
+}
+
+string CompileServer::serve(const Request& request, Driver *driver)
+{
+    istringstream in(request.line);
+    string command, path;
+    in >> command;
+
+    if (command == "COMPILE")
+    {
+        getline(in >> ws, path);
+        CompileResult result = driver->compile(path);
+        return respond(result, chrono::duration<double>(
+                   chrono::steady_clock::now() - request.startTime).count());
+    }
+    else if (command == "SOURCE")
+    {
+        size_t size = 0;
+        in >> path >> size;
+
+        if (in.fail()) return "ERROR expected SOURCE path size\nEND\n";
+
+        CompileResult result = driver->compileSource(path, request.source);
+        return respond(result, chrono::duration<double>(
+                   chrono::steady_clock::now() - request.startTime).count());
+    }
+    else if (command == "STATS")
+    {
+        return statistics() + "END\n";
+    }
+    else if (command == "SHUTDOWN")
+    {
+        stopping = true;
+        return "STOPPING\nEND\n";
+    }
+    else if (command.empty())
+    {
+        return "";
+    }
+
+    return "ERROR unknown request " + command + "\nEND\n";
+}
+
+string CompileServer::respond(const CompileResult& result, double seconds)
+{
+    {
+        lock_guard<mutex> lock(histogramMutex);
+        histogram.add(seconds);
+    }
+
+    string diagnostics = result.diagnostics;
+    if (!result.opened)
+    {
+        diagnostics = "ERROR: Failed to open source file \""
+                    + result.sourceFile + "\".\n";
+    }
+
+    char latency[32];
+    snprintf(latency, sizeof(latency), "%.3f", seconds*1000);
+
+    string response;
+    response += result.succeeded() ? "STATUS ok\n" : "STATUS failed\n";
+    response += "SYNTAX "   + to_string(result.syntaxErrors)   + "\n";
+    response += "SEMANTIC " + to_string(result.semanticErrors) + "\n";
+    if (!result.objectFile.empty())
+    {
+        response += "OBJECT " + result.objectFile + "\n";
+    }
+    response += result.cached ? "CACHED yes\n" : "CACHED no\n";
+    response += string("MS ") + latency + "\n";
+    response += "DIAGNOSTICS " + to_string(diagnostics.size()) + "\n";
+    response += diagnostics;
+    response += "END\n";
+
+    return response;
+}
+
+string CompileServer::statistics()
+{
+    lock_guard<mutex> lock(histogramMutex);
+    return histogram.toString();
+}
+
+} // namespace driver
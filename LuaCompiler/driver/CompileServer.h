@@ -0,0 +1,116 @@
+/**
+ * <h1>CompileServer</h1>
+ *
+ * <p>Compile on request from clients that connect to a Unix domain
+ * socket. The drivers live as long as the server, so the lexer and
+ * parser DFA caches stay warm from one request to the next.</p>
+ *
+ * <p>Each request is one line, and a connection can send any number.
+ * The server reads the requests of every connection itself and queues
+ * each complete request for a worker, so a connection holds a worker
+ * only while one of its requests is being served, and an idle client
+ * never keeps the others waiting. The requests of a connection are
+ * served one at a time, in order. The requests are</p>
+ * <pre>
+ *   COMPILE path                 compile a source file
+ *   SOURCE path size             compile the next size bytes, using
+ *                                path to name the program and output
+ *   STATS                        report the latency histogram
+ *   SHUTDOWN                     stop the server
+ * </pre>
+ * <p>A compile response is</p>
+ * <pre>
+ *   STATUS ok|failed
+ *   SYNTAX count
+ *   SEMANTIC count
+ *   OBJECT path                  only if the object file was created
+ *   CACHED yes|no
+ *   MS latency
+ *   DIAGNOSTICS size             followed by size bytes of error report
+ *   END
+ * </pre>
+ * <p>Other responses are text lines followed by END, or an ERROR
+ * line followed by END.</p>
+ */
+#ifndef COMPILESERVER_H_
+#define COMPILESERVER_H_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+#include "intermediate/util/LatencyHistogram.h"
+#include "Driver.h"
+
+namespace driver {
+
+using namespace std;
+using namespace intermediate::util;
+
+struct Request;
+
+class CompileServer
+{
+private:
+    string socketPath;                  // the socket file name
+    int jobs;                           // requests served at once
+    int wakeup[2];                      // a pipe that a worker writes to
+                                        // when it finishes a request
+    vector<unique_ptr<Driver>> drivers; // one per worker, reused
+    atomic<bool> stopping;              // true after SHUTDOWN
+    mutex histogramMutex;               // guards the histogram
+    LatencyHistogram histogram;         // latency of the compile requests
+
+public:
+    /**
+     * Get the default socket file name: $LUA_SERVE_SOCKET if it is
+     * set, else one in /tmp that is private to the user.
+     * @return the file name.
+     */
+    static string defaultSocketPath();
+
+    /**
+     * Constructor.
+     * @param socketPath the socket file name.
+     * @param options the driver options.
+     * @param cache the compile cache, or null.
+     * @param jobs the count of requests to serve at once.
+     */
+    CompileServer(const string& socketPath, const DriverOptions& options,
+                  CompileCache *cache, int jobs);
+
+    /**
+     * Serve requests until a SHUTDOWN request or a SIGINT or SIGTERM.
+     * @return 0 if the server ran, or -1 if the socket failed.
+     */
+    int run();
+
+private:
+    /**
+     * Serve one request.
+     * @param request the request.
+     * @param driver the driver to compile with.
+     * @return the response, or empty if the request was a blank line.
+     */
+    string serve(const Request& request, Driver *driver);
+
+    /**
+     * Format the response to a compile request, and count its latency.
+     * @param result the outcome of the compilation.
+     * @param seconds the latency of the request.
+     * @return the response text.
+     */
+    string respond(const CompileResult& result, double seconds);
+
+    /**
+     * Format the latency histogram.
+     * @return the text.
+     */
+    string statistics();
+};
+
+} // namespace driver
+
+#endif /* COMPILESERVER_H_ */
@@ -0,0 +1,406 @@
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <chrono>
+#include <algorithm>
+
+#include "antlr4-runtime.h"
+#include "LuaLexer.h"
+#include "LuaParser.h"
+
+#include "frontend/Listing.h"
+#include "frontend/SyntaxErrorHandler.h"
+#include "frontend/Semantics.h"
+#include "frontend/ConstantFolder.h"
+#include "frontend/TypeInference.h"
+#include "frontend/AstLowering.h"
+#include "intermediate/symtab/SymtabEntry.h"
+#include "intermediate/util/CrossReferencer.h"
+#include "intermediate/util/Tracer.h"
+#include "backend/compiler/Compiler.h"
+#include "Driver.h"
+
+namespace driver {
+
+using namespace std;
+using namespace antlr4;
+using namespace frontend;
+using namespace intermediate::symtab;
+using namespace intermediate::util;
+using namespace backend::compiler;
+
+Driver::Driver(const DriverOptions& options, CompileCache *cache)
+    : options(options), cache(cache), lexer(&input), tokens(&lexer), parser(&tokens)
+{
+    lexer.removeErrorListeners();
+}
+
+CompileResult Driver::compile(const string& sourceFile)
+{
+    ifstream ins(sourceFile);
+    if (ins.fail())
+    {
+        cout << "ERROR: Failed to open source file \""
+             << sourceFile << "\"." << endl;
+        CompileResult result;
+        result.sourceFile = sourceFile;
+        return result;
+    }
+
+    stringstream text;
+    text << ins.rdbuf();
+    return compileSource(sourceFile, text.str());
+}
+
+CompileResult Driver::compileSource(const string& sourceFile,
+                                    const string& source)
+{
+    auto startTime = chrono::steady_clock::now();
+    TraceSpan span("file", "compile", sourceFile);
+
+    CompileResult result;
+    result.sourceFile = sourceFile;
+    result.opened = true;
+    result.sourceLines = count(source.begin(), source.end(), '\n');
+
+    string sourceFileName = sourceFile.substr(0, sourceFile.size()-4);
+    PassTimer& timer = result.passes;
+
+    if (!options.quiet)
+    {
+        timer.start("listing");
+        cout << "PASS 1: \n";
+        // Generate a source file listing.
+        Listing listing(sourceFile);
+    }
+
+    // An unchanged source compiled with the same flags needs no passes.
+    string cacheKey;
+    CacheEntry entry;
+    if (cache != nullptr)
+    {
+        timer.start("cache lookup");
+        cacheKey = CompileCache::key(source, sourceFileName,
+                                     options.compiler, options.fold);
+        if (cache->lookup(cacheKey, entry))
+        {
+            restore(entry, sourceFileName, result);
+            timer.stop();
+            result.seconds = chrono::duration<double>(
+                                 chrono::steady_clock::now() - startTime).count();
+            return result;
+        }
+    }
+
+    // Point the reused lexer, token stream and parser at the new
+    // source. Their ATN and DFA caches carry over between files.
+    SyntaxErrorHandler syntaxErrorHandler;
+    input.load(source);
+    lexer.setInputStream(&input);
+    lexer.removeErrorListeners();
+    lexer.addErrorListener(&syntaxErrorHandler);
+    tokens.setTokenSource(&lexer);
+    parser.setTokenStream(&tokens);
+
+    // Pass 1: Check syntax and create the parse tree. The parser
+    // pulls tokens as it goes, unless the lexer is timed on its own,
+    // which it also is whenever the trace is on.
+    if (options.timePasses || Tracer::isEnabled())
+    {
+        timer.start("lex");
+        tokens.fill();
+    }
+    timer.start("parse");
+    tree::ParseTree *tree = parse(&syntaxErrorHandler);
+    timer.stop();
+    timer.count("tokens", tokens.size());
+    timer.count("parse tree nodes", countNodes(tree));
+
+    // Syntax errors were reported synchronously during the parse.
+    result.syntaxErrors = syntaxErrorHandler.getCount();
+    if (result.syntaxErrors > 0)
+    {
+        result.diagnostics = syntaxErrorHandler.getDiagnostics();
+        if (cache != nullptr)
+        {
+            entry.syntaxErrors = result.syntaxErrors;
+            entry.diagnostics = result.diagnostics;
+            cache->store(cacheKey, entry);
+        }
+
+        printf("\nThere were %d syntax errors.\n", result.syntaxErrors);
+        cout << "Object file not created or modified." << endl;
+        return result;
+    }
+
+    // Pass 2: Create symbol tables and set parse tree node datatypes.
+    if (!options.quiet) cout << "\nPASS 2:";
+    timer.start("semantics");
+    Semantics pass2(sourceFileName, false);
+    pass2.visit(tree);
+    timer.stop();
+    timer.count("symbols", countSymbols(pass2.getProgramId()));
+    timer.count("symbol table bytes",
+                pass2.getSymtabStack()->getArena().getBytesReserved());
+
+    if (!options.quiet)
+    {
+        timer.start("cross-reference");
+        CrossReferencer crossReferencer;
+        crossReferencer.print(pass2.getSymtabStack());
+        timer.stop();
+    }
+
+    result.semanticErrors = pass2.getErrorCount();
+    if (result.semanticErrors > 0)
+    {
+        result.diagnostics = pass2.getDiagnostics();
+        if (cache != nullptr)
+        {
+            entry.semanticErrors = result.semanticErrors;
+            entry.diagnostics = result.diagnostics;
+            cache->store(cacheKey, entry);
+        }
+
+        cout << endl << "There were " << result.semanticErrors
+             << " semantic errors." << " Object file not created or modified."
+             << endl;
+        return result;
+    }
+
+    // Fold constant expressions and simplify identities.
+    if (options.fold)
+    {
+        timer.start("fold");
+        ConstantFolder folder;
+        folder.visit(tree);
+        if (!options.quiet)
+        {
+            printf("\n%d constant expressions folded, %d simplified.",
+                   folder.getFoldCount(), folder.getSimplifyCount());
+        }
+    }
+
+    // Infer the types of the variables and expressions.
+    timer.start("infer");
+    TypeInference inference(pass2.getProgramId());
+    inference.visit(tree);
+    if (!options.quiet)
+    {
+        printf("\n%d of %d variables specialized (%d inference rounds).",
+               inference.getSpecializedCount(), inference.getVariableCount(),
+               inference.getRoundCount());
+    }
+
+    // Lower the program into compact nodes for code generation.
+    timer.start("lower");
+    AstLowering lowering;
+    lowering.visit(tree);
+    if (!options.quiet)
+    {
+        printf("\n%d nodes lowered (%zu bytes).",
+               lowering.getNodeCount(), lowering.getBytesUsed());
+    }
+
+    // Code generation reads only the lowered nodes, so free the parse
+    // tree and the tokens now instead of keeping them through pass 3.
+    parser.reset();
+    tokens.setTokenSource(&lexer);
+
+    // Pass 3: Compile the Lua program.
+    if (!options.quiet) cout << "\nPASS 3: \n";
+    SymtabEntry *programId = pass2.getProgramId();
+    timer.start("compile");
+    auto pass3Start = chrono::steady_clock::now();
+    Compiler pass3(programId, options.compiler);
+    pass3.compileProgram(lowering.getProgram());
+    auto pass3End = chrono::steady_clock::now();
+    timer.stop();
+    timer.count("instructions", pass3.getObjectFileInstructionCount());
+
+    result.objectFile  = pass3.getObjectFileName();
+    result.objectBytes = pass3.getObjectFileByteCount();
+
+    // The JVM would reject a method whose stack is wrong,
+    // so do not leave its object file behind or cache it.
+    result.stackErrors = pass3.getStackErrorCount();
+    if (result.stackErrors > 0)
+    {
+        remove(result.objectFile.c_str());
+        result.objectFile.clear();
+        result.objectBytes = 0;
+        result.diagnostics = "There were " + to_string(result.stackErrors)
+                           + " stack errors in the generated code.\n";
+
+        cout << endl << result.diagnostics
+             << "Object file not created." << endl;
+        return result;
+    }
+
+    // Keep a copy of the object file, which is complete once
+    // the compiler has closed it.
+    if (cache != nullptr)
+    {
+        timer.start("cache store");
+        ifstream objectIns(result.objectFile, ios::binary);
+        stringstream object;
+        object << objectIns.rdbuf();
+        if (!objectIns.fail())
+        {
+            entry.object = object.str();
+            entry.objectLines = pass3.getObjectFileLineCount();
+            cache->store(cacheKey, entry);
+        }
+        timer.stop();
+    }
+
+    if (!options.quiet)
+    {
+        cout << "Object file \"" << result.objectFile << "\" created." << endl;
+
+        // Object code emission rate.
+        double seconds = chrono::duration<double>(pass3End - pass3Start).count();
+        if (options.compiler.emit == EmitFormat::CLASS)
+        {
+            printf("%zu bytes emitted in %.3f ms.\n",
+                   result.objectBytes, seconds*1000);
+        }
+        else
+        {
+            int lines = pass3.getObjectFileLineCount();
+            printf("%d lines emitted in %.3f ms (%.0f lines/sec%s).\n",
+                   lines, seconds*1000, seconds > 0 ? lines/seconds : 0.0,
+                   options.compiler.syncOutput ? ", synchronous output" : "");
+        }
+    }
+
+    if (options.peepholeStats && (pass3.getPeepholeOptimizer() != nullptr))
+    {
+        pass3.getPeepholeOptimizer()->printStatistics(cout);
+    }
+
+    result.seconds = chrono::duration<double>(
+                         chrono::steady_clock::now() - startTime).count();
+    return result;
+}
+
+void Driver::restore(const CacheEntry& entry, const string& programName,
+                     CompileResult& result)
+{
+    result.cached = true;
+    result.syntaxErrors   = entry.syntaxErrors;
+    result.semanticErrors = entry.semanticErrors;
+    result.diagnostics    = entry.diagnostics;
+
+    // Repeat the diagnostics as the passes printed them.
+    if (result.syntaxErrors > 0)
+    {
+        fputs(entry.diagnostics.c_str(), stdout);
+        printf("\nThere were %d syntax errors.\n", result.syntaxErrors);
+        cout << "Object file not created or modified." << endl;
+        return;
+    }
+    if (result.semanticErrors > 0)
+    {
+        fputs(entry.diagnostics.c_str(), stdout);
+        cout << endl << "There were " << result.semanticErrors
+             << " semantic errors." << " Object file not created or modified."
+             << endl;
+        return;
+    }
+
+    string suffix = options.compiler.emit == EmitFormat::CLASS ? "class" : "j";
+    result.objectFile = programName + "." + suffix;
+
+    ofstream objectOuts(result.objectFile, ios::binary);
+    objectOuts.write(entry.object.data(), entry.object.size());
+    objectOuts.close();
+    if (objectOuts.fail())
+    {
+        cout << "ERROR: Failed to write object file \""
+             << result.objectFile << "\"." << endl;
+        result.objectFile.clear();
+        result.opened = false;  // counts as a failure
+        return;
+    }
+
+    result.objectBytes = entry.object.size();
+
+    if (!options.quiet)
+    {
+        cout << "Object file \"" << result.objectFile
+             << "\" restored from the cache." << endl;
+    }
+}
+
+int Driver::countNodes(tree::ParseTree *node)
+{
+    int count = 1;
+    for (tree::ParseTree *child : node->children) count += countNodes(child);
+
+    return count;
+}
+
+int Driver::countSymbols(SymtabEntry *routineId)
+{
+    if (routineId == nullptr) return 0;
+
+    int count = routineId->getRoutineSymtab()->size();
+
+    SymtabEntries *routineIds = routineId->getSubroutines();
+    if (routineIds != nullptr)
+    {
+        for (SymtabEntry *subroutineId : *routineIds)
+        {
+            count += countSymbols(subroutineId);
+        }
+    }
+
+    return count;
+}
+
+tree::ParseTree *Driver::parse(ANTLRErrorListener *syntaxErrorHandler)
+{
+    // First try the faster SLL prediction, which bails out at the
+    // first syntax error. Only then reparse with full LL prediction
+    // and report the errors.
+    auto parseStart = chrono::steady_clock::now();
+    tree::ParseTree *tree = nullptr;
+    bool sllParse = true;
+
+    parser.getInterpreter<atn::ParserATNSimulator>()
+          ->setPredictionMode(atn::PredictionMode::SLL);
+    parser.removeErrorListeners();
+    parser.setErrorHandler(make_shared<BailErrorStrategy>());
+
+    try
+    {
+        tree = parser.chunk();
+    }
+    catch (ParseCancellationException& ex)
+    {
+        sllParse = false;
+        tokens.seek(0);
+        parser.reset();
+        parser.addErrorListener(syntaxErrorHandler);
+        parser.setErrorHandler(make_shared<DefaultErrorStrategy>());
+        parser.getInterpreter<atn::ParserATNSimulator>()
+              ->setPredictionMode(atn::PredictionMode::LL);
+
+        tree = parser.chunk();
+    }
+
+    if (!options.quiet)
+    {
+        auto parseEnd = chrono::steady_clock::now();
+        printf("Parsed with %s prediction in %.3f ms.\n",
+               sllParse ? "SLL" : "full LL",
+               chrono::duration<double>(parseEnd - parseStart).count()*1000);
+    }
+
+    return tree;
+}
+
+} // namespace driver
@@ -0,0 +1,141 @@
+/**
+ * <h1>Driver</h1>
+ *
+ * <p>Run the compiler passes over one source file after another,
+ * reusing the same lexer, token stream and parser objects.</p>
+ */
+#ifndef DRIVER_H_
+#define DRIVER_H_
+
+#include <string>
+
+#include "antlr4-runtime.h"
+#include "LuaLexer.h"
+#include "LuaParser.h"
+
+#include "backend/compiler/CompilerOptions.h"
+#include "intermediate/symtab/SymtabEntry.h"
+#include "CompileCache.h"
+#include "PassTimer.h"
+
+namespace driver {
+
+using namespace std;
+using namespace antlr4;
+using namespace intermediate::symtab;
+using namespace backend::compiler;
+
+/**
+ * Options of the driver, in addition to the code generation options.
+ */
+struct DriverOptions
+{
+    CompilerOptions compiler;   // code generation options
+    bool fold = true;           // fold constant expressions
+    bool peepholeStats = false; // print the peephole rule hits
+    bool quiet = false;         // no listing or per-pass messages
+    bool timePasses = false;    // time the lexer apart from the parser,
+                                // as it is whenever the trace is on
+};
+
+/**
+ * The outcome of compiling one source file.
+ */
+struct CompileResult
+{
+    string sourceFile;          // the source file name
+    string objectFile;          // the object file name, if created
+    bool   opened = false;      // true if the source file was read
+    int    syntaxErrors = 0;    // count of syntax errors
+    int    semanticErrors = 0;  // count of semantic errors
+    int    stackErrors = 0;     // count of stack errors in the generated code
+    int    sourceLines = 0;     // count of source lines
+    size_t objectBytes = 0;     // size of the object file
+    double seconds = 0;         // compile time
+    bool   cached = false;      // true if restored from the cache
+    string diagnostics;         // the syntax or semantic error report
+    PassTimer passes;           // the phase measurements and counts
+
+    /**
+     * Determine whether the object file was created.
+     * @return true if it was, else false.
+     */
+    bool succeeded() const
+    {
+        return    opened && (syntaxErrors == 0) && (semanticErrors == 0)
+               && (stackErrors == 0);
+    }
+};
+
+class Driver
+{
+private:
+    DriverOptions options;    // the driver options
+    CompileCache *cache;      // the compile cache, or null
+    ANTLRInputStream input;   // the current source text
+    LuaLexer lexer;           // reused for every file
+    CommonTokenStream tokens; // reused for every file
+    LuaParser parser;         // reused for every file
+
+public:
+    /**
+     * Constructor.
+     * @param options the driver options.
+     * @param cache the compile cache, or null to always compile.
+     */
+    Driver(const DriverOptions& options, CompileCache *cache = nullptr);
+
+    /**
+     * Compile a source file into an object file.
+     * @param sourceFile the source file name.
+     * @return the outcome.
+     */
+    CompileResult compile(const string& sourceFile);
+
+    /**
+     * Compile source text into an object file.
+     * @param sourceFile the source file name, which names the program
+     * and the object file. The file itself is not read.
+     * @param source the source text.
+     * @return the outcome.
+     */
+    CompileResult compileSource(const string& sourceFile, const string& source);
+
+private:
+    /**
+     * Finish a compilation from a cache entry instead of running
+     * the passes: report the cached diagnostics, or else write
+     * the cached object file.
+     * @param entry the cache entry.
+     * @param programName the program name.
+     * @param result the outcome to complete.
+     */
+    void restore(const CacheEntry& entry, const string& programName,
+                 CompileResult& result);
+
+    /**
+     * Count the nodes of a parse tree.
+     * @param node the root node.
+     * @return the count.
+     */
+    static int countNodes(tree::ParseTree *node);
+
+    /**
+     * Count the symbols of a routine and of its nested routines.
+     * @param routineId the routine's symbol table entry, or null.
+     * @return the count.
+     */
+    static int countSymbols(SymtabEntry *routineId);
+
+    /**
+     * Parse the current input, first with SLL prediction and then,
+     * only if that fails, with full LL prediction.
+     * @param syntaxErrorHandler the handler to report errors to.
+     * @return the parse tree.
+     */
+    tree::ParseTree *parse(ANTLRErrorListener *syntaxErrorHandler);
+};
+
+} // namespace driver
+
+#endif /* DRIVER_H_ */
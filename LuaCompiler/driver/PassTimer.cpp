@@ -0,0 +1,160 @@
+#include <string>
+#include <cstdio>
+#include <ctime>
+
+#include <sys/resource.h>
+
+#include "intermediate/util/Tracer.h"
+#include "AllocationCounter.h"
+#include "PassTimer.h"
+
+namespace driver {
+
+using namespace std;
+using namespace intermediate::util;
+
+bool PassTimer::processWide = false;
+
+void PassTimer::measureProcess(bool on)
+{
+    processWide = on;
+    countProcessAllocations(on);
+}
+
+void PassTimer::start(const string& phase)
+{
+    stop();
+
+    name = phase;
+    allocationStart = allocations();
+    cpuStart = cpuSeconds();
+    wallStart = chrono::steady_clock::now();
+}
+
+void PassTimer::stop()
+{
+    if (name.empty()) return;
+
+    auto wallEnd = chrono::steady_clock::now();
+    double cpuEnd = cpuSeconds();
+    long allocationEnd = allocations();
+
+    timings.push_back({name,
+                       chrono::duration<double>(wallEnd - wallStart).count(),
+                       cpuEnd - cpuStart,
+                       allocationEnd - allocationStart,
+                       peakRssKb()});
+
+    // Each phase is also a span of the trace.
+    if (Tracer::isEnabled())
+    {
+        Tracer::complete("pass", name, "", Tracer::micros(wallStart),
+                         Tracer::micros(wallEnd));
+    }
+
+    name.clear();
+}
+
+double PassTimer::cpuSeconds()
+{
+    struct timespec time;
+    clockid_t clock = processWide ? CLOCK_PROCESS_CPUTIME_ID
+                                  : CLOCK_THREAD_CPUTIME_ID;
+    if (clock_gettime(clock, &time) != 0) return 0;
+    return time.tv_sec + time.tv_nsec/1e9;
+}
+
+long PassTimer::allocations()
+{
+    return processWide ? processAllocationCount() : allocationCount();
+}
+
+long PassTimer::peakRssKb()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return usage.ru_maxrss;  // kilobytes on Linux
+}
+
+string PassTimer::toText(const string& sourceFile) const
+{
+    string text;
+    char line[160];
+
+    text += "\n===== PASS TIMES: " + sourceFile + " =====\n\n";
+    snprintf(line, sizeof(line), "%-16s %10s %10s %12s %12s\n",
+             "Phase", "Wall ms", "CPU ms", "Allocations", "Peak RSS KB");
+    text += line;
+    snprintf(line, sizeof(line), "%-16s %10s %10s %12s %12s\n",
+             "-----", "-------", "------", "-----------", "-----------");
+    text += line;
+
+    double wallTotal = 0, cpuTotal = 0;
+    long allocationTotal = 0, peak = 0;
+
+    for (const PassTiming& timing : timings)
+    {
+        snprintf(line, sizeof(line), "%-16s %10.3f %10.3f %12ld %12ld\n",
+                 timing.name.c_str(), timing.wallSeconds*1000,
+                 timing.cpuSeconds*1000, timing.allocations,
+                 timing.peakRssKb);
+        text += line;
+
+        wallTotal += timing.wallSeconds;
+        cpuTotal  += timing.cpuSeconds;
+        allocationTotal += timing.allocations;
+        if (timing.peakRssKb > peak) peak = timing.peakRssKb;
+    }
+
+    snprintf(line, sizeof(line), "%-16s %10.3f %10.3f %12ld %12ld\n",
+             "total", wallTotal*1000, cpuTotal*1000, allocationTotal, peak);
+    text += line;
+
+    text += processWide ? "(CPU and allocations of every thread)\n"
+                        : "(CPU and allocations of the compiling thread)\n";
+
+    if (!counts.empty()) text += "\n";
+    for (const pair<string, long>& count : counts)
+    {
+        snprintf(line, sizeof(line), "%12ld %s\n",
+                 count.second, count.first.c_str());
+        text += line;
+    }
+
+    return text;
+}
+
+string PassTimer::toJson(const string& sourceFile) const
+{
+    string json;
+    char number[160];
+
+    json += "{\"file\": " + Tracer::jsonString(sourceFile)
+          + ", \"cpu_scope\": \"" + (processWide ? "process" : "thread")
+          + "\", \"passes\": [";
+    for (size_t i = 0; i < timings.size(); i++)
+    {
+        const PassTiming& timing = timings[i];
+        snprintf(number, sizeof(number),
+                 "\"wall_ms\": %.6f, \"cpu_ms\": %.6f, "
+                 "\"allocations\": %ld, \"peak_rss_kb\": %ld}",
+                 timing.wallSeconds*1000, timing.cpuSeconds*1000,
+                 timing.allocations, timing.peakRssKb);
+
+        if (i > 0) json += ", ";
+        json += "{\"name\": " + Tracer::jsonString(timing.name) + ", " + number;
+    }
+
+    json += "], \"counts\": {";
+    for (size_t i = 0; i < counts.size(); i++)
+    {
+        if (i > 0) json += ", ";
+        json += Tracer::jsonString(counts[i].first) + ": "
+              + to_string(counts[i].second);
+    }
+    json += "}}";
+
+    return json;
+}
+
+} // namespace driver
@@ -0,0 +1,132 @@
+/**
+ * <h1>PassTimer</h1>
+ *
+ * <p>Measure each phase of a compilation: wall time, CPU time, heap
+ * allocations, and the peak resident set size of the process afterwards.
+ * Also keep named counts such as the number of tokens, and format
+ * everything as a table or as JSON. When tracing is on, each phase is
+ * also recorded as a trace span.</p>
+ *
+ * <p>CPU time and allocations are those of the compiling thread, which
+ * is right when several files compile at once. When a single file
+ * compiles, measure the process instead, so that the phases include
+ * the work of the threads that generate its routines in parallel.</p>
+ */
+#ifndef PASSTIMER_H_
+#define PASSTIMER_H_
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <chrono>
+
+namespace driver {
+
+using namespace std;
+
+/**
+ * The measurements of one phase.
+ */
+struct PassTiming
+{
+    string name;            // the phase name
+    double wallSeconds;     // elapsed time
+    double cpuSeconds;      // CPU time of the thread or the process
+    long   allocations;     // heap allocations of the thread or the process
+    long   peakRssKb;       // process peak resident set size afterwards
+};
+
+class PassTimer
+{
+private:
+    vector<PassTiming> timings;         // the finished phases, in order
+    vector<pair<string, long>> counts;  // the named counts, in order
+
+    string name;                        // the running phase, if any
+    chrono::steady_clock::time_point wallStart;
+    double cpuStart;
+    long allocationStart;
+
+    static bool processWide;            // measure every thread
+
+public:
+    /**
+     * Measure the CPU time and allocations of the whole process rather
+     * than of the compiling thread. Only right while a single file
+     * compiles, since other compilations would be counted too.
+     * @param on true to measure the process.
+     */
+    static void measureProcess(bool on);
+
+    /**
+     * Start timing a phase, which ends any running phase.
+     * @param phase the phase name.
+     */
+    void start(const string& phase);
+
+    /**
+     * End the running phase, if any.
+     */
+    void stop();
+
+    /**
+     * Record a named count.
+     * @param what the name of the count.
+     * @param value the count.
+     */
+    void count(const string& what, long value)
+    {
+        counts.emplace_back(what, value);
+    }
+
+    /**
+     * Get the finished phases.
+     * @return the phase measurements, in order.
+     */
+    const vector<PassTiming>& getTimings() const { return timings; }
+
+    /**
+     * Get the named counts.
+     * @return the counts, in the order they were recorded.
+     */
+    const vector<pair<string, long>>& getCounts() const { return counts; }
+
+    /**
+     * Format the measurements as a table.
+     * @param sourceFile the source file name for the heading.
+     * @return the table text.
+     */
+    string toText(const string& sourceFile) const;
+
+    /**
+     * Format the measurements as a JSON object.
+     * @param sourceFile the source file name.
+     * @return the JSON text.
+     */
+    string toJson(const string& sourceFile) const;
+
+private:
+    /**
+     * Get the CPU time used so far by the calling thread,
+     * or by the process if it is measured.
+     * @return the time in seconds.
+     */
+    static double cpuSeconds();
+
+    /**
+     * Get the count of heap allocations so far by the calling thread,
+     * or by the process if it is measured.
+     * @return the count.
+     */
+    static long allocations();
+
+    /**
+     * Get the peak resident set size of the process.
+     * @return the size in kilobytes.
+     */
+    static long peakRssKb();
+};
+
+} // namespace driver
+
+#endif /* PASSTIMER_H_ */
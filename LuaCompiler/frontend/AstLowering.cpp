@@ -0,0 +1,286 @@
+#include <string>
+
+#include "antlr4-runtime.h"
+
+#include "LuaBaseVisitor.h"
+#include "intermediate/symtab/Predefined.h"
+#include "AstLowering.h"
+
+namespace frontend {
+
+using namespace std;
+
+Object AstLowering::visitChunk(LuaParser::ChunkContext *ctx)
+{
+	program = arena.create<ProgramNode>();
+
+	// The functions are the definitions that begin the chunk.
+	RoutineNode **routine = &program->routines;
+	for (LuaParser::StatContext *statCtx : ctx->block()->stat())
+	{
+		LuaParser::FunctiondefContext *defCtx = statCtx->functiondef();
+		if (defCtx == nullptr) break;
+
+		nodeCount++;
+		*routine = arena.create<RoutineNode>(defCtx->entry,
+		                                     defCtx->getStart()->getLine());
+		(*routine)->block = lower(defCtx->funcbody()->block());
+		routine = &(*routine)->next;
+	}
+
+	program->block = lower(ctx->block());
+	return nullptr;
+}
+
+StatNode *AstLowering::lower(LuaParser::BlockContext *ctx)
+{
+	StatNode *first = nullptr;
+	StatNode **next = &first;
+
+	for (LuaParser::StatContext *statCtx : ctx->stat())
+	{
+		StatNode *stat = lower(statCtx);
+		if (stat == nullptr) continue;
+
+		*next = stat;
+		next = &stat->next;
+	}
+
+	if (ctx->retstat() != nullptr) *next = lower(ctx->retstat());
+	return first;
+}
+
+StatNode *AstLowering::lower(LuaParser::StatContext *ctx)
+{
+	StatNode *stat = nullptr;
+
+	if (ctx->assignStat() != nullptr)
+	{
+		stat = newNode(StatKind::ASSIGN);
+		stat->exp = lower(ctx->assignStat()->exp());
+		stat->entry = ctx->assignStat()->var_()->entry;
+	}
+
+	else if (ctx->functioncall() != nullptr)
+	{
+		stat = newNode(StatKind::CALL);
+		stat->exp = lower(ctx->functioncall());
+	}
+
+	else if (ctx->repeatStat() != nullptr)
+	{
+		stat = newNode(StatKind::REPEAT);
+		stat->block = lower(ctx->repeatStat()->block());
+		stat->exp = lower(ctx->repeatStat()->exp());
+	}
+
+	else if (ctx->printStat() != nullptr)
+	{
+		stat = newNode(StatKind::PRINT);
+		stat->exp = lower(ctx->printStat()->printArguments()->exp());
+	}
+
+	else if (ctx->ifStat() != nullptr) stat = lower(ctx->ifStat());
+
+	return stat;
+}
+
+StatNode *AstLowering::lower(LuaParser::IfStatContext *ctx)
+{
+	StatNode *stat = newNode(StatKind::IF);
+	ClauseNode **next = &stat->clauses;
+	size_t expressionCount = ctx->exp().size();
+
+	// The else block, if any, is the one after the last test.
+	for (size_t i = 0; i < ctx->block().size(); i++)
+	{
+		nodeCount++;
+		ClauseNode *clause = arena.create<ClauseNode>();
+		if (i < expressionCount) clause->test = lower(ctx->exp(i));
+		clause->block = lower(ctx->block(i));
+
+		*next = clause;
+		next = &clause->next;
+	}
+
+	return stat;
+}
+
+StatNode *AstLowering::lower(LuaParser::RetstatContext *ctx)
+{
+	StatNode *stat = newNode(StatKind::RETURN);
+	if (ctx->exp() != nullptr) stat->exp = lower(ctx->exp());
+	stat->entry = ctx->entry;
+
+	return stat;
+}
+
+ExpNode *AstLowering::lower(LuaParser::FunctioncallContext *ctx)
+{
+	ExpNode *node = newNode(ExpKind::CALL);
+	node->entry = ctx->entry;
+	node->type = ctx->entry != nullptr ? ctx->entry->getType() : nullptr;
+	node->left = lower(ctx->nameAndArgs(0)->args());
+
+	return node;
+}
+
+ExpNode *AstLowering::lower(const vector<LuaParser::ExpContext *>& exps)
+{
+	ExpNode *first = nullptr;
+	ExpNode **next = &first;
+
+	for (LuaParser::ExpContext *exprCtx : exps)
+	{
+		*next = lower(exprCtx);
+		next = &(*next)->next;
+	}
+
+	return first;
+}
+
+ExpNode *AstLowering::lower(LuaParser::ArgsContext *ctx)
+{
+	if (ctx->explist() != nullptr) return lower(ctx->explist()->exp());
+
+	// f "string"
+	if (ctx->string() != nullptr)
+	{
+		ExpNode *node = newNode(ExpKind::STRING);
+		node->text = strings.intern(ctx->string()->getText());
+		node->type = Predefined::stringType;
+		return node;
+	}
+
+	return nullptr;
+}
+
+ExpNode *AstLowering::lower(LuaParser::ExpContext *ctx)
+{
+	ExpNode *node;
+
+	// Folded to a constant.
+	if (ctx->folded)
+	{
+		node = newNode(ExpKind::NUMBER);
+		node->value = ctx->value;
+	}
+
+	// Simplified to one of its operands.
+	else if (ctx->reduced != nullptr) node = lower(ctx->reduced);
+
+	// x*2 or 2*x
+	else if (ctx->doubled != nullptr)
+	{
+		node = newNode(ExpKind::DOUBLE);
+		node->left = lower(ctx->doubled);
+	}
+
+	else if (ctx->number() != nullptr)
+	{
+		node = newNode(ExpKind::NUMBER);
+		node->value = stoi(ctx->number()->getText());
+	}
+
+	else if (ctx->string() != nullptr)
+	{
+		node = newNode(ExpKind::STRING);
+		node->text = strings.intern(ctx->string()->getText());
+	}
+
+	else if (ctx->functioncall() != nullptr) node = lower(ctx->functioncall());
+
+	// A variable or a parenthesized expression.
+	else if (   (ctx->prefixexp() != nullptr)
+	         && ctx->prefixexp()->nameAndArgs().empty())
+	{
+		LuaParser::VarOrExpContext *varOrExp = ctx->prefixexp()->varOrExp();
+
+		if (varOrExp->var_() != nullptr)
+		{
+			node = newNode(ExpKind::VARIABLE);
+			node->entry = varOrExp->var_()->entry;
+		}
+		else node = lower(varOrExp->exp());
+	}
+
+	else if (ctx->exp().size() == 2)
+	{
+		node = newNode(ExpKind::BINARY);
+		node->op = binaryOperator(ctx);
+		node->left  = lower(ctx->exp(0));
+		node->right = lower(ctx->exp(1));
+	}
+
+	// A prefix expression with arguments: its value, and then
+	// the arguments of each call.
+	else if (ctx->prefixexp() != nullptr)
+	{
+		node = newNode(ExpKind::OTHER);
+		LuaParser::VarOrExpContext *varOrExp = ctx->prefixexp()->varOrExp();
+		ExpNode **next = &node->left;
+
+		if (varOrExp->var_() != nullptr)
+		{
+			SymtabEntry *variableId = varOrExp->var_()->entry;
+			*next = newNode(ExpKind::VARIABLE);
+			(*next)->entry = variableId;
+			(*next)->type = variableId != nullptr ? variableId->getType()
+			                                      : nullptr;
+		}
+		else *next = lower(varOrExp->exp());
+		next = &(*next)->next;
+
+		for (LuaParser::NameAndArgsContext *argsCtx
+		        : ctx->prefixexp()->nameAndArgs())
+		{
+			*next = lower(argsCtx->args());
+			while (*next != nullptr) next = &(*next)->next;
+		}
+	}
+
+	else if (ctx->getText() == "nil") node = newNode(ExpKind::NIL);
+
+	// false or true
+	else
+	{
+		node = newNode(ExpKind::BOOLEAN);
+		node->value = ctx->getText() == "true" ? 1 : 0;
+	}
+
+	node->type = ctx->type;
+	ctx->node = node;
+	return node;
+}
+
+ExpNode *AstLowering::newNode(ExpKind kind)
+{
+	nodeCount++;
+	return arena.create<ExpNode>(kind);
+}
+
+StatNode *AstLowering::newNode(StatKind kind)
+{
+	nodeCount++;
+	return arena.create<StatNode>(kind);
+}
+
+ExpOperator AstLowering::binaryOperator(LuaParser::ExpContext *ctx)
+{
+	string op = ctx->operatorMulDiv()     != nullptr ? ctx->operatorMulDiv()->getText()
+	          : ctx->operatorAddSub()     != nullptr ? ctx->operatorAddSub()->getText()
+	          :                                        ctx->operatorComparison()->getText();
+
+	return op == "+"  ? ExpOperator::ADD
+	     : op == "-"  ? ExpOperator::SUB
+	     : op == "*"  ? ExpOperator::MUL
+	     : op == "/"  ? ExpOperator::DIV
+	     : op == "==" ? ExpOperator::EQ
+	     : op == "~=" ? ExpOperator::NE
+	     : op == "<"  ? ExpOperator::LT
+	     : op == "<=" ? ExpOperator::LE
+	     : op == ">"  ? ExpOperator::GT
+	     :              ExpOperator::GE;
+}
+
+} // namespace frontend
@@ -0,0 +1,142 @@
+#ifndef ASTLOWERING_H_
+#define ASTLOWERING_H_
+
+#include "LuaBaseVisitor.h"
+#include "antlr4-runtime.h"
+
+#include "intermediate/ast/Arena.h"
+#include "intermediate/ast/ExpNode.h"
+#include "intermediate/ast/StatNode.h"
+#include "intermediate/util/Interner.h"
+
+namespace frontend {
+
+using namespace std;
+using namespace intermediate::ast;
+using namespace intermediate::util;
+
+/**
+ * Lower the parse tree of a program into compact nodes allocated in
+ * an arena: its functions, its statements and its expressions. The
+ * nodes already reflect constant folding, the resolved symbol table
+ * entries and the inferred type of each value, so code generation
+ * reads only them, and the parse tree can be freed before it starts.
+ * The nodes live as long as this object.
+ */
+class AstLowering : public LuaBaseVisitor
+{
+private:
+    Arena arena;           // owns every node
+    Interner strings;      // interned string literals
+    ProgramNode *program;  // the lowered program, or null
+    int nodeCount;         // count of lowered nodes
+
+public:
+    /**
+     * Constructor.
+     */
+    AstLowering() : program(nullptr), nodeCount(0) {}
+
+    /**
+     * Get the lowered program.
+     * @return the program node, or null if no chunk was visited.
+     */
+    ProgramNode *getProgram() const { return program; }
+
+    /**
+     * Get the count of lowered nodes.
+     * @return the count.
+     */
+    int getNodeCount() const { return nodeCount; }
+
+    /**
+     * Get the bytes the nodes occupy.
+     * @return the count.
+     */
+    size_t getBytesUsed() const { return arena.getBytesUsed(); }
+
+	Object visitChunk(LuaParser::ChunkContext *ctx) override;
+
+private:
+    /**
+     * Lower the statements of a block. Function definitions are
+     * not statements that execute, so they are left out.
+     * @param ctx the BlockContext.
+     * @return the first statement node, or null if there is none.
+     */
+    StatNode *lower(LuaParser::BlockContext *ctx);
+
+    /**
+     * Lower a statement.
+     * @param ctx the StatContext.
+     * @return the statement node, or null if nothing executes.
+     */
+    StatNode *lower(LuaParser::StatContext *ctx);
+
+    /**
+     * Lower an if statement.
+     * @param ctx the IfStatContext.
+     * @return the statement node.
+     */
+    StatNode *lower(LuaParser::IfStatContext *ctx);
+
+    /**
+     * Lower a return statement.
+     * @param ctx the RetstatContext.
+     * @return the statement node.
+     */
+    StatNode *lower(LuaParser::RetstatContext *ctx);
+
+    /**
+     * Lower a function call.
+     * @param ctx the FunctioncallContext.
+     * @return the call node.
+     */
+    ExpNode *lower(LuaParser::FunctioncallContext *ctx);
+
+    /**
+     * Lower an expression and set its node.
+     * @param ctx the ExpContext.
+     * @return the lowered node.
+     */
+    ExpNode *lower(LuaParser::ExpContext *ctx);
+
+    /**
+     * Lower a list of expressions.
+     * @param exps the ExpContexts.
+     * @return the first node, linked to the others, or null.
+     */
+    ExpNode *lower(const vector<LuaParser::ExpContext *>& exps);
+
+    /**
+     * Lower the arguments of a call.
+     * @param ctx the ArgsContext.
+     * @return the first node, linked to the others, or null.
+     */
+    ExpNode *lower(LuaParser::ArgsContext *ctx);
+
+    /**
+     * Allocate an expression node in the arena.
+     * @param kind the node kind.
+     * @return the node.
+     */
+    ExpNode *newNode(ExpKind kind);
+
+    /**
+     * Allocate a statement node in the arena.
+     * @param kind the node kind.
+     * @return the node.
+     */
+    StatNode *newNode(StatKind kind);
+
+    /**
+     * Get the operator of a binary expression.
+     * @param ctx the ExpContext.
+     * @return the operator.
+     */
+    static ExpOperator binaryOperator(LuaParser::ExpContext *ctx);
+};
+
+} // namespace frontend
+
+#endif /* ASTLOWERING_H_ */
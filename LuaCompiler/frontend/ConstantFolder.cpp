@@ -0,0 +1,111 @@
+#include <cstdint>
+
+#include "antlr4-runtime.h"
+
+#include "LuaBaseVisitor.h"
+#include "ConstantFolder.h"
+
+namespace frontend {
+
+using namespace std;
+
+Object ConstantFolder::visitExp(LuaParser::ExpContext *ctx)
+{
+    // Fold the operands first.
+	visitChildren(ctx);
+
+	if (ctx->number() != nullptr)
+	{
+		// Semantics has rejected any literal that does not fit an int.
+		ctx->folded = true;
+		ctx->value = stoi(ctx->number()->getText());
+	}
+
+	// A parenthesized expression: ( exp )
+	else if (   (ctx->prefixexp() != nullptr)
+	         && ctx->prefixexp()->nameAndArgs().empty()
+	         && (ctx->prefixexp()->varOrExp()->exp() != nullptr))
+	{
+		LuaParser::ExpContext *inner = ctx->prefixexp()->varOrExp()->exp();
+
+		if (inner->folded)
+		{
+			ctx->folded = true;
+			ctx->value = inner->value;
+		}
+	}
+
+	else if (ctx->exp().size() == 2) foldBinary(ctx);
+
+	return nullptr;
+}
+
+void ConstantFolder::foldBinary(LuaParser::ExpContext *ctx)
+{
+	LuaParser::ExpContext *left  = ctx->exp(0);
+	LuaParser::ExpContext *right = ctx->exp(1);
+
+	string op = ctx->operatorMulDiv()     != nullptr ? ctx->operatorMulDiv()->getText()
+	          : ctx->operatorAddSub()     != nullptr ? ctx->operatorAddSub()->getText()
+	          :                                        ctx->operatorComparison()->getText();
+
+	// Both operands are constant.
+	if (left->folded && right->folded)
+	{
+		int result;
+		if (evaluate(op, left->value, right->value, result))
+		{
+			ctx->folded = true;
+			ctx->value = result;
+			foldCount++;
+		}
+		return;
+	}
+
+	// Identities. Each keeps the evaluation of the other operand,
+	// so any function call in it still happens exactly once.
+	if      ((op == "+") && isConstant(right, 0)) ctx->reduced = left;
+	else if ((op == "+") && isConstant(left,  0)) ctx->reduced = right;
+	else if ((op == "-") && isConstant(right, 0)) ctx->reduced = left;
+	else if ((op == "*") && isConstant(right, 1)) ctx->reduced = left;
+	else if ((op == "*") && isConstant(left,  1)) ctx->reduced = right;
+	else if ((op == "/") && isConstant(right, 1)) ctx->reduced = left;
+	else if ((op == "*") && isConstant(right, 2)) ctx->doubled = left;
+	else if ((op == "*") && isConstant(left,  2)) ctx->doubled = right;
+	else return;
+
+	simplifyCount++;
+}
+
+bool ConstantFolder::evaluate(const string& op, int left, int right,
+                              int& result)
+{
+	// Wrap around on overflow as the JVM does.
+	int64_t a = left, b = right;
+
+	if      (op == "+")  result = static_cast<int32_t>(static_cast<uint32_t>(a + b));
+	else if (op == "-")  result = static_cast<int32_t>(static_cast<uint32_t>(a - b));
+	else if (op == "*")  result = static_cast<int32_t>(static_cast<uint32_t>(a * b));
+	else if (op == "/")
+	{
+		// Division by zero must still fail at run time.
+		if (b == 0) return false;
+		result = static_cast<int32_t>(static_cast<uint32_t>(a / b));
+	}
+	else if (op == "==") result = a == b;
+	else if (op == "~=") result = a != b;
+	else if (op == "<")  result = a <  b;
+	else if (op == "<=") result = a <= b;
+	else if (op == ">")  result = a >  b;
+	else if (op == ">=") result = a >= b;
+	else return false;
+
+	return true;
+}
+
+bool ConstantFolder::isConstant(LuaParser::ExpContext *ctx, int value)
+{
+	return ctx->folded && (ctx->value == value);
+}
+
+} // namespace frontend
@@ -0,0 +1,74 @@
+#ifndef CONSTANTFOLDER_H_
+#define CONSTANTFOLDER_H_
+
+#include "LuaBaseVisitor.h"
+#include "antlr4-runtime.h"
+
+namespace frontend {
+
+using namespace std;
+
+/**
+ * Fold constant subexpressions and simplify algebraic identities
+ * in the parse tree. The results are recorded on each ExpContext:
+ * folded and value for a constant, reduced for an expression that
+ * equals one of its operands, and doubled for x*2 and 2*x. The
+ * identities hold only for numbers, so type inference drops those
+ * whose operand may be anything else.
+ */
+class ConstantFolder : public LuaBaseVisitor
+{
+private:
+    int foldCount;      // count of folded expressions
+    int simplifyCount;  // count of simplified expressions
+
+public:
+    /**
+     * Constructor.
+     */
+    ConstantFolder() : foldCount(0), simplifyCount(0) {}
+
+    /**
+     * Get the count of expressions folded into constants.
+     * @return the count.
+     */
+    int getFoldCount() const { return foldCount; }
+
+    /**
+     * Get the count of expressions simplified by an identity, including
+     * any that type inference later drops.
+     * @return the count.
+     */
+    int getSimplifyCount() const { return simplifyCount; }
+
+	Object visitExp(LuaParser::ExpContext *ctx) override;
+
+private:
+    /**
+     * Fold or simplify a binary operator expression.
+     * @param ctx the ExpContext.
+     */
+    void foldBinary(LuaParser::ExpContext *ctx);
+
+    /**
+     * Evaluate a binary operator with Java int semantics.
+     * @param op the operator.
+     * @param left the left operand value.
+     * @param right the right operand value.
+     * @param result set to the result.
+     * @return false if the operation must be left to run time, else true.
+     */
+    static bool evaluate(const string& op, int left, int right, int& result);
+
+    /**
+     * Check whether an expression is a given constant.
+     * @param ctx the ExpContext.
+     * @param value the constant value.
+     * @return true if it is, else false.
+     */
+    static bool isConstant(LuaParser::ExpContext *ctx, int value);
+};
+
+} // namespace frontend
+
+#endif /* CONSTANTFOLDER_H_ */
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <map>
+#include <cstdio>
 
 #include "antlr4-runtime.h"
 
@@ -66,8 +67,19 @@ class SemanticErrorHandler
 private:
     int  count;
     bool first;
+    string diagnostics;  // copy of the printed report
     map<Error, string> SEMANTIC_ERROR_MESSAGES;
 
+    /**
+     * Print a line of the report and keep a copy of it.
+     * @param line the text of the line.
+     */
+    void report(const string& line)
+    {
+        fputs(line.c_str(), stdout);
+        diagnostics += line;
+    }
+
 public:
     SemanticErrorHandler() : count(0), first(true)
     {
@@ -117,23 +129,33 @@ public:
 
     int getCount() const { return count; }
 
+    /**
+     * Get the text of the error report, as it was printed.
+     * @return the text.
+     */
+    const string& getDiagnostics() const { return diagnostics; }
+
     void flag(Error error, int lineNumber, string text)
     {
         if (first)
         {
-            cout << endl;
-            cout << "===== SEMANTIC ERRORS =====" << endl << endl;
-            printf("%-4s %-40s %s\n", "Line", "Message", "Found near");
-            printf("%-4s %-40s %s\n", "----", "-------", "----------");
+            char header[160];
+            snprintf(header, sizeof(header), "%-4s %-40s %s\n%-4s %-40s %s\n",
+                     "Line", "Message", "Found near",
+                     "----", "-------", "----------");
+            report("\n===== SEMANTIC ERRORS =====\n\n");
+            report(header);
 
             first = false;
         }
 
         count++;
 
-        printf("%03d  %-40s \"%s\"\n", lineNumber,
-                                       SEMANTIC_ERROR_MESSAGES[error].c_str(),
-                                       text.c_str());
+        char number[32];
+        snprintf(number, sizeof(number), "%03d  ", lineNumber);
+        string message = SEMANTIC_ERROR_MESSAGES[error];
+        if (message.size() < 40) message.append(40 - message.size(), ' ');
+        report(number + message + " \"" + text + "\"\n");
     }
 
     void flag(Error error, antlr4::ParserRuleContext *ctx)
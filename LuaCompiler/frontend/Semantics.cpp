@@ -11,13 +11,10 @@
 #include "intermediate/type/Typespec.h"
 #include "intermediate/type/TypeChecker.h"
 #include "intermediate/util/CrossReferencer.h"
+#include "intermediate/util/Tracer.h"
 #include "SemanticErrorHandler.h"
 #include "Semantics.h"
 
-namespace intermediate { namespace symtab {
-    int Symtab::unnamedIndex = 0;
-}}
-
 namespace frontend {
 
 using namespace std;
@@ -25,7 +22,8 @@ using namespace intermediate::symtab;
 using namespace intermediate::type;
 using namespace intermediate::util;
 
-Semantics::Semantics(string x)
+Semantics::Semantics(string x, bool crossReference)
+    : crossReference(crossReference)
 {
     // Create and initialize the symbol table stack.
 	programName = x;
@@ -47,8 +45,26 @@ Object Semantics::visitChunk(LuaParser::ChunkContext *ctx){
 	symtabStack->getLocalSymtab()->setOwner(programId);
 	visit(ctx->block());
 
-	CrossReferencer crossReferencer;
-	crossReferencer.print(symtabStack);
+	// Every function of the chunk is defined now.
+	for (LuaParser::FunctioncallContext *callCtx : forwardCalls)
+	{
+		LuaParser::Var_Context *varCtx = callCtx->varOrExp()->var_();
+		string name = varCtx->NAME()->getText();
+
+		callCtx->entry = varCtx->entry = resolveFunction(name);
+		if (callCtx->entry == nullptr)
+		{
+			error.flag(UNDECLARED_IDENTIFIER,
+			           callCtx->getStart()->getLine(), name);
+		}
+	}
+	forwardCalls.clear();
+
+	if (crossReference)
+	{
+		CrossReferencer crossReferencer;
+		crossReferencer.print(symtabStack);
+	}
 	return nullptr;
 }
 
@@ -63,7 +79,9 @@ Object Semantics::visitStat(LuaParser::StatContext *ctx){
 }
 
 Object Semantics::visitRetstat(LuaParser::RetstatContext *ctx){
-	return visit(ctx->exp());
+	ctx->entry = symtabStack->getLocalSymtab()->getOwner();
+	if (ctx->exp() != nullptr) visit(ctx->exp());
+	return nullptr;
 }
 Object Semantics::visitAssignStat(LuaParser::AssignStatContext *ctx){
 	visitVar_(ctx->var_());
@@ -107,19 +125,34 @@ Object Semantics::visitPrefixexp(LuaParser::PrefixexpContext *ctx){
 	return nullptr;
 }
 Object Semantics::visitFunctioncall(LuaParser::FunctioncallContext *ctx){
-	string funcName = ctx->varOrExp()->var_()->getText();
-	SymtabEntry *func = symtabStack->lookup(funcName);
-	Symtab *tmp = func->getRoutineSymtab();
+	LuaParser::Var_Context *varCtx = ctx->varOrExp()->var_();
+
+	// Resolve the function once, here, so that code generation needs
+	// no lookup. The name is not visited as a variable, which would
+	// enter it into the local scope.
+	if (varCtx != nullptr){
+		ctx->entry = varCtx->entry = resolveFunction(varCtx->NAME()->getText());
+		if (ctx->entry == nullptr) forwardCalls.push_back(ctx);
+	}
+	else visit(ctx->varOrExp());
 
-	SymtabEntry *ptr = nullptr;
-	vector<SymtabEntry *> entries = tmp->sortedEntries();
+	for (LuaParser::NameAndArgsContext *argsCtx : ctx->nameAndArgs()){
+		visit(argsCtx);
+	}
+	return nullptr;
+}
 
-	for (long unsigned int i=0; i<entries.size(); i++){
-		if (entries[i]->getName() == "testData")
-			ptr = entries[i];
+SymtabEntry *Semantics::resolveFunction(const string& name){
+	SymtabEntry *id = symtabStack->lookup(name);
+	if ((id == nullptr) || (id->getKind() == FUNCTION)) return id;
+
+	// Inside a function, its name is the implied function variable,
+	// and a call by that name is a recursive call.
+	SymtabEntry *ownerId = id->getSymtab()->getOwner();
+	if (   (ownerId != nullptr) && (ownerId->getKind() == FUNCTION)
+	    && (ownerId->getName() == name)){
+		return ownerId;
 	}
-	func->setRoutineParameters(ptr->getRoutineParameters());
-	visitChildren(ctx);
 	return nullptr;
 }
 Object Semantics::visitVarOrExp(LuaParser::VarOrExpContext *ctx){
@@ -137,9 +170,9 @@ Object Semantics::visitVar_(LuaParser::Var_Context *ctx){
 	SymtabEntry *varId = symtabStack->lookupLocal(name);
 
 	int lineNum = ctx->getStart()->getLine();
+	// The type is inferred after this pass.
 	if (varId == nullptr){
 		varId = symtabStack->enterLocal(name, VARIABLE);
-		varId->setType(Predefined::numberType);
 	}
 	ctx->entry = varId;
 
@@ -160,6 +193,8 @@ Object Semantics::visitArgs(LuaParser::ArgsContext *ctx){
 }
 Object Semantics::visitFunctiondef(LuaParser::FunctiondefContext *ctx){
 	string functionName = ctx->funcname()->getText();
+	TraceSpan span("semantics", "Semantics::visitFunctiondef", functionName);
+	span.arg("line", (long) ctx->getStart()->getLine());
 	SymtabEntry *functionId = symtabStack->lookupLocal(functionName);
 	LuaParser::ParlistContext *parameterList = ctx->funcbody()->parlist();
 
@@ -169,6 +204,7 @@ Object Semantics::visitFunctiondef(LuaParser::FunctiondefContext *ctx){
 	} else {
 		functionId = symtabStack->enterLocal(functionName, FUNCTION);
 		functionId->setRoutineCode(DECLARED);
+		ctx->entry = functionId;
 
 		SymtabEntry *parent = symtabStack->getLocalSymtab()->getOwner();
 
@@ -179,7 +215,6 @@ Object Semantics::visitFunctiondef(LuaParser::FunctiondefContext *ctx){
 		functionId->setRoutineSymtab(symtabStack->push());
 		Symtab *localSymtab = symtabStack->getLocalSymtab();
 		localSymtab->setOwner(functionId);
-		vector<SymtabEntry *> parameterIds;
 
 		if (parameterList != nullptr){
 
@@ -187,18 +222,15 @@ Object Semantics::visitFunctiondef(LuaParser::FunctiondefContext *ctx){
 
 				string name = parameterList->varlist()->var_(i)->getText();
 				SymtabEntry *newEntry = symtabStack->enterLocal(name, VALUE_PARAMETER);
-				newEntry->setType(Predefined::numberType);
 				parameterList->varlist()->var_(i)->entry = newEntry;
-				parameterIds.push_back(newEntry);
+				functionId->appendParameter(newEntry);
 				newEntry->setSlotNumber(localSymtab->nextSlotNumber());
 
 			}
-			functionId->setRoutineParameters(&parameterIds);
 		}
 
 		SymtabEntry *assocVarId = symtabStack->enterLocal(functionName, VARIABLE);
 		assocVarId->setSlotNumber(localSymtab->nextSlotNumber());
-		assocVarId->setType(Predefined::numberType);
 
 		visitChildren(ctx->funcbody()->block());
 		functionId->setExecutable(ctx->funcbody()->block());
@@ -231,6 +263,18 @@ Object Semantics::visitOperatorMulDiv(LuaParser::OperatorMulDivContext *ctx){
 	return nullptr;
 }
 Object Semantics::visitNumber(LuaParser::NumberContext *ctx){
+	// Numbers are ints, so a literal that does not fit is an error,
+	// and the passes after this one can convert every literal safely.
+	string text = ctx->getText();
+	size_t digits = text.find_first_not_of('0');
+	if (digits == string::npos) digits = text.length();
+
+	if (   (text.length() - digits > 10)
+	    || (   (text.length() - digits == 10)
+	        && (text.compare(digits, 10, "2147483647") > 0)))
+	{
+		error.flag(INVALID_CONSTANT, ctx);
+	}
 	return nullptr;
 }
 Object Semantics::visitString(LuaParser::StringContext *ctx){
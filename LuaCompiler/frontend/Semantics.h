@@ -25,6 +25,18 @@ private:
     SymtabEntry *programId;
     SemanticErrorHandler error;
     map<string, Typespec *> *typeTable;
+    bool crossReference;  // true to print the cross-reference listing
+
+    // Calls of functions that were not defined yet where they were
+    // visited. They are resolved at the end of the chunk.
+    vector<LuaParser::FunctioncallContext *> forwardCalls;
+
+    /**
+     * Resolve the function that a call names, from the current scope.
+     * @param name the function name.
+     * @return the function's entry, or null if there is none yet.
+     */
+    SymtabEntry *resolveFunction(const string& name);
 
     /**
      * Return the number of values in a datatype.
@@ -50,7 +62,22 @@ private:
 
 public:
     string programName;
-    Semantics(string);
+
+    /**
+     * Constructor.
+     * @param programName the program name.
+     * @param crossReference true to print the cross-reference listing.
+     */
+    Semantics(string programName, bool crossReference = true);
+
+    /**
+     * Destructor. Release the symbol tables of the compilation.
+     */
+    virtual ~Semantics()
+    {
+        delete symtabStack;
+        delete typeTable;
+    }
 
     /**
     * Get the symbol table entry of the program identifier.
@@ -58,12 +85,24 @@ public:
     */
     SymtabEntry *getProgramId() { return programId; }
 
+    /**
+     * Get the symbol table stack.
+     * @return the stack.
+     */
+    SymtabStack *getSymtabStack() { return symtabStack; }
+
     /**
      * Get the count of semantic errors.
      * @return the count.
      */
     int getErrorCount() const { return error.getCount(); }
 
+    /**
+     * Get the text of the semantic error report.
+     * @return the text.
+     */
+    const string& getDiagnostics() const { return error.getDiagnostics(); }
+
     /**
      * Return the default value for a given datatype.
      * @param type the datatype.
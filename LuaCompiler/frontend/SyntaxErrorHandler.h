@@ -1,6 +1,9 @@
 #ifndef BACKEND_SYNTAXERRORHANDLER_H_
 #define BACKEND_SYNTAXERRORHANDLER_H_
 
+#include <cstdio>
+#include <string>
+
 #include "BaseErrorListener.h"
 
 namespace frontend {
@@ -13,27 +16,52 @@ class SyntaxErrorHandler : public BaseErrorListener
 private:
     int  count;
     bool first;
+    string diagnostics;  // copy of the printed report
+
+    /**
+     * Print a line of the report and keep a copy of it.
+     * @param line the text of the line.
+     */
+    void report(const string& line)
+    {
+        fputs(line.c_str(), stdout);
+        diagnostics += line;
+    }
 
 public:
     SyntaxErrorHandler() : count(0), first(true) {}
 
     int getCount() const { return count; }
 
+    /**
+     * Get the text of the error report, as it was printed.
+     * @return the text.
+     */
+    const string& getDiagnostics() const { return diagnostics; }
+
     void syntaxError(Recognizer *recognizer, Token *offendingSymbol,
                      size_t line, size_t charPositionInLine,
                      const std::string &msg, std::exception_ptr e) override
     {
         if (first)
         {
-            cout << "\n\n===== SYNTAX ERRORS =====" << endl << endl;
-            printf("%-4s %-35s\n", "Line", "Message");
-            printf("%-4s %-35s\n", "----", "-------");
+            char header[128];
+            snprintf(header, sizeof(header), "%-4s %-35s\n%-4s %-35s\n",
+                     "Line", "Message", "----", "-------");
+            report("\n\n===== SYNTAX ERRORS =====\n\n");
+            report(header);
 
             first = false;
         }
 
+        // Report each error as it is found, in source order.
         count++;
-        printf("%03zu  %-35s\n", line, msg.c_str());
+        char number[32];
+        snprintf(number, sizeof(number), "%03zu  ", line);
+        string text = msg;
+        if (text.size() < 35) text.append(35 - text.size(), ' ');
+        report(number + text + "\n");
+        fflush(stdout);
     }
 };
 
@@ -0,0 +1,423 @@
+#include <vector>
+
+#include "antlr4-runtime.h"
+
+#include "LuaBaseVisitor.h"
+#include "intermediate/symtab/Symtab.h"
+#include "intermediate/symtab/Predefined.h"
+#include "TypeInference.h"
+
+namespace frontend {
+
+using namespace std;
+
+Typespec *TypeInference::join(Typespec *type1, Typespec *type2)
+{
+	if (type1 == nullptr) return type2;
+	if ((type2 == nullptr) || (type1 == type2)) return type1;
+
+	return Predefined::dynamicType;
+}
+
+Object TypeInference::visitChunk(LuaParser::ChunkContext *ctx)
+{
+	// Calls can widen the parameters of functions that were already
+	// inferred, and a recursive call uses the function's result before
+	// it is known, so infer again until nothing changes. Types only
+	// widen, so this stops after a few rounds.
+	do
+	{
+		changed = false;
+		types.clear();
+		reachable = true;
+		exitTypes.clear();
+		exitReached = false;
+		roundCount++;
+
+		visit(ctx->block());
+	} while (changed);
+
+	settle(programId);
+	return nullptr;
+}
+
+Object TypeInference::visitAssignStat(LuaParser::AssignStatContext *ctx)
+{
+	Typespec *type = infer(ctx->exp());
+	assign(ctx->var_()->entry, type);
+	return nullptr;
+}
+
+Object TypeInference::visitRepeatStat(LuaParser::RepeatStatContext *ctx)
+{
+	// The loop body starts with the types from before the loop
+	// joined with those from the end of the body, until they settle.
+	// A body that returns does not loop.
+	TypeMap top = types;
+	bool entry = reachable;
+
+	for (;;)
+	{
+		types = top;
+		reachable = entry;
+		visit(ctx->block());
+		infer(ctx->exp());
+		if (!reachable) break;
+
+		TypeMap next = merge(top, types);
+		if (next == top) break;
+		top = move(next);
+	}
+
+	return nullptr;
+}
+
+Object TypeInference::visitIfStat(LuaParser::IfStatContext *ctx)
+{
+	int expressionCount = ctx->exp().size();
+	bool hasElse = ctx->block().size() == (size_t) expressionCount + 1;
+
+	// The tests assign nothing, so every block starts with the
+	// types from before the statement.
+	for (LuaParser::ExpContext *exprCtx : ctx->exp()) infer(exprCtx);
+
+	// Without an else, no block may execute. A block that
+	// returns does not join the others after the statement.
+	TypeMap before = move(types);
+	TypeMap after;
+	bool entry = reachable;
+	bool first = hasElse;
+	if (!hasElse) after = before;
+
+	for (LuaParser::BlockContext *blockCtx : ctx->block())
+	{
+		types = before;
+		reachable = entry;
+		visit(blockCtx);
+		if (!reachable) continue;
+
+		if (first) after = move(types);
+		else       after = merge(after, types);
+		first = false;
+	}
+
+	types = move(after);
+	reachable = entry && !first;
+	return nullptr;
+}
+
+Object TypeInference::visitPrintArguments(LuaParser::PrintArgumentsContext *ctx)
+{
+	for (LuaParser::ExpContext *exprCtx : ctx->exp()) infer(exprCtx);
+	return nullptr;
+}
+
+Object TypeInference::visitRetstat(LuaParser::RetstatContext *ctx)
+{
+	Typespec *type = ctx->exp() != nullptr ? infer(ctx->exp())
+	                                       : Predefined::nilType;
+	SymtabEntry *routineId = ctx->entry;
+
+	// A function's result is its implied variable.
+	if ((routineId != nullptr) && (routineId->getKind() == FUNCTION))
+	{
+		assign(resultVariable(routineId), type);
+	}
+
+	// The return branches to the routine's exit,
+	// so the code after it is unreachable.
+	exitTypes = exitReached ? merge(exitTypes, types) : types;
+	exitReached = true;
+	reachable = false;
+	return nullptr;
+}
+
+Object TypeInference::visitFunctioncall(LuaParser::FunctioncallContext *ctx)
+{
+	inferCall(ctx);
+	return nullptr;
+}
+
+Object TypeInference::visitFunctiondef(LuaParser::FunctiondefContext *ctx)
+{
+	SymtabEntry *functionId = ctx->entry;
+	if (functionId == nullptr) return nullptr;
+
+	// The function has its own variables. Its parameters
+	// start with the types of the arguments of every call.
+	TypeMap outer = move(types);
+	TypeMap outerExit = move(exitTypes);
+	bool outerReachable = reachable;
+	bool outerExitReached = exitReached;
+	types.clear();
+	exitTypes.clear();
+	reachable = true;
+	exitReached = false;
+
+	SymtabEntries *parmIds = functionId->getRoutineParameters();
+	if (parmIds != nullptr)
+	{
+		for (SymtabEntry *parmId : *parmIds) types[parmId] = parmId->getType();
+	}
+
+	visit(ctx->funcbody()->block());
+
+	// The function returns its implied variable's value at its exit,
+	// which its returns and the end of its body reach.
+	if (!reachable)       types = move(exitTypes);
+	else if (exitReached) types = merge(exitTypes, types);
+
+	SymtabEntry *resultId = resultVariable(functionId);
+	read(resultId);
+	widen(functionId, resultId->getType());
+
+	types = move(outer);
+	exitTypes = move(outerExit);
+	reachable = outerReachable;
+	exitReached = outerExitReached;
+	return nullptr;
+}
+
+Object TypeInference::visitExp(LuaParser::ExpContext *ctx)
+{
+	infer(ctx);
+	return nullptr;
+}
+
+Typespec *TypeInference::infer(LuaParser::ExpContext *ctx)
+{
+	Typespec *type;
+
+	// The identities hold only for a number: "10" + 0 is 10, and nil * 1
+	// is an error. Unless the operand is always a number, keep the
+	// arithmetic, which converts it. Types only widen, so an operand
+	// that is not a number in one round never is in a later one.
+	LuaParser::ExpContext *operand = ctx->reduced != nullptr ? ctx->reduced
+	                                                         : ctx->doubled;
+	if (   (operand != nullptr)
+	    && (infer(operand) != Predefined::numberType))
+	{
+		ctx->reduced = ctx->doubled = nullptr;
+	}
+
+	// Simplified to one of its operands, which is what is evaluated.
+	if (ctx->reduced != nullptr) type = ctx->reduced->type;
+
+	// x*2 or 2*x
+	else if (ctx->doubled != nullptr) type = Predefined::numberType;
+
+	else if (ctx->number() != nullptr) type = Predefined::numberType;
+	else if (ctx->string() != nullptr) type = Predefined::stringType;
+	else if (ctx->functioncall() != nullptr) type = inferCall(ctx->functioncall());
+
+	// A variable or a parenthesized expression.
+	else if (   (ctx->prefixexp() != nullptr)
+	         && ctx->prefixexp()->nameAndArgs().empty())
+	{
+		LuaParser::VarOrExpContext *varOrExp = ctx->prefixexp()->varOrExp();
+
+		type = varOrExp->var_() != nullptr ? read(varOrExp->var_()->entry)
+		                                   : infer(varOrExp->exp());
+	}
+
+	else if (ctx->exp().size() == 2)
+	{
+		infer(ctx->exp(0));
+		infer(ctx->exp(1));
+		type = ctx->operatorComparison() != nullptr ? Predefined::boolType
+		                                            : Predefined::numberType;
+	}
+
+	else if (ctx->prefixexp() != nullptr)
+	{
+		visitChildren(ctx->prefixexp());
+		type = Predefined::dynamicType;
+	}
+
+	// nil, false or true
+	else type = ctx->getText() == "nil" ? Predefined::nilType
+	                                    : Predefined::boolType;
+
+	ctx->type = type;
+	return type;
+}
+
+Typespec *TypeInference::inferCall(LuaParser::FunctioncallContext *ctx)
+{
+	LuaParser::VarOrExpContext *varOrExp = ctx->varOrExp();
+	if (varOrExp->exp() != nullptr) infer(varOrExp->exp());
+
+	vector<Typespec *> argTypes;
+	LuaParser::ArgsContext *argsCtx = ctx->nameAndArgs(0)->args();
+
+	if (argsCtx->explist() != nullptr)
+	{
+		for (LuaParser::ExpContext *exprCtx : argsCtx->explist()->exp())
+		{
+			argTypes.push_back(infer(exprCtx));
+		}
+	}
+	else if (argsCtx->string() != nullptr)
+	{
+		argTypes.push_back(Predefined::stringType);
+	}
+
+	for (size_t i = 1; i < ctx->nameAndArgs().size(); i++)
+	{
+		visit(ctx->nameAndArgs(i));
+	}
+
+	SymtabEntry *functionId = ctx->entry;
+	if ((functionId == nullptr) || (functionId->getKind() != FUNCTION))
+	{
+		return Predefined::dynamicType;
+	}
+
+	// A missing argument is nil.
+	SymtabEntries *parmIds = functionId->getRoutineParameters();
+	if (parmIds != nullptr)
+	{
+		for (size_t i = 0; i < parmIds->size(); i++)
+		{
+			widen((*parmIds)[i], i < argTypes.size() ? argTypes[i]
+			                                         : Predefined::nilType);
+		}
+	}
+
+	// Null until the function is inferred.
+	return functionId->getType();
+}
+
+Typespec *TypeInference::read(SymtabEntry *variableId)
+{
+	if (   (variableId == nullptr)
+	    || (   (variableId->getKind() != VARIABLE)
+	        && (variableId->getKind() != VALUE_PARAMETER)))
+	{
+		return Predefined::dynamicType;
+	}
+
+	auto it = types.find(variableId);
+	Typespec *type = it != types.end() ? it->second : Predefined::nilType;
+
+	widen(variableId, type);
+	return type;
+}
+
+void TypeInference::assign(SymtabEntry *variableId, Typespec *type)
+{
+	if (   (variableId == nullptr)
+	    || (   (variableId->getKind() != VARIABLE)
+	        && (variableId->getKind() != VALUE_PARAMETER)))
+	{
+		return;
+	}
+
+	types[variableId] = type;
+	widen(variableId, type);
+}
+
+void TypeInference::widen(SymtabEntry *id, Typespec *type)
+{
+	Typespec *oldType = id->getType();
+	Typespec *newType = join(oldType, type);
+
+	if (newType != oldType)
+	{
+		id->setType(newType);
+		changed = true;
+	}
+}
+
+TypeInference::TypeMap TypeInference::merge(const TypeMap& types1,
+                                            const TypeMap& types2)
+{
+	TypeMap merged = types1;
+
+	for (auto& entry : types2)
+	{
+		auto it = merged.find(entry.first);
+
+		if (it != merged.end()) it->second = join(it->second, entry.second);
+		else merged[entry.first] = join(Predefined::nilType, entry.second);
+	}
+
+	// Not assigned on the second path.
+	for (auto& entry : merged)
+	{
+		if (types2.find(entry.first) == types2.end())
+		{
+			entry.second = join(entry.second, Predefined::nilType);
+		}
+	}
+
+	return merged;
+}
+
+SymtabEntry *TypeInference::resultVariable(SymtabEntry *functionId)
+{
+	return functionId->getRoutineSymtab()->lookup(functionId->getName());
+}
+
+void TypeInference::settle(SymtabEntry *routineId)
+{
+	for (SymtabEntry *id : routineId->getRoutineSymtab()->sortedEntries())
+	{
+		Kind kind = id->getKind();
+
+		if ((kind == VARIABLE) || (kind == VALUE_PARAMETER) || (kind == FUNCTION))
+		{
+			if (id->getType() == nullptr) id->setType(Predefined::nilType);
+		}
+
+		if ((kind == VARIABLE) || (kind == VALUE_PARAMETER))
+		{
+			Typespec *type = id->getType();
+
+			variableCount++;
+			if (   (type == Predefined::numberType)
+			    || (type == Predefined::boolType)
+			    || (type == Predefined::stringType)) specializedCount++;
+		}
+	}
+
+	if (routineId->getKind() == FUNCTION) numberSlots(routineId);
+
+	SymtabEntries *routineIds = routineId->getSubroutines();
+	if (routineIds != nullptr)
+	{
+		for (SymtabEntry *subroutineId : *routineIds) settle(subroutineId);
+	}
+}
+
+void TypeInference::numberSlots(SymtabEntry *routineId)
+{
+	Symtab *symtab = routineId->getRoutineSymtab();
+	symtab->resetSlotNumbers();
+
+	// The parameters come first, in order. A dynamic
+	// value is a tagged long, which takes two slots.
+	SymtabEntries *parmIds = routineId->getRoutineParameters();
+	if (parmIds != nullptr)
+	{
+		for (SymtabEntry *parmId : *parmIds)
+		{
+			parmId->setSlotNumber(symtab->nextSlotNumber(slotWidth(parmId)));
+		}
+	}
+
+	for (SymtabEntry *id : symtab->sortedEntries())
+	{
+		if (id->getKind() == VARIABLE)
+		{
+			id->setSlotNumber(symtab->nextSlotNumber(slotWidth(id)));
+		}
+	}
+}
+
+int TypeInference::slotWidth(SymtabEntry *id)
+{
+	return id->getType() == Predefined::dynamicType ? 2 : 1;
+}
+
+} // namespace frontend
@@ -0,0 +1,170 @@
+#ifndef TYPEINFERENCE_H_
+#define TYPEINFERENCE_H_
+
+#include <unordered_map>
+
+#include "LuaBaseVisitor.h"
+#include "antlr4-runtime.h"
+
+#include "intermediate/symtab/SymtabEntry.h"
+#include "intermediate/type/Typespec.h"
+
+namespace frontend {
+
+using namespace std;
+using namespace intermediate::symtab;
+using namespace intermediate::type;
+
+/**
+ * Infer the types of the variables, parameters, function results
+ * and expressions of the parse tree. A value is a number, a boolean,
+ * a string or nil. The inference is flow-sensitive: each ExpContext's
+ * type is the type of its value at that point of the program, which
+ * can be narrower than the type of a variable that it reads. Each
+ * variable's type is the join of every value that it holds, and a
+ * variable that holds values of more than one type is dynamic.
+ * Parameters get the types of the arguments of every call, so the
+ * whole program is inferred again until no type changes.
+ */
+class TypeInference : public LuaBaseVisitor
+{
+private:
+    // The type of each variable at a point of the program. A variable
+    // that is not in the map has not been assigned there, so it is nil.
+    typedef unordered_map<SymtabEntry *, Typespec *> TypeMap;
+
+    SymtabEntry *programId;  // symbol table entry of the program name
+    TypeMap types;           // the types at the current point
+    bool reachable;          // false after a return, until paths join
+    TypeMap exitTypes;       // the types at the routine's exit
+    bool exitReached;        // true if a return branched to the exit
+    bool changed;            // true if a type widened during a round
+    int roundCount;          // count of rounds over the program
+    int variableCount;       // count of variables and parameters
+    int specializedCount;    // count of those with a single type
+
+public:
+    /**
+     * Constructor.
+     * @param programId the symtab entry for the program name.
+     */
+    TypeInference(SymtabEntry *programId)
+        : programId(programId), reachable(true), exitReached(false),
+          changed(false), roundCount(0),
+          variableCount(0), specializedCount(0) {}
+
+    /**
+     * Get the count of rounds over the program until no type changed.
+     * @return the count.
+     */
+    int getRoundCount() const { return roundCount; }
+
+    /**
+     * Get the count of variables and parameters.
+     * @return the count.
+     */
+    int getVariableCount() const { return variableCount; }
+
+    /**
+     * Get the count of variables and parameters that are always
+     * a number, always a boolean, or always a string.
+     * @return the count.
+     */
+    int getSpecializedCount() const { return specializedCount; }
+
+    /**
+     * Join two types: the type of a value that can have either one.
+     * @param type1 the first type, or null if there is no value yet.
+     * @param type2 the second type, or null if there is no value yet.
+     * @return the joined type.
+     */
+    static Typespec *join(Typespec *type1, Typespec *type2);
+
+	Object visitChunk(LuaParser::ChunkContext *ctx) override;
+	Object visitAssignStat(LuaParser::AssignStatContext *ctx) override;
+	Object visitRepeatStat(LuaParser::RepeatStatContext *ctx) override;
+	Object visitIfStat(LuaParser::IfStatContext *ctx) override;
+	Object visitPrintArguments(LuaParser::PrintArgumentsContext *ctx) override;
+	Object visitRetstat(LuaParser::RetstatContext *ctx) override;
+	Object visitFunctioncall(LuaParser::FunctioncallContext *ctx) override;
+	Object visitFunctiondef(LuaParser::FunctiondefContext *ctx) override;
+	Object visitExp(LuaParser::ExpContext *ctx) override;
+
+private:
+    /**
+     * Infer the type of an expression and set it.
+     * @param ctx the ExpContext.
+     * @return the type.
+     */
+    Typespec *infer(LuaParser::ExpContext *ctx);
+
+    /**
+     * Infer the argument types of a function call, and
+     * widen the types of the function's parameters to them.
+     * @param ctx the FunctioncallContext.
+     * @return the type of the function's result.
+     */
+    Typespec *inferCall(LuaParser::FunctioncallContext *ctx);
+
+    /**
+     * Get the type of a variable where it is read.
+     * @param variableId the variable's symbol table entry.
+     * @return the type.
+     */
+    Typespec *read(SymtabEntry *variableId);
+
+    /**
+     * Set the type of a variable where it is assigned.
+     * @param variableId the variable's symbol table entry.
+     * @param type the type of the assigned value.
+     */
+    void assign(SymtabEntry *variableId, Typespec *type);
+
+    /**
+     * Widen the type of a symbol table entry to include another type.
+     * @param id the symbol table entry.
+     * @param type the other type.
+     */
+    void widen(SymtabEntry *id, Typespec *type);
+
+    /**
+     * Merge the types of two paths that join.
+     * @param types1 the types at the end of one path.
+     * @param types2 the types at the end of the other path.
+     * @return the types where the paths join.
+     */
+    static TypeMap merge(const TypeMap& types1, const TypeMap& types2);
+
+    /**
+     * Get the implied variable of a function, which holds its result.
+     * @param functionId the function's symbol table entry.
+     * @return the variable's symbol table entry.
+     */
+    static SymtabEntry *resultVariable(SymtabEntry *functionId);
+
+    /**
+     * Give the entries that never got a value the type nil, count
+     * the variables of a routine and its subroutines, and number
+     * their slots.
+     * @param routineId the routine's symbol table entry.
+     */
+    void settle(SymtabEntry *routineId);
+
+    /**
+     * Number the local variables array slots of a function's
+     * parameters and variables again, now that their types are known.
+     * @param routineId the function's symbol table entry.
+     */
+    void numberSlots(SymtabEntry *routineId);
+
+    /**
+     * Get the count of local variables array slots that a value takes.
+     * @param id the value's symbol table entry.
+     * @return the count.
+     */
+    static int slotWidth(SymtabEntry *id);
+};
+
+} // namespace frontend
+
+#endif /* TYPEINFERENCE_H_ */
@@ -0,0 +1,89 @@
+#!/bin/bash
+#
+# Compare the class file that the compiler writes directly with the
+# one that Jasmin assembles from the compiler's Jasmin output.
+#
+# USAGE: golden/classfile.sh [path/to/Lua] [--update]
+#
+# The two files never match byte for byte: the compiler writes version
+# 50.0 with StackMapTable frames and its own constant pool order, while
+# Jasmin writes version 45.3 without frames. So they are compared as the
+# listings that golden/normalize.py prints, with the constant pool
+# resolved and each method's limits and instructions in order.
+#
+# Compiles testProgram.lua with --emit=class and compares its listing
+# with golden/testProgram.class.txt, the listing of Jasmin's assembly of
+# the --emit=jasmin output. Also compares it with the listing of the
+# Jasmin text from the same run, which tells a class writer bug apart
+# from a fixture that is out of date. Prints the lines that differ, and
+# exits with 1 if any do.
+#
+# With --update, first regenerates the fixture: compiles testProgram.lua
+# with --emit=jasmin and assembles the .j file with Jasmin, which is
+# $JASMIN (by default jasmin.jar). Without java, lists the .j file itself.
+# Regenerate the fixture whenever the code that the compiler generates
+# for testProgram.lua changes.
+
+LUA=${1:-./Lua}
+UPDATE=${2:-}
+PYTHON=${PYTHON:-python3}
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+SOURCE="$HERE/../testProgram.lua"
+FIXTURE="$HERE/testProgram.class.txt"
+NORMALIZE="$HERE/normalize.py"
+JASMIN=${JASMIN:-jasmin.jar}
+
+if [ ! -x "$LUA" ]; then
+    echo "ERROR: compiler binary $LUA not found." >&2
+    exit 2
+fi
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+LUA=$(cd "$(dirname "$LUA")" && pwd)/$(basename "$LUA")
+
+# The class name is the source file name, so compile in place.
+cp "$SOURCE" "$WORK/testProgram.lua"
+
+for EMIT in jasmin class; do
+    (cd "$WORK" && "$LUA" --quiet --emit=$EMIT testProgram.lua > /dev/null) || {
+        echo "ERROR: testProgram.lua did not compile." >&2
+        exit 2
+    }
+done
+
+"$PYTHON" "$NORMALIZE" "$WORK/testProgram.class" > "$WORK/class.txt" || exit 2
+"$PYTHON" "$NORMALIZE" "$WORK/testProgram.j" > "$WORK/jasmin.txt" || exit 2
+
+if [ "$UPDATE" = "--update" ]; then
+    if command -v java > /dev/null && [ -f "$JASMIN" ]; then
+        java -jar "$JASMIN" -d "$WORK/jasmin" "$WORK/testProgram.j" > /dev/null || exit 2
+        "$PYTHON" "$NORMALIZE" "$WORK/jasmin/testProgram.class" > "$FIXTURE" || exit 2
+    else
+        echo "Jasmin $JASMIN or java not found: listing the .j file instead."
+        cp "$WORK/jasmin.txt" "$FIXTURE" || exit 2
+    fi
+    echo "Updated $FIXTURE."
+fi
+
+if [ ! -f "$FIXTURE" ]; then
+    echo "ERROR: $FIXTURE not found. Generate it with --update." >&2
+    exit 2
+fi
+
+STATUS=0
+
+if ! diff "$WORK/jasmin.txt" "$WORK/class.txt"; then
+    echo "testProgram.class differs from the compiler's own Jasmin output." >&2
+    STATUS=1
+fi
+
+if diff "$FIXTURE" "$WORK/class.txt"; then
+    echo "testProgram.class matches the Jasmin output."
+else
+    echo "testProgram.class differs from $FIXTURE." >&2
+    STATUS=1
+fi
+
+exit $STATUS
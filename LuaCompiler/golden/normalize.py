@@ -0,0 +1,543 @@
+#!/usr/bin/env python3
+"""
+Print a class file, or the Jasmin text it is assembled from, as a
+normalized listing that is the same for both.
+
+USAGE: golden/normalize.py file.class|file.j
+
+The listing has the class, its fields, and each method with its limits
+and its instructions, one per line, numbered by their position in the
+method. It leaves out what differs between two correct assemblies of the
+same code: the class file version, the order of the constant pool, the
+StackMapTable and debugging attributes, and the encoding that an
+assembler chooses for an instruction. So constant pool indices are
+resolved to the constants, branch targets are instruction numbers
+instead of byte offsets, and ldc_w, wide, goto_w and the short forms
+such as iload_1 are listed as ldc, goto and iload 1.
+"""
+
+import json
+import struct
+import sys
+
+ACCESS = [(0x0001, "public"), (0x0002, "private"), (0x0004, "protected"),
+          (0x0008, "static"), (0x0010, "final"), (0x0020, "synchronized"),
+          (0x0040, "volatile"), (0x0080, "transient"), (0x0100, "native"),
+          (0x0200, "interface"), (0x0400, "abstract")]
+
+ARRAY_TYPES = {4: "boolean", 5: "char", 6: "float", 7: "double",
+               8: "byte", 9: "short", 10: "int", 11: "long"}
+
+# Operand kinds: b = signed byte, s = signed short, l = local slot,
+# li = local slot and increment, c1/c2 = constant pool index,
+# j2/j4 = branch offset, t = array type, m = multianewarray, i = invokeinterface.
+OPCODES = {
+    0x00: ("nop", ""), 0x01: ("aconst_null", ""),
+    0x02: ("iconst_m1", ""), 0x03: ("iconst_0", ""), 0x04: ("iconst_1", ""),
+    0x05: ("iconst_2", ""), 0x06: ("iconst_3", ""), 0x07: ("iconst_4", ""),
+    0x08: ("iconst_5", ""), 0x09: ("lconst_0", ""), 0x0A: ("lconst_1", ""),
+    0x0B: ("fconst_0", ""), 0x0C: ("fconst_1", ""), 0x0D: ("fconst_2", ""),
+    0x0E: ("dconst_0", ""), 0x0F: ("dconst_1", ""),
+    0x10: ("bipush", "b"), 0x11: ("sipush", "s"),
+    0x12: ("ldc", "c1"), 0x13: ("ldc", "c2"), 0x14: ("ldc2_w", "c2"),
+    0x15: ("iload", "l"), 0x16: ("lload", "l"), 0x17: ("fload", "l"),
+    0x18: ("dload", "l"), 0x19: ("aload", "l"),
+    0x2E: ("iaload", ""), 0x2F: ("laload", ""), 0x30: ("faload", ""),
+    0x31: ("daload", ""), 0x32: ("aaload", ""), 0x33: ("baload", ""),
+    0x34: ("caload", ""), 0x35: ("saload", ""),
+    0x36: ("istore", "l"), 0x37: ("lstore", "l"), 0x38: ("fstore", "l"),
+    0x39: ("dstore", "l"), 0x3A: ("astore", "l"),
+    0x4F: ("iastore", ""), 0x50: ("lastore", ""), 0x51: ("fastore", ""),
+    0x52: ("dastore", ""), 0x53: ("aastore", ""), 0x54: ("bastore", ""),
+    0x55: ("castore", ""), 0x56: ("sastore", ""),
+    0x57: ("pop", ""), 0x58: ("pop2", ""), 0x59: ("dup", ""),
+    0x5A: ("dup_x1", ""), 0x5B: ("dup_x2", ""), 0x5C: ("dup2", ""),
+    0x5D: ("dup2_x1", ""), 0x5E: ("dup2_x2", ""), 0x5F: ("swap", ""),
+    0x60: ("iadd", ""), 0x61: ("ladd", ""), 0x62: ("fadd", ""), 0x63: ("dadd", ""),
+    0x64: ("isub", ""), 0x65: ("lsub", ""), 0x66: ("fsub", ""), 0x67: ("dsub", ""),
+    0x68: ("imul", ""), 0x69: ("lmul", ""), 0x6A: ("fmul", ""), 0x6B: ("dmul", ""),
+    0x6C: ("idiv", ""), 0x6D: ("ldiv", ""), 0x6E: ("fdiv", ""), 0x6F: ("ddiv", ""),
+    0x70: ("irem", ""), 0x71: ("lrem", ""), 0x72: ("frem", ""), 0x73: ("drem", ""),
+    0x74: ("ineg", ""), 0x75: ("lneg", ""), 0x76: ("fneg", ""), 0x77: ("dneg", ""),
+    0x78: ("ishl", ""), 0x79: ("lshl", ""), 0x7A: ("ishr", ""), 0x7B: ("lshr", ""),
+    0x7C: ("iushr", ""), 0x7D: ("lushr", ""), 0x7E: ("iand", ""), 0x7F: ("land", ""),
+    0x80: ("ior", ""), 0x81: ("lor", ""), 0x82: ("ixor", ""), 0x83: ("lxor", ""),
+    0x84: ("iinc", "li"),
+    0x85: ("i2l", ""), 0x86: ("i2f", ""), 0x87: ("i2d", ""), 0x88: ("l2i", ""),
+    0x89: ("l2f", ""), 0x8A: ("l2d", ""), 0x8B: ("f2i", ""), 0x8C: ("f2l", ""),
+    0x8D: ("f2d", ""), 0x8E: ("d2i", ""), 0x8F: ("d2l", ""), 0x90: ("d2f", ""),
+    0x91: ("i2b", ""), 0x92: ("i2c", ""), 0x93: ("i2s", ""),
+    0x94: ("lcmp", ""), 0x95: ("fcmpl", ""), 0x96: ("fcmpg", ""),
+    0x97: ("dcmpl", ""), 0x98: ("dcmpg", ""),
+    0x99: ("ifeq", "j2"), 0x9A: ("ifne", "j2"), 0x9B: ("iflt", "j2"),
+    0x9C: ("ifge", "j2"), 0x9D: ("ifgt", "j2"), 0x9E: ("ifle", "j2"),
+    0x9F: ("if_icmpeq", "j2"), 0xA0: ("if_icmpne", "j2"), 0xA1: ("if_icmplt", "j2"),
+    0xA2: ("if_icmpge", "j2"), 0xA3: ("if_icmpgt", "j2"), 0xA4: ("if_icmple", "j2"),
+    0xA5: ("if_acmpeq", "j2"), 0xA6: ("if_acmpne", "j2"),
+    0xA7: ("goto", "j2"), 0xAA: ("tableswitch", ""), 0xAB: ("lookupswitch", ""),
+    0xAC: ("ireturn", ""), 0xAD: ("lreturn", ""), 0xAE: ("freturn", ""),
+    0xAF: ("dreturn", ""), 0xB0: ("areturn", ""), 0xB1: ("return", ""),
+    0xB2: ("getstatic", "c2"), 0xB3: ("putstatic", "c2"),
+    0xB4: ("getfield", "c2"), 0xB5: ("putfield", "c2"),
+    0xB6: ("invokevirtual", "c2"), 0xB7: ("invokespecial", "c2"),
+    0xB8: ("invokestatic", "c2"), 0xB9: ("invokeinterface", "i"),
+    0xBB: ("new", "c2"), 0xBC: ("newarray", "t"), 0xBD: ("anewarray", "c2"),
+    0xBE: ("arraylength", ""), 0xBF: ("athrow", ""),
+    0xC0: ("checkcast", "c2"), 0xC1: ("instanceof", "c2"),
+    0xC2: ("monitorenter", ""), 0xC3: ("monitorexit", ""),
+    0xC5: ("multianewarray", "m"), 0xC6: ("ifnull", "j2"), 0xC7: ("ifnonnull", "j2"),
+    0xC8: ("goto", "j4"),
+}
+
+# The short forms, such as iload_1, of the local variable instructions.
+for base, name in [(0x1A, "iload"), (0x1E, "lload"), (0x22, "fload"),
+                   (0x26, "dload"), (0x2A, "aload"), (0x3B, "istore"),
+                   (0x3F, "lstore"), (0x43, "fstore"), (0x47, "dstore"),
+                   (0x4B, "astore")]:
+    for slot in range(4):
+        OPCODES[base + slot] = (name, "l%d" % slot)
+
+BRANCHES = {name for name, kind in OPCODES.values() if kind.startswith("j")}
+LOCALS = {name for name, kind in OPCODES.values() if kind.startswith("l")}
+
+
+def access(flags, ignore=0):
+    """
+    Name the access flags.
+    @param flags the flags.
+    @param ignore the flags to leave out.
+    @return the names, separated by blanks.
+    """
+    return " ".join(name for bit, name in ACCESS if flags & bit & ~ignore)
+
+
+def access_words(words):
+    """
+    Put the access flags of a Jasmin directive in the class file order.
+    @param words the flag names.
+    @return the names, separated by blanks.
+    """
+    return access(sum(bit for bit, name in ACCESS if name in words))
+
+
+def declaration(directive, flags, *rest):
+    """
+    Format a class, field or method declaration.
+    @param directive the directive.
+    @param flags the access flag names.
+    @param rest the names and descriptors.
+    @return the line.
+    """
+    return " ".join(part for part in (directive, flags) + rest if part)
+
+
+def quote_float(value):
+    """
+    Format a float constant as its single precision value.
+    @param value the value.
+    @return the text.
+    """
+    return repr(struct.unpack(">f", struct.pack(">f", value))[0])
+
+
+def decode_utf8(data):
+    """
+    Decode the modified UTF-8 of a class file.
+    @param data the bytes.
+    @return the string.
+    """
+    return data.replace(b"\xc0\x80", b"\x00").decode("utf-8", "surrogatepass")
+
+
+# ==========
+# Class file
+# ==========
+
+class ClassFile:
+    """A class file read into the normalized form."""
+
+    def __init__(self, data):
+        self.data = data
+        self.pos = 8  # past the magic number and the version
+        self.pool = [None]
+        self.lines = []
+
+        count = self.u2()
+        while len(self.pool) < count:
+            tag = self.u1()
+            if tag == 1:
+                self.pool.append(("utf8", decode_utf8(self.bytes(self.u2()))))
+            elif tag == 3:
+                self.pool.append(("int", self.s4()))
+            elif tag == 4:
+                self.pool.append(("float", struct.unpack(">f", self.bytes(4))[0]))
+            elif tag == 5:
+                self.pool.append(("long", struct.unpack(">q", self.bytes(8))[0]))
+                self.pool.append(None)
+            elif tag == 6:
+                self.pool.append(("double", struct.unpack(">d", self.bytes(8))[0]))
+                self.pool.append(None)
+            elif tag in (7, 8, 16, 19, 20):
+                self.pool.append((tag, self.u2()))
+            elif tag in (9, 10, 11, 12, 18):
+                self.pool.append((tag, self.u2(), self.u2()))
+            elif tag == 15:
+                self.pool.append((tag, self.u1(), self.u2()))
+            else:
+                raise ValueError("unknown constant pool tag %d" % tag)
+
+        flags = self.u2()
+        name = self.class_name(self.u2())
+        superclass = self.class_name(self.u2())
+        self.lines.append(declaration(".class", access(flags, 0x0020), name))
+        self.lines.append(".super %s" % superclass)
+        for _ in range(self.u2()):
+            self.lines.append(".implements %s" % self.class_name(self.u2()))
+
+        for _ in range(self.u2()):
+            flags, name, descriptor = self.u2(), self.utf8(self.u2()), self.utf8(self.u2())
+            self.lines.append(declaration(".field", access(flags), name, descriptor))
+            self.skip_attributes()
+
+        for _ in range(self.u2()):
+            self.read_method()
+
+    # Primitive reads.
+
+    def u1(self):
+        self.pos += 1
+        return self.data[self.pos - 1]
+
+    def u2(self):
+        self.pos += 2
+        return struct.unpack(">H", self.data[self.pos - 2:self.pos])[0]
+
+    def s4(self):
+        self.pos += 4
+        return struct.unpack(">i", self.data[self.pos - 4:self.pos])[0]
+
+    def bytes(self, count):
+        self.pos += count
+        return self.data[self.pos - count:self.pos]
+
+    def skip_attributes(self):
+        for _ in range(self.u2()):
+            self.u2()
+            self.pos += self.s4()
+
+    # Constant pool entries.
+
+    def utf8(self, index):
+        return self.pool[index][1]
+
+    def class_name(self, index):
+        return self.utf8(self.pool[index][1])
+
+    def member(self, index):
+        entry = self.pool[index]
+        owner = self.class_name(entry[1])
+        name_type = self.pool[entry[2]]
+        name, descriptor = self.utf8(name_type[1]), self.utf8(name_type[2])
+        if entry[0] == 9:
+            return "%s/%s %s" % (owner, name, descriptor)
+        return "%s/%s%s" % (owner, name, descriptor)
+
+    def constant(self, index):
+        entry = self.pool[index]
+        kind = entry[0]
+        if kind == "int" or kind == "long":
+            return str(entry[1])
+        if kind == "float":
+            return quote_float(entry[1])
+        if kind == "double":
+            return repr(entry[1]) + "d"
+        if kind == 8:
+            return json.dumps(self.utf8(entry[1]))
+        if kind == 7:
+            return self.class_name(index)
+        if kind in (9, 10, 11):
+            return self.member(index)
+        raise ValueError("unexpected constant pool entry %r" % (entry,))
+
+    # Methods.
+
+    def read_method(self):
+        flags, name, descriptor = self.u2(), self.utf8(self.u2()), self.utf8(self.u2())
+        self.lines.append("")
+        self.lines.append(declaration(".method", access(flags), name + descriptor))
+
+        for _ in range(self.u2()):
+            attribute, length = self.utf8(self.u2()), self.s4()
+            end = self.pos + length
+            if attribute == "Code":
+                max_stack, max_locals, code_length = self.u2(), self.u2(), self.s4()
+                code = self.bytes(code_length)
+                self.lines.append(".limit stack %d" % max_stack)
+                self.lines.append(".limit locals %d" % max_locals)
+                self.lines.extend(self.instructions(code))
+                for _ in range(self.u2()):
+                    start, stop, handler, kind = self.u2(), self.u2(), self.u2(), self.u2()
+                    self.lines.append(".catch %s %d %d %d" % (
+                        self.class_name(kind) if kind else "all", start, stop, handler))
+            self.pos = end
+
+        self.lines.append(".end method")
+
+    def instructions(self, code):
+        """Decode a method's bytecode, with branch targets as offsets first."""
+        decoded = []  # (offset, name, operands)
+        pos = 0
+
+        def s(count):
+            value = int.from_bytes(code[pos:pos + count], "big", signed=True)
+            return value
+
+        def u(count):
+            return int.from_bytes(code[pos:pos + count], "big")
+
+        while pos < len(code):
+            start = pos
+            op = code[pos]
+            pos += 1
+            wide = op == 0xC4
+            if wide:
+                op = code[pos]
+                pos += 1
+            name, kind = OPCODES[op]
+
+            if kind == "":
+                if name == "lookupswitch":
+                    pos += (4 - pos % 4) % 4
+                    default = s(4); pos += 4
+                    count = s(4); pos += 4
+                    pairs = []
+                    for _ in range(count):
+                        match = s(4); pos += 4
+                        target = s(4); pos += 4
+                        pairs.append((match, start + target))
+                    decoded.append((start, name, ("switch", sorted(pairs), start + default)))
+                elif name == "tableswitch":
+                    pos += (4 - pos % 4) % 4
+                    default = s(4); pos += 4
+                    low = s(4); pos += 4
+                    high = s(4); pos += 4
+                    pairs = []
+                    for match in range(low, high + 1):
+                        pairs.append((match, start + s(4)))
+                        pos += 4
+                    decoded.append((start, "lookupswitch", ("switch", pairs, start + default)))
+                else:
+                    decoded.append((start, name, ()))
+            elif kind == "b":
+                decoded.append((start, name, (str(s(1)),))); pos += 1
+            elif kind == "s":
+                decoded.append((start, name, (str(s(2)),))); pos += 2
+            elif kind in ("c1", "c2"):
+                size = 1 if kind == "c1" else 2
+                decoded.append((start, name, (self.constant(u(size)),))); pos += size
+            elif kind == "l" or kind == "li":
+                size = 2 if wide else 1
+                slot = u(size); pos += size
+                operands = [str(slot)]
+                if kind == "li":
+                    operands.append(str(s(size))); pos += size
+                decoded.append((start, name, tuple(operands)))
+            elif kind.startswith("l"):
+                decoded.append((start, name, (kind[1:],)))
+            elif kind in ("j2", "j4"):
+                size = int(kind[1])
+                decoded.append((start, name, ("branch", start + s(size)))); pos += size
+            elif kind == "t":
+                decoded.append((start, name, (ARRAY_TYPES[u(1)],))); pos += 1
+            elif kind == "m":
+                decoded.append((start, name, (self.class_name(u(2)), str(code[pos + 2])))); pos += 3
+            elif kind == "i":
+                decoded.append((start, name, (self.constant(u(2)),))); pos += 4
+
+        numbers = {offset: i for i, (offset, _, _) in enumerate(decoded)}
+        numbers[len(code)] = len(decoded)
+        return [format_instruction(i, name, operands, numbers)
+                for i, (_, name, operands) in enumerate(decoded)]
+
+
+def format_instruction(number, name, operands, targets):
+    """
+    Format one instruction of the listing.
+    @param number the instruction's position in its method.
+    @param name the mnemonic.
+    @param operands the operands, with branch targets still to be resolved.
+    @param targets the instruction number of each branch target.
+    @return the line.
+    """
+    if operands and operands[0] == "branch":
+        text = "%s %d" % (name, targets[operands[1]])
+    elif operands and operands[0] == "switch":
+        cases = " ".join("%d:%d" % (match, targets[target])
+                         for match, target in operands[1])
+        text = "%s %s default:%d" % (name, cases, targets[operands[2]])
+    else:
+        text = " ".join((name,) + tuple(operands))
+    return "%5d  %s" % (number, text)
+
+
+# ===========
+# Jasmin text
+# ===========
+
+def unquote(literal):
+    """
+    Decode a quoted Jasmin string constant.
+    @param literal the constant with its quotes.
+    @return the string.
+    """
+    escapes = {"n": "\n", "t": "\t", "r": "\r", "b": "\b", "f": "\f"}
+    value = []
+    i, last = 1, len(literal) - 1
+    while i < last:
+        ch = literal[i]
+        if ch != "\\" or i + 1 == last:
+            value.append(ch)
+        else:
+            i += 1
+            ch = literal[i]
+            if ch == "u":
+                value.append(chr(int(literal[i + 1:i + 5], 16)))
+                i += 4
+            else:
+                value.append(escapes.get(ch, ch))
+        i += 1
+    return "".join(value)
+
+
+def member_text(operand):
+    """
+    Normalize a Jasmin method operand, whose name may follow a dot.
+    @param operand the operand.
+    @return the operand with a slash before the name.
+    """
+    paren = operand.find("(")
+    separator = max(operand.rfind("/", 0, paren), operand.rfind(".", 0, paren))
+    return operand[:separator] + "/" + operand[separator + 1:]
+
+
+def ldc_text(operand):
+    """
+    Normalize the operand of a Jasmin ldc instruction.
+    @param operand the operand.
+    @return the constant as the class file reader formats it.
+    """
+    if operand.startswith('"'):
+        return json.dumps(unquote(operand))
+    try:
+        return str(int(operand))
+    except ValueError:
+        pass
+    try:
+        return quote_float(float(operand))
+    except ValueError:
+        return operand  # a class
+
+
+def jasmin(text):
+    """
+    Read Jasmin text into the normalized form.
+    @param text the text.
+    @return the listing lines.
+    """
+    lines = []
+    method = None  # the method's instructions, limits and labels
+
+    def finish():
+        lines.append(".limit stack %d" % method["stack"])
+        lines.append(".limit locals %d" % method["locals"])
+        for i, (name, operands) in enumerate(method["code"]):
+            lines.append(format_instruction(i, name, operands, method["labels"]))
+        lines.append(".end method")
+
+    rows = iter(text.splitlines())
+    for row in rows:
+        row = row.strip()
+        if not row or row.startswith(";"):
+            continue
+        words = row.split()
+
+        if words[0] == ".class":
+            lines.append(declaration(".class", access_words(words[1:-1]), words[-1]))
+        elif words[0] in (".super", ".implements"):
+            lines.append(row)
+        elif words[0] == ".field":
+            lines.append(declaration(".field", access_words(words[1:-2]),
+                                     words[-2], words[-1]))
+        elif words[0] == ".method":
+            lines.append("")
+            lines.append(declaration(".method", access_words(words[1:-1]), words[-1]))
+            method = {"code": [], "labels": {}, "stack": 0, "locals": 0}
+        elif words[0] == ".limit":
+            method[words[1]] = int(words[2])
+        elif words[0] == ".end":
+            finish()
+            method = None
+        elif words[0].startswith("."):
+            continue  # .var, .line, .source and .bytecode
+        elif row.endswith(":") and len(words) == 1:
+            method["labels"][row[:-1]] = len(method["code"])
+        else:
+            name, rest = words[0], row[len(words[0]):].strip()
+            if name in ("lookupswitch", "tableswitch"):
+                pairs, default = [], None
+                for case in rows:
+                    case = case.strip()
+                    if not case:
+                        continue
+                    match, target = [part.strip() for part in case.split(":")]
+                    if match == "default":
+                        default = target
+                        break
+                    pairs.append((int(match), target))
+                method["code"].append(("lookupswitch", ("switch", sorted(pairs), default)))
+                continue
+
+            if name == "ldc_w":
+                name = "ldc"
+            elif name == "goto_w":
+                name = "goto"
+            elif "_" in name and name.split("_")[0] in LOCALS and name[-1].isdigit():
+                name, rest = name.split("_")[0], name[-1]
+
+            if name in BRANCHES:
+                operands = ("branch", rest)
+            elif name in ("ldc", "ldc2_w"):
+                operands = (ldc_text(rest),)
+            elif name.startswith("invoke"):
+                parts = rest.split()
+                operands = (member_text(parts[0]),)
+            elif name in ("getstatic", "putstatic", "getfield", "putfield"):
+                operands = (" ".join(rest.split()),)
+            elif rest:
+                operands = tuple(rest.split())
+            else:
+                operands = ()
+            method["code"].append((name, operands))
+
+    return lines
+
+
+def main():
+    if len(sys.argv) != 2:
+        print("USAGE: normalize.py file.class|file.j", file=sys.stderr)
+        return 2
+
+    path = sys.argv[1]
+    if path.endswith(".j"):
+        with open(path, encoding="utf-8") as source:
+            lines = jasmin(source.read())
+    else:
+        with open(path, "rb") as source:
+            lines = ClassFile(source.read()).lines
+
+    print("\n".join(lines))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,146 @@
+/**
+ * <h1>Arena</h1>
+ *
+ * <p>A bump allocator that carves objects out of large blocks
+ * and releases them all at once when it is destroyed. Objects that
+ * need their destructors run are created with createOwned().</p>
+ */
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+namespace intermediate { namespace ast {
+
+using namespace std;
+
+class Arena
+{
+private:
+    static const size_t DEFAULT_BLOCK_SIZE = 64*1024;
+
+    size_t blockSize;      // size of each block in bytes
+    vector<char *> blocks; // the allocated blocks
+    char *next;            // next free byte of the current block
+    size_t remaining;      // free bytes left in the current block
+    size_t bytesUsed;      // total bytes handed out
+    size_t bytesReserved;  // total bytes of all blocks
+
+    // The owned objects and their destructors, in creation order.
+    vector<pair<void *, void (*)(void *)>> destructors;
+
+public:
+    /**
+     * Constructor.
+     * @param blockSize the size of each block in bytes.
+     */
+    Arena(size_t blockSize = DEFAULT_BLOCK_SIZE)
+        : blockSize(blockSize), next(nullptr), remaining(0), bytesUsed(0),
+          bytesReserved(0) {}
+
+    /**
+     * Destructor. Destroy the owned objects, newest first,
+     * and then release every block.
+     */
+    ~Arena()
+    {
+        for (auto it = destructors.rbegin(); it != destructors.rend(); it++)
+        {
+            it->second(it->first);
+        }
+        for (char *block : blocks) delete[] block;
+    }
+
+    Arena(const Arena&) = delete;
+    Arena& operator =(const Arena&) = delete;
+
+    /**
+     * Allocate raw memory.
+     * @param size the size in bytes.
+     * @param alignment the required alignment.
+     * @return the memory.
+     */
+    void *allocate(size_t size, size_t alignment = alignof(max_align_t))
+    {
+        size_t padding = (alignment - reinterpret_cast<size_t>(next)%alignment)
+                                                                 % alignment;
+
+        if (padding + size > remaining)
+        {
+            size_t size_ = size + alignment > blockSize ? size + alignment
+                                                        : blockSize;
+            next = new char[size_];
+            remaining = size_;
+            bytesReserved += size_;
+            blocks.push_back(next);
+            padding = (alignment - reinterpret_cast<size_t>(next)%alignment)
+                                                                 % alignment;
+        }
+
+        char *memory = next + padding;
+        next      += padding + size;
+        remaining -= padding + size;
+        bytesUsed += size;
+
+        return memory;
+    }
+
+    /**
+     * Construct an object in the arena. Its destructor is never
+     * called, so the type must be trivially destructible.
+     * @param args the constructor arguments.
+     * @return the object.
+     */
+    template<typename T, typename... Args>
+    T *create(Args&&... args)
+    {
+        static_assert(is_trivially_destructible<T>::value,
+                      "arena objects are never destroyed");
+
+        return new (allocate(sizeof(T), alignof(T)))
+                   T(forward<Args>(args)...);
+    }
+
+    /**
+     * Construct an object in the arena whose destructor
+     * runs when the arena is destroyed.
+     * @param args the constructor arguments.
+     * @return the object.
+     */
+    template<typename T, typename... Args>
+    T *createOwned(Args&&... args)
+    {
+        T *object = new (allocate(sizeof(T), alignof(T)))
+                         T(forward<Args>(args)...);
+
+        if (!is_trivially_destructible<T>::value)
+        {
+            destructors.emplace_back(object, [] (void *memory)
+            {
+                static_cast<T *>(memory)->~T();
+            });
+        }
+
+        return object;
+    }
+
+    /**
+     * Get the total bytes handed out.
+     * @return the count.
+     */
+    size_t getBytesUsed() const { return bytesUsed; }
+
+    /**
+     * Get the total bytes reserved in blocks.
+     * @return the count.
+     */
+    size_t getBytesReserved() const { return bytesReserved; }
+};
+
+}}  // namespace intermediate::ast
+
+#endif /* ARENA_H_ */
@@ -0,0 +1,71 @@
+/**
+ * <h1>ExpNode</h1>
+ *
+ * <p>A compact expression node lowered from the parse tree.
+ * Nodes live in an arena and carry typed kinds, interned text
+ * resolved symbol table entries and inferred types, so that code
+ * generation needs no child searches, getText() calls or the
+ * parse tree itself.</p>
+ */
+#ifndef EXPNODE_H_
+#define EXPNODE_H_
+
+#include <string>
+#include <cstdint>
+
+#include "intermediate/symtab/SymtabEntry.h"
+
+namespace intermediate { namespace ast {
+
+using namespace std;
+using namespace intermediate::symtab;
+
+enum class ExpKind : uint8_t
+{
+    NUMBER,    // integer constant, in value
+    STRING,    // string literal, in text
+    NIL,       // nil
+    BOOLEAN,   // false or true, in value
+    VARIABLE,  // variable, in entry
+    CALL,      // call of the function in entry, with the arguments
+               // listed from left
+    BINARY,    // left op right
+    DOUBLE,    // left + left, evaluating left once
+    OTHER,     // anything else, whose operands are listed from left
+};
+
+enum class ExpOperator : uint8_t
+{
+    NONE, ADD, SUB, MUL, DIV, EQ, NE, LT, LE, GT, GE,
+};
+
+struct ExpNode
+{
+    ExpKind kind;
+    ExpOperator op;
+    int value;
+    Typespec *type;   // the inferred type of the value
+    ExpNode *left;
+    ExpNode *right;
+    ExpNode *next;    // the next node of a list of arguments
+
+    union
+    {
+        const string *text;  // STRING
+        SymtabEntry *entry;  // VARIABLE, CALL
+    };
+
+    ExpNode(ExpKind kind)
+        : kind(kind), op(ExpOperator::NONE), value(0), type(nullptr),
+          left(nullptr), right(nullptr), next(nullptr), text(nullptr) {}
+
+    /**
+     * Determine whether this is a comparison.
+     * @return true if it is, else false.
+     */
+    bool isComparison() const { return op >= ExpOperator::EQ; }
+};
+
+}}  // namespace intermediate::ast
+
+#endif /* EXPNODE_H_ */
@@ -0,0 +1,103 @@
+/**
+ * <h1>SmallVector</h1>
+ *
+ * <p>A vector that keeps its first few elements inline and moves
+ * into arena memory when it outgrows them. It never frees memory,
+ * so it is trivially destructible and can itself live in an arena.
+ * The elements must be trivially copyable.</p>
+ */
+#ifndef SMALLVECTOR_H_
+#define SMALLVECTOR_H_
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+#include "Arena.h"
+
+namespace intermediate { namespace ast {
+
+using namespace std;
+
+template<typename T, size_t N>
+class SmallVector
+{
+    static_assert(is_trivially_copyable<T>::value,
+                  "small vector elements are copied bytewise");
+
+private:
+    Arena *arena;       // where the elements go after the inline ones
+    T *items;           // the inline elements or the arena elements
+    size_t count;       // count of elements
+    size_t capacity;    // count of elements that fit in items
+    T inlineItems[N];   // the first N elements
+
+public:
+    /**
+     * Constructor.
+     * @param arena the arena for more than N elements.
+     */
+    SmallVector(Arena *arena)
+        : arena(arena), items(inlineItems), count(0), capacity(N) {}
+
+    // The items may point into this object, so it cannot be copied.
+    SmallVector(const SmallVector&) = delete;
+    SmallVector& operator =(const SmallVector&) = delete;
+
+    /**
+     * Append an element.
+     * @param item the element.
+     */
+    void push_back(const T& item)
+    {
+        if (count == capacity) grow();
+        items[count++] = item;
+    }
+
+    /**
+     * Replace the elements with those of another vector.
+     * @param other the other vector.
+     */
+    template<size_t M>
+    void assign(const SmallVector<T, M>& other)
+    {
+        count = 0;
+        for (const T& item : other) push_back(item);
+    }
+
+    /**
+     * Remove all the elements. The capacity stays.
+     */
+    void clear() { count = 0; }
+
+    size_t size() const { return count; }
+    bool empty() const  { return count == 0; }
+
+    T& operator [](size_t index)             { return items[index]; }
+    const T& operator [](size_t index) const { return items[index]; }
+
+    T *begin() { return items; }
+    T *end()   { return items + count; }
+    const T *begin() const { return items; }
+    const T *end()   const { return items + count; }
+
+private:
+    /**
+     * Double the capacity. The old elements stay in the
+     * arena until the arena is destroyed.
+     */
+    void grow()
+    {
+        size_t newCapacity = 2*capacity;
+        T *newItems = static_cast<T *>(
+                        arena->allocate(newCapacity*sizeof(T), alignof(T)));
+
+        memcpy(static_cast<void *>(newItems), items, count*sizeof(T));
+        items = newItems;
+        capacity = newCapacity;
+    }
+};
+
+}}  // namespace intermediate::ast
+
+#endif /* SMALLVECTOR_H_ */
@@ -0,0 +1,92 @@
+/**
+ * <h1>StatNode</h1>
+ *
+ * <p>Compact statement, routine and program nodes lowered from the
+ * parse tree. With the expression nodes they are all that code
+ * generation reads, so the parse tree and its tokens can be freed
+ * before it starts. A block is a list of statements linked by
+ * their next nodes.</p>
+ */
+#ifndef STATNODE_H_
+#define STATNODE_H_
+
+#include <cstdint>
+
+#include "intermediate/symtab/SymtabEntry.h"
+#include "ExpNode.h"
+
+namespace intermediate { namespace ast {
+
+using namespace std;
+using namespace intermediate::symtab;
+
+enum class StatKind : uint8_t
+{
+    ASSIGN,  // entry = exp
+    CALL,    // the call in exp, discarding its result
+    PRINT,   // print of the arguments listed from exp
+    IF,      // the clauses
+    REPEAT,  // repeat block until exp
+    RETURN,  // return exp, or nil if there is none, from entry
+};
+
+struct StatNode;
+
+/**
+ * A test of an if statement and the block that it guards.
+ * The else block has no test.
+ */
+struct ClauseNode
+{
+    ExpNode *test;     // the test, or null for else
+    StatNode *block;   // the first statement of the block, or null
+    ClauseNode *next;  // the next clause of the statement
+
+    ClauseNode() : test(nullptr), block(nullptr), next(nullptr) {}
+};
+
+struct StatNode
+{
+    StatKind kind;
+    ExpNode *exp;    // the value, the call, the arguments or the test
+    StatNode *next;  // the next statement of the block
+
+    union
+    {
+        SymtabEntry *entry;   // ASSIGN: the variable, RETURN: the routine
+        StatNode *block;      // REPEAT: the first statement of the body
+        ClauseNode *clauses;  // IF
+    };
+
+    StatNode(StatKind kind)
+        : kind(kind), exp(nullptr), next(nullptr), entry(nullptr) {}
+};
+
+/**
+ * A function definition.
+ */
+struct RoutineNode
+{
+    SymtabEntry *entry;  // the function's symbol table entry
+    StatNode *block;     // the first statement of its body, or null
+    int line;            // the line of its definition
+    RoutineNode *next;   // the next function of the program
+
+    RoutineNode(SymtabEntry *entry, int line)
+        : entry(entry), block(nullptr), line(line), next(nullptr) {}
+};
+
+/**
+ * The program: its functions and its main chunk.
+ */
+struct ProgramNode
+{
+    RoutineNode *routines;  // the first function, or null
+    StatNode *block;        // the first statement of the main chunk
+
+    ProgramNode() : routines(nullptr), block(nullptr) {}
+};
+
+}}  // namespace intermediate::ast
+
+#endif /* STATNODE_H_ */
@@ -15,21 +15,12 @@ using namespace intermediate::symtab;
 using namespace intermediate::type;
 
 // Predefined types.
-intermediate::type::Typespec *Predefined::numberType;
-intermediate::type::Typespec *Predefined::boolType;
-intermediate::type::Typespec *Predefined::nilType;
-intermediate::type::Typespec *Predefined::stringType;
-intermediate::type::Typespec *Predefined::undefinedType;
-
-// Predefined identifiers.
-SymtabEntry *Predefined::numberId;
-SymtabEntry *Predefined::nilId;
-SymtabEntry *Predefined::stringId;
-SymtabEntry *Predefined::falseId;
-SymtabEntry *Predefined::trueId;
-SymtabEntry *Predefined::printId;
-
-
+intermediate::type::Typespec *Predefined::numberType = new Typespec();
+intermediate::type::Typespec *Predefined::boolType = new Typespec();
+intermediate::type::Typespec *Predefined::nilType = new Typespec();
+intermediate::type::Typespec *Predefined::stringType = new Typespec();
+intermediate::type::Typespec *Predefined::undefinedType = new Typespec();
+intermediate::type::Typespec *Predefined::dynamicType = new Typespec();
 
 void Predefined::initialize(SymtabStack *symtabStack)
 {
@@ -41,33 +32,26 @@ void Predefined::initialize(SymtabStack *symtabStack)
 void Predefined::initializeTypes(SymtabStack *symtabStack)
 {
     // Type integer.
-    numberId = symtabStack->enterLocal("number", TYPE);
-    numberType = new Typespec();
-    numberType->setIdentifier(numberId);
+    SymtabEntry *numberId = symtabStack->enterLocal("number", TYPE);
     numberId->setType(numberType);
 }
 
 void Predefined::initializeConstants(SymtabStack *symtabStack)
 {
     // Boolean enumeration constant false.
-    falseId = symtabStack->enterLocal("false", CONSTANT);
+    SymtabEntry *falseId = symtabStack->enterLocal("false", CONSTANT);
     falseId->setType(boolType);
     falseId->setValue(0);
 
     // Boolean enumeration constant true.
-    trueId = symtabStack->enterLocal("true", CONSTANT);
+    SymtabEntry *trueId = symtabStack->enterLocal("true", CONSTANT);
     trueId->setType(boolType);
     trueId->setValue(1);
-
-    // Add false and true to the boolean enumeration type.
-    vector<SymtabEntry *> *constants = new vector<SymtabEntry *>;
-    constants->push_back(falseId);
-    constants->push_back(trueId);
 }
 
 void Predefined::initializeStandardRoutines(SymtabStack *symtabStack)
 {
-    printId    = enterStandard(symtabStack, FUNCTION, "print", PRINT);
+    enterStandard(symtabStack, FUNCTION, "print", PRINT);
 }
 
 SymtabEntry *Predefined::enterStandard(SymtabStack *symtabStack,
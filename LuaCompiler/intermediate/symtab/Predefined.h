@@ -17,23 +17,18 @@ using namespace intermediate::type;
 class Predefined
 {
 public:
-    // Predefined types.
+    // Predefined types. They are created once, never change,
+    // and are shared by every compilation.
     static Typespec *numberType;
     static Typespec *nilType;
     static Typespec *stringType;
     static Typespec *undefinedType;
     static Typespec *boolType;
-
-    // Predefined identifiers.
-    static SymtabEntry *numberId;
-    static SymtabEntry *nilId;
-    static SymtabEntry *stringId;
-    static SymtabEntry *falseId;
-    static SymtabEntry *trueId;
-    static SymtabEntry *printId;
+    static Typespec *dynamicType;  // a value whose type varies at run time
 
     /**
      * Initialize a symbol table stack with predefined identifiers.
+     * Each compilation's stack gets its own identifier entries.
      * @param symTab the symbol table stack to initialize.
      */
     static void initialize(SymtabStack *symtabStack);
@@ -10,14 +10,21 @@
 #define SYMTABIMPL_H_
 
 #include <string>
-#include <map>
+#include <vector>
+#include <mutex>
+#include <algorithm>
+#include <cstdint>
 
+#include "intermediate/util/Interner.h"
+#include "intermediate/ast/Arena.h"
 #include "SymtabEntry.h"
 
 namespace intermediate { namespace symtab {
 
 using namespace std;
 using namespace intermediate;
+using intermediate::util::Interner;
+using intermediate::ast::Arena;
 
 #define UNNAMED_PREFIX string("_unnamed_")
 #define UNNAMED_PREFIX_LENGTH UNNAMED_PREFIX.length()
@@ -29,18 +36,39 @@ private:
     int slotNumber;                       // local variables array slot number
     int maxSlotNumber;                    // max slot number value
     SymtabEntry *ownerId;                 // symbol table entry of the owner
-    map<string, SymtabEntry *> contents;  // entries
+    int unnamedIndex;                     // index for unnamed type names
 
-    static int unnamedIndex;              // index for unnamed type names
+    /**
+     * A bucket of the hash table: an entry and the id of its name.
+     */
+    struct Bucket
+    {
+        int nameId;          // -1 if the bucket is empty
+        SymtabEntry *entry;
+    };
+
+    Interner *names;                      // the name ids and arena, shared
+    Arena *arena;                         // by the tables of a compilation
+    vector<Bucket> buckets;                   // open addressing, linear probing
+    int shift;                            // 32 - log2 of the bucket count
+    size_t count;                         // count of entries
+
+    vector<SymtabEntry *> sorted;         // the entries sorted by name
+    bool sortedValid;                     // false after a new entry
+    mutex sortLock;                       // guards sorting the entries
 
 public:
     /**
      * Constructor.
      * @param nesting_level the scope nesting level of this table
+     * @param names the interner of the names.
+     * @param arena the arena that owns the entries.
      */
-    Symtab(const int nestingLevel)
+    Symtab(const int nestingLevel, Interner *names, Arena *arena)
         : nestingLevel(nestingLevel), slotNumber(-1), maxSlotNumber(-1),
-          ownerId(nullptr) {}
+          ownerId(nullptr), unnamedIndex(0), names(names), arena(arena),
+          buckets(8, {-1, nullptr}), shift(32 - 3), count(0),
+          sortedValid(true) {}
 
     /**
      * Destructor.
@@ -61,19 +89,28 @@ public:
 
     /**
      * Compute and return the next local variables array slot number
+     * @param width the count of slots that the value takes.
      * @return the slot number.
      */
-    int nextSlotNumber()
+    int nextSlotNumber(int width = 1)
     {
-        maxSlotNumber = ++slotNumber;
-        return slotNumber;
+        int slot = slotNumber + 1;
+
+        slotNumber += width;
+        maxSlotNumber = slotNumber;
+        return slot;
     }
 
     /**
-     * Generate a name for an unnamed type.
+     * Number the local variables array slots again from slot 0.
+     */
+    void resetSlotNumbers() { slotNumber = maxSlotNumber = -1; }
+
+    /**
+     * Generate a name for an unnamed type in this table.
      * @return the name;
      */
-    static string generateUnnamedName()
+    string generateUnnamedName()
     {
         unnamedIndex++;
         return UNNAMED_PREFIX + to_string(unnamedIndex);
@@ -99,39 +136,73 @@ public:
      */
     SymtabEntry *enter(const string name, const Kind kind)
     {
-        SymtabEntry *entry = new SymtabEntry(name, kind, this);
-        contents[name] = entry;
+        int nameId = names->id(name);
+        SymtabEntry *entry = arena->create<SymtabEntry>(&names->name(nameId),
+                                                        kind, this, arena);
+
+        // Keep the table at most half full.
+        if (2*(count + 1) > buckets.size()) grow();
+
+        Bucket& bucket = buckets[probe(nameId)];
+        if (bucket.nameId < 0) count++;
+        bucket = {nameId, entry};
+        sortedValid = false;
 
         return entry;
     }
 
+    /**
+     * Get the count of entries.
+     * @return the count.
+     */
+    size_t size() const { return count; }
+
     /**
      * Look up an existing symbol table entry.
      * @param name the name of the entry.
      * @return the entry, or null if it does not exist.
      */
-    SymtabEntry *lookup(const string name)
+    SymtabEntry *lookup(const string& name) const
+    {
+        return lookup(names->find(name));
+    }
+
+    /**
+     * Look up an existing symbol table entry by the id of its name.
+     * @param nameId the id from the interner, or -1.
+     * @return the entry, or null if it does not exist.
+     */
+    SymtabEntry *lookup(int nameId) const
     {
-        return (contents.find(name) != contents.end()) ? contents[name]
-                                                       : nullptr;
+        return nameId >= 0 ? buckets[probe(nameId)].entry : nullptr;
     }
 
     /**
-     * Return a vector of entries sorted by name.
+     * Return a vector of entries sorted by name. The entries are
+     * sorted only when asked for after a change.
      * @return the sorted vector.
      */
     vector<SymtabEntry *> sortedEntries()
     {
-        vector<SymtabEntry *> list;
-        map<string, SymtabEntry *>::iterator it;
+        lock_guard<mutex> guard(sortLock);
 
-        // Iterate over the sorted entries and append them to the list.
-        for (it = contents.begin(); it != contents.end(); it++)
+        if (!sortedValid)
         {
-            list.push_back(it->second);
+            sorted.clear();
+            for (const Bucket& bucket : buckets)
+            {
+                if (bucket.nameId >= 0) sorted.push_back(bucket.entry);
+            }
+
+            sort(sorted.begin(), sorted.end(),
+                 [] (SymtabEntry *a, SymtabEntry *b)
+                 {
+                     return a->getName() < b->getName();
+                 });
+            sortedValid = true;
         }
 
-        return list;  // sorted list of entries
+        return sorted;  // sorted list of entries
     }
 
     /**
@@ -140,14 +211,50 @@ public:
      */
     void resetVariables(Kind kind)
     {
-        vector<SymtabEntry *> list;
-        map<string, SymtabEntry *>::iterator it;
-
         // Iterate over the entries and reset their kind.
-        for (it = contents.begin(); it != contents.end(); it++)
+        for (const Bucket& bucket : buckets)
+        {
+            SymtabEntry *entry = bucket.entry;
+            if ((entry != nullptr) && (entry->getKind() == VARIABLE))
+            {
+                entry->setKind(kind);
+            }
+        }
+    }
+
+private:
+    /**
+     * Find the bucket of a name id: its entry's bucket if the id is in
+     * the table, else the empty bucket where it would go.
+     * @param nameId the id of the name.
+     * @return the bucket index.
+     */
+    size_t probe(int nameId) const
+    {
+        // Fibonacci hashing spreads the ids over the high bits.
+        size_t mask = buckets.size() - 1;
+        size_t index = ((uint32_t) nameId * 2654435769u) >> shift;
+
+        while ((buckets[index].nameId >= 0) && (buckets[index].nameId != nameId))
+        {
+            index = (index + 1) & mask;
+        }
+
+        return index;
+    }
+
+    /**
+     * Double the bucket count and reinsert the entries.
+     */
+    void grow()
+    {
+        vector<Bucket> old(buckets.size()*2, {-1, nullptr});
+        old.swap(buckets);
+        shift--;
+
+        for (const Bucket& bucket : old)
         {
-            SymtabEntry *entry = it->second;
-            if (entry->getKind() == VARIABLE) entry->setKind(kind);
+            if (bucket.nameId >= 0) buckets[probe(bucket.nameId)] = bucket;
         }
     }
 };
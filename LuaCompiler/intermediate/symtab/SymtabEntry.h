@@ -5,6 +5,8 @@
 #include <vector>
 #include "antlr4-runtime.h"
 #include "../../Object.h"
+#include "intermediate/ast/Arena.h"
+#include "intermediate/ast/SmallVector.h"
 
 namespace intermediate { namespace type {
     class Typespec;
@@ -14,10 +16,15 @@ namespace intermediate { namespace symtab {
 
 using namespace std;
 using intermediate::type::Typespec;
+using intermediate::ast::Arena;
+using intermediate::ast::SmallVector;
 
 class Symtab;
 class SymtabEntry;
 
+typedef SmallVector<SymtabEntry *, 4> SymtabEntries;
+typedef SmallVector<int, 4> LineNumbers;
+
 enum class Kind
 {
     CONSTANT, TYPE, VARIABLE, VALUE_PARAMETER, FUNCTION, CHUNK, UNDEFINED
@@ -44,75 +51,63 @@ enum class Routine
 constexpr Routine DECLARED	    = Routine::DECLARED;
 constexpr Routine PRINT       	= Routine::PRINT;
 
+/**
+ * A symbol table entry. Entries live in the arena of their
+ * compilation and are never destroyed one by one, so an entry
+ * must stay trivially destructible.
+ */
 class SymtabEntry
 {
 private:
-
-    union EntryInfo
+    /**
+     * The information about a routine.
+     */
+    struct RoutineInfo
     {
-        struct
-        {
-        	Object *value;
-        } data;
-
-        struct
-        {
-        public:
-            Routine code;                        // routine code
-            Symtab *symtab;                      // routine's symbol table
-            vector<SymtabEntry *> *parameters;   // routine's formal parameters
-            vector<SymtabEntry *> *subroutines;  // symtab entries of subroutines
-            Object *executable;                  // routine's executable code
-        } routine;
+        Routine code;                           // routine code
+        Symtab *symtab;                         // routine's symbol table
+        SymtabEntries parameters;               // routine's formal parameters
+        SymtabEntries subroutines;              // symtab entries of subroutines
+        antlr4::ParserRuleContext *executable;  // routine's executable code
+
+        RoutineInfo(Arena *arena)
+            : code(DECLARED), symtab(nullptr), parameters(arena),
+              subroutines(arena), executable(nullptr) {}
     };
 
-    string name;              // identifier name
+    const string *name;       // identifier name, interned
     Kind kind;                // what kind of identifier
     Symtab   *symtab;         // parent symbol table
     Typespec *typespec;       // type specification
     int slotNumber;           // local variables array slot number
-    vector<int> lineNumbers;  // source line numbers
-    EntryInfo info;           // entry information
+    LineNumbers lineNumbers;  // source line numbers
+    int value;                // constant value
+    RoutineInfo *routine;     // routine information, or null
 
 public:
     /**
      * Constructor.
-     * @param name the name of the entry.
+     * @param name the interned name of the entry.
      * @param kind the kind of entry.
      * @param symTab the symbol table that contains this entry.
+     * @param arena the arena of the symbol tables.
      */
-    SymtabEntry(const string name, const Kind kind, Symtab *symtab)
+    SymtabEntry(const string *name, const Kind kind, Symtab *symtab,
+                Arena *arena)
         : name(name), kind(kind), symtab(symtab), typespec(nullptr),
-          slotNumber(0)
+          slotNumber(0), lineNumbers(arena), value(0), routine(nullptr)
     {
-        switch (kind)
+        if ((kind == Kind::FUNCTION) || (kind == Kind::CHUNK))
         {
-            case Kind::VARIABLE:
-
-                info.data.value = nullptr;
-                break;
-
-            case Kind::FUNCTION:
-            case Kind::CHUNK:
-                info.routine.symtab = nullptr;
-                info.routine.parameters  = new vector<SymtabEntry *>();
-                info.routine.subroutines = new vector<SymtabEntry *>();
-                break;
-
-            default: break;
+            routine = arena->create<RoutineInfo>(arena);
         }
     }
 
-    /**
-     * Destructor.
-     */
-    virtual ~SymtabEntry() {}
-
     /**
      * Get the name of the entry.
      * @return the name.
      */
-    string getName() const { return name; }
+    const string& getName() const { return *name; }
 
     /**
      * Get the kind of entry.
@@ -160,7 +155,7 @@ public:
      * Getter.
      * @return the list of source line numbers.
      */
-    vector<int> *getLineNumbers() { return &lineNumbers; }
+    LineNumbers *getLineNumbers() { return &lineNumbers; }
 
     /**
      * Append a source line number to the entry.
@@ -175,87 +170,107 @@ public:
      * Get the data value stored with this entry.
      * @return the data value.
      */
-    Object getValue() const { return *(info.data.value); }
+    Object getValue() const { return value; }
 
     /**
      * Set the data value into this entry.
      * @parm value the value to set.
      */
-    void setValue(Object value) { info.data.value = new Object(value); }
+    void setValue(int value) { this->value = value; }
 
     /**
      * Get the routine code.
      * @return the code.
      */
-    Routine getRoutineCode() const { return info.routine.code; }
+    Routine getRoutineCode() const
+    {
+        return routine != nullptr ? routine->code : DECLARED;
+    }
 
     /**
      * Set the routine code.
      * @parm code the code to set.
      */
-    void setRoutineCode(const Routine code) { info.routine.code = code;}
+    void setRoutineCode(const Routine code) { routine->code = code; }
 
     /**
      * Get the routine's symbol table.
-     * @return the symbol table.
+     * @return the symbol table, or null if this is not a routine.
      */
-    Symtab *getRoutineSymtab() const { return info.routine.symtab; }
+    Symtab *getRoutineSymtab() const
+    {
+        return routine != nullptr ? routine->symtab : nullptr;
+    }
 
     /**
      * Set the routine's symbol table.
      * @parm symtab the symbol table to set.
      */
-    void setRoutineSymtab(Symtab *symtab) { info.routine.symtab = symtab; }
+    void setRoutineSymtab(Symtab *symtab) { routine->symtab = symtab; }
+
+    /**
+     * Get the symbol table entries of the routine's formal parameters.
+     * @return the entries, or null if this is not a routine.
+     */
+    SymtabEntries *getRoutineParameters() const
+    {
+        return routine != nullptr ? &routine->parameters : nullptr;
+    }
 
     /**
-     * Get the vector of symbol table entries of the routine's formal parameters.
-     * @return the vector.
+     * Set the symbol table entries of parameters of the routine
+     * to a copy of another routine's.
+     * @parm parameters the entries to copy, or null for none.
      */
-    vector<SymtabEntry *> *getRoutineParameters() const
+    void setRoutineParameters(const SymtabEntries *parameters)
     {
-        return info.routine.parameters;
+        if (parameters != nullptr) routine->parameters.assign(*parameters);
+        else                       routine->parameters.clear();
     }
 
     /**
-     * Set the vector symbol table entries of parameters of the routine.
-     * @parm parameters the vector to set.
+     * Append to the symbol table entries of the routine's formal parameters.
+     * @parm parameterId the symbol table entry of the parameter to append.
      */
-    void setRoutineParameters(vector<SymtabEntry *> *parameters)
+    void appendParameter(SymtabEntry *parameterId)
     {
-        info.routine.parameters = parameters;
+        routine->parameters.push_back(parameterId);
     }
 
     /**
-     * Get the vector of symbol table entries of the nested subroutines.
-     * @return the vector.
+     * Get the symbol table entries of the nested subroutines.
+     * @return the entries, or null if this is not a routine.
      */
-    vector<SymtabEntry *> *getSubroutines() const
+    SymtabEntries *getSubroutines() const
     {
-        return info.routine.subroutines;
+        return routine != nullptr ? &routine->subroutines : nullptr;
     }
 
     /**
-     * Append to the arraylist of symbol table entries of the nested subroutines.
+     * Append to the symbol table entries of the nested subroutines.
      * @parm subroutineId the symbol table entry of the subroutine to append.
      */
     void appendSubroutine(SymtabEntry *subroutineId)
     {
-        info.routine.subroutines->push_back(subroutineId);
+        routine->subroutines.push_back(subroutineId);
     }
 
     /**
      * Get the routine's executable code.
      * @return the executable code.
      */
-    Object getExecutable() const { return *(info.routine.executable); }
+    antlr4::ParserRuleContext *getExecutable() const
+    {
+        return routine != nullptr ? routine->executable : nullptr;
+    }
 
     /**
      * Set the routine's executable code.
      * @parm executable the executable code to set.
      */
-    void setExecutable(Object executable)
+    void setExecutable(antlr4::ParserRuleContext *executable)
     {
-        info.routine.executable = new Object(executable);
+        routine->executable = executable;
     }
 };
 
@@ -25,6 +25,8 @@ private:
     int current_nesting_level;  // current scope nesting level
     SymtabEntry *program_id;    // entry for the main program id
 
+    Arena arena;      // owns every table and entry of the compilation
+    Interner names;   // the name ids of all the tables
     vector<Symtab *> stack;
 
 public:
@@ -33,16 +35,20 @@ public:
      */
     SymtabStack() : current_nesting_level(0), program_id(nullptr)
     {
-        stack.push_back(new Symtab(0));
+        stack.push_back(arena.createOwned<Symtab>(0, &names, &arena));
     }
 
     /**
-     * Destructor.
+     * Destructor. The arena releases every table and entry at once,
+     * including the tables of routines that were popped.
      */
-    virtual ~SymtabStack()
-    {
-        for (Symtab *symtab : stack) if (symtab != nullptr) delete symtab;
-    }
+    virtual ~SymtabStack() {}
+
+    /**
+     * Get the arena of the symbol tables.
+     * @return the arena.
+     */
+    const Arena& getArena() const { return arena; }
 
     /**
      * Getter.
@@ -74,14 +80,16 @@ public:
      */
     Symtab *push()
     {
-        Symtab *symtab = new Symtab(++current_nesting_level);
+        Symtab *symtab = arena.createOwned<Symtab>(++current_nesting_level,
+                                                   &names, &arena);
         stack.push_back(symtab);
 
         return symtab;
     }
 
     /**
-     * Push a symbol table onto the stack.
+     * Push a symbol table onto the stack. It must share this
+     * stack's interner, as the tables that push() creates do.
      * @param symtab the symbol table to push.
      * @return the pushed symbol table.
      */
@@ -122,7 +130,7 @@ public:
      * @param name the name of the entry.
      * @return the entry, or null if it does not exist.
      */
-    SymtabEntry *lookupLocal(const string name) const
+    SymtabEntry *lookupLocal(const string& name) const
     {
         return stack[current_nesting_level]->lookup(name);
     }
@@ -132,15 +140,20 @@ public:
      * @param name the name of the entry.
      * @return the entry, or null if it does not exist.
      */
-    SymtabEntry *lookup(const string name) const
+    SymtabEntry *lookup(const string& name) const
     {
         SymtabEntry *found_entry = nullptr;
 
+        // Hash the name once. A name that was never entered
+        // is in none of the tables.
+        int nameId = names.find(name);
+        if (nameId < 0) return nullptr;
+
         // Search the current and enclosing scopes.
         for (int i = current_nesting_level;
              (i >= 0) && (found_entry == nullptr); --i)
         {
-            found_entry = stack[i]->lookup(name);
+            found_entry = stack[i]->lookup(nameId);
         }
 
         return found_entry;
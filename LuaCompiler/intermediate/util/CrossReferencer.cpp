@@ -66,7 +66,7 @@ void CrossReferencer::printRoutine(SymtabEntry *routineId) const
     printSymtab(symtab, newRecordTypes);
 
     // Print any procedures and functions defined in the routine.
-    vector<SymtabEntry *> *routineIds = routineId->getSubroutines();
+    SymtabEntries *routineIds = routineId->getSubroutines();
 
     if (routineIds != nullptr)
     {
@@ -90,7 +90,7 @@ void CrossReferencer::printSymtab(Symtab *symtab,
     vector<SymtabEntry *> sorted = symtab->sortedEntries();
     for (SymtabEntry *entry : sorted)
     {
-        vector<int> *line_numbers = entry->getLineNumbers();
+        LineNumbers *line_numbers = entry->getLineNumbers();
 
         // For each entry, print the identifier name
         // followed by the line numbers.
@@ -0,0 +1,77 @@
+/**
+ * <h1>Interner</h1>
+ *
+ * <p>Keep a single copy of each distinct string so that equal
+ * names share storage and compare by address. Each distinct string
+ * also gets a small integer id, in the order of first interning,
+ * that stays the same for the life of the interner.</p>
+ */
+#ifndef INTERNER_H_
+#define INTERNER_H_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace intermediate { namespace util {
+
+using namespace std;
+
+class Interner
+{
+private:
+    unordered_map<string, int> ids;  // node-based, so addresses are stable
+    vector<const string *> strings;  // the strings, indexed by id
+
+public:
+    /**
+     * Intern a string.
+     * @param text the string.
+     * @return the address of the single shared copy.
+     */
+    const string *intern(const string& text)
+    {
+        return strings[id(text)];
+    }
+
+    /**
+     * Intern a string and get its id.
+     * @param text the string.
+     * @return the id.
+     */
+    int id(const string& text)
+    {
+        auto it = ids.emplace(text, (int) strings.size());
+        if (it.second) strings.push_back(&it.first->first);
+
+        return it.first->second;
+    }
+
+    /**
+     * Get the id of a string without interning it.
+     * @param text the string.
+     * @return the id, or -1 if the string was never interned.
+     */
+    int find(const string& text) const
+    {
+        auto it = ids.find(text);
+        return it != ids.end() ? it->second : -1;
+    }
+
+    /**
+     * Get the string of an id.
+     * @param id the id.
+     * @return the string.
+     */
+    const string& name(int id) const { return *strings[id]; }
+
+    /**
+     * Get the count of distinct strings.
+     * @return the count.
+     */
+    size_t size() const { return strings.size(); }
+};
+
+}}  // namespace intermediate::util
+
+#endif /* INTERNER_H_ */
@@ -0,0 +1,128 @@
+/**
+ * <h1>LatencyHistogram</h1>
+ *
+ * <p>Count latencies in power-of-two microsecond buckets, which
+ * is enough to estimate percentiles in a fixed amount of space.</p>
+ */
+#ifndef LATENCYHISTOGRAM_H_
+#define LATENCYHISTOGRAM_H_
+
+#include <cstdio>
+#include <string>
+
+namespace intermediate { namespace util {
+
+using namespace std;
+
+class LatencyHistogram
+{
+private:
+    static const int BUCKETS = 32;  // bucket i counts [2^(i-1), 2^i) usec
+
+    long   counts[BUCKETS];
+    long   count;       // count of latencies
+    double total;       // sum of the latencies in seconds
+    double minimum;     // smallest latency in seconds
+    double maximum;     // largest latency in seconds
+
+public:
+    /**
+     * Constructor.
+     */
+    LatencyHistogram() : count(0), total(0), minimum(0), maximum(0)
+    {
+        for (int i = 0; i < BUCKETS; i++) counts[i] = 0;
+    }
+
+    /**
+     * Count a latency.
+     * @param seconds the latency in seconds.
+     */
+    void add(double seconds)
+    {
+        long micros = (long) (seconds*1e6);
+        int bucket = 0;
+        while ((micros > 0) && (bucket < BUCKETS - 1))
+        {
+            micros >>= 1;
+            bucket++;
+        }
+
+        counts[bucket]++;
+        if ((count == 0) || (seconds < minimum)) minimum = seconds;
+        if ((count == 0) || (seconds > maximum)) maximum = seconds;
+        total += seconds;
+        count++;
+    }
+
+    /**
+     * Get the count of latencies.
+     * @return the count.
+     */
+    long getCount() const { return count; }
+
+    /**
+     * Estimate a percentile from the bucket bounds.
+     * @param fraction the percentile as a fraction, such as 0.99.
+     * @return the upper bound of its bucket in seconds, no more
+     * than the largest latency.
+     */
+    double percentile(double fraction) const
+    {
+        if (count == 0) return 0;
+
+        long rank = (long) (fraction*count + 0.5);
+        if (rank < 1) rank = 1;
+
+        long seen = 0;
+        for (int i = 0; i < BUCKETS; i++)
+        {
+            seen += counts[i];
+            if (seen >= rank)
+            {
+                double bound = (1L << i)/1e6;
+                return bound < maximum ? bound : maximum;
+            }
+        }
+
+        return maximum;
+    }
+
+    /**
+     * Format the summary and the nonempty buckets.
+     * @return the text, one line each.
+     */
+    string toString() const
+    {
+        string text;
+        char line[128];
+
+        snprintf(line, sizeof(line),
+                 "%ld requests, min %.3f ms, mean %.3f ms, max %.3f ms\n",
+                 count, minimum*1000, count > 0 ? total/count*1000 : 0.0,
+                 maximum*1000);
+        text += line;
+        snprintf(line, sizeof(line),
+                 "p50 %.3f ms, p90 %.3f ms, p99 %.3f ms\n",
+                 percentile(0.50)*1000, percentile(0.90)*1000,
+                 percentile(0.99)*1000);
+        text += line;
+
+        for (int i = 0; i < BUCKETS; i++)
+        {
+            if (counts[i] == 0) continue;
+
+            long low  = i == 0 ? 0 : 1L << (i - 1);
+            long high = 1L << i;
+            snprintf(line, sizeof(line), "%10ld - %10ld us  %8ld\n",
+                     low, high, counts[i]);
+            text += line;
+        }
+
+        return text;
+    }
+};
+
+}}  // namespace intermediate::util
+
+#endif /* LATENCYHISTOGRAM_H_ */
@@ -0,0 +1,173 @@
+/**
+ * <h1>Sha256</h1>
+ *
+ * <p>Compute the SHA-256 digest of a byte stream, such as the key
+ * of a content-addressed cache entry.</p>
+ */
+#ifndef SHA256_H_
+#define SHA256_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace intermediate { namespace util {
+
+using namespace std;
+
+class Sha256
+{
+private:
+    uint32_t state[8];      // the running hash value
+    uint8_t  block[64];     // the partial input block
+    size_t   blockSize;     // count of bytes in the partial block
+    uint64_t totalBytes;    // count of all bytes added
+
+public:
+    /**
+     * Constructor.
+     */
+    Sha256() : blockSize(0), totalBytes(0)
+    {
+        static const uint32_t INITIAL[8] = {
+            0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+            0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+        };
+        for (int i = 0; i < 8; i++) state[i] = INITIAL[i];
+    }
+
+    /**
+     * Add bytes to the digest.
+     * @param data the bytes.
+     * @param size the count of bytes.
+     */
+    void add(const void *data, size_t size)
+    {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        totalBytes += size;
+
+        while (size > 0)
+        {
+            size_t count = 64 - blockSize;
+            if (count > size) count = size;
+
+            for (size_t i = 0; i < count; i++) block[blockSize + i] = bytes[i];
+            blockSize += count;
+            bytes += count;
+            size -= count;
+
+            if (blockSize == 64)
+            {
+                transform();
+                blockSize = 0;
+            }
+        }
+    }
+
+    /**
+     * Add a string and a terminating zero byte, so that consecutive
+     * strings cannot run into each other.
+     * @param text the string.
+     */
+    void add(const string& text)
+    {
+        add(text.data(), text.size());
+        add("", 1);
+    }
+
+    /**
+     * Finish the digest. No more bytes can be added afterwards.
+     * @return the digest as 64 lowercase hexadecimal digits.
+     */
+    string hex()
+    {
+        uint64_t bits = totalBytes*8;
+
+        uint8_t pad = 0x80;
+        add(&pad, 1);
+        pad = 0;
+        while (blockSize != 56) add(&pad, 1);
+
+        uint8_t length[8];
+        for (int i = 0; i < 8; i++) length[i] = bits >> (56 - 8*i);
+        add(length, 8);
+
+        static const char DIGITS[] = "0123456789abcdef";
+        string text;
+        for (int i = 0; i < 8; i++)
+        {
+            for (int shift = 28; shift >= 0; shift -= 4)
+            {
+                text += DIGITS[(state[i] >> shift) & 0xf];
+            }
+        }
+
+        return text;
+    }
+
+private:
+    static uint32_t rotate(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+    /**
+     * Mix a full block into the hash value.
+     */
+    void transform()
+    {
+        static const uint32_t K[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+            0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+            0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+            0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+            0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+            0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+            0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+            0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+            0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+
+        uint32_t w[64];
+        for (int i = 0; i < 16; i++)
+        {
+            w[i] =   (uint32_t(block[4*i])     << 24)
+                   | (uint32_t(block[4*i + 1]) << 16)
+                   | (uint32_t(block[4*i + 2]) <<  8)
+                   |  uint32_t(block[4*i + 3]);
+        }
+        for (int i = 16; i < 64; i++)
+        {
+            uint32_t s0 = rotate(w[i-15], 7) ^ rotate(w[i-15], 18) ^ (w[i-15] >> 3);
+            uint32_t s1 = rotate(w[i-2], 17) ^ rotate(w[i-2], 19)  ^ (w[i-2] >> 10);
+            w[i] = w[i-16] + s0 + w[i-7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+        for (int i = 0; i < 64; i++)
+        {
+            uint32_t s1 = rotate(e, 6) ^ rotate(e, 11) ^ rotate(e, 25);
+            uint32_t ch = (e & f) ^ (~e & g);
+            uint32_t t1 = h + s1 + ch + K[i] + w[i];
+            uint32_t s0 = rotate(a, 2) ^ rotate(a, 13) ^ rotate(a, 22);
+            uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t t2 = s0 + maj;
+
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+};
+
+}}  // namespace intermediate::util
+
+#endif /* SHA256_H_ */
@@ -0,0 +1,101 @@
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdio>
+
+#include <unistd.h>
+
+#include "Tracer.h"
+
+namespace intermediate { namespace util {
+
+using namespace std;
+
+atomic<bool> Tracer::enabled(false);
+chrono::steady_clock::time_point Tracer::origin;
+mutex Tracer::eventsMutex;
+vector<Tracer::Event> Tracer::events;
+
+void Tracer::start()
+{
+    origin = chrono::steady_clock::now();
+    enabled = true;
+}
+
+int Tracer::threadNumber()
+{
+    static atomic<int> count(0);
+    static thread_local int number = ++count;
+    return number;
+}
+
+void Tracer::complete(const char *category, const string& name,
+                      const string& args, double start, double end)
+{
+    int thread = threadNumber();
+
+    lock_guard<mutex> lock(eventsMutex);
+    events.push_back({category, name, args, start, end - start, thread});
+}
+
+bool Tracer::write(const string& fileName)
+{
+    lock_guard<mutex> lock(eventsMutex);
+
+    ofstream outs(fileName);
+    if (outs.fail()) return false;
+
+    int pid = getpid();
+    char times[96];
+
+    outs << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    outs << "{\"ph\": \"M\", \"name\": \"process_name\", \"pid\": " << pid
+         << ", \"tid\": 1, \"args\": {\"name\": \"Lua compiler\"}}";
+
+    for (const Event& event : events)
+    {
+        snprintf(times, sizeof(times), "\"ts\": %.3f, \"dur\": %.3f",
+                 event.start, event.duration);
+
+        outs << ",\n{\"ph\": \"X\", \"cat\": " << jsonString(event.category)
+             << ", \"name\": " << jsonString(event.name)
+             << ", " << times
+             << ", \"pid\": " << pid << ", \"tid\": " << event.thread;
+        if (!event.args.empty()) outs << ", \"args\": {" << event.args << "}";
+        outs << "}";
+    }
+
+    outs << "\n]}\n";
+    outs.close();
+
+    return !outs.fail();
+}
+
+string Tracer::jsonString(const string& text)
+{
+    string json = "\"";
+
+    for (char ch : text)
+    {
+        switch (ch)
+        {
+            case '"':  json += "\\\""; break;
+            case '\\': json += "\\\\"; break;
+            case '\n': json += "\\n";  break;
+            case '\r': json += "\\r";  break;
+            case '\t': json += "\\t";  break;
+            default:
+                if ((unsigned char) ch < 0x20)
+                {
+                    char escape[8];
+                    snprintf(escape, sizeof(escape), "\\u%04x", ch);
+                    json += escape;
+                }
+                else json += ch;
+        }
+    }
+
+    return json + "\"";
+}
+
+}}  // namespace intermediate::util
@@ -0,0 +1,186 @@
+/**
+ * <h1>Tracer</h1>
+ *
+ * <p>Record spans of compiler work in the Chrome trace-event format,
+ * which Perfetto and chrome://tracing can display. Spans on the same
+ * thread nest by time. Recording is off unless it is started, and
+ * then a span costs one clock read at each end and a locked append.</p>
+ */
+#ifndef TRACER_H_
+#define TRACER_H_
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+namespace intermediate { namespace util {
+
+using namespace std;
+
+class Tracer
+{
+private:
+    /**
+     * A finished span.
+     */
+    struct Event
+    {
+        const char *category;   // the kind of work
+        string name;            // what was done
+        string args;            // JSON members describing it, or empty
+        double start;           // start time in microseconds
+        double duration;        // duration in microseconds
+        int thread;             // the recording thread's number
+    };
+
+    static atomic<bool> enabled;
+    static chrono::steady_clock::time_point origin;
+    static mutex eventsMutex;
+    static vector<Event> events;
+
+public:
+    /**
+     * Start recording.
+     */
+    static void start();
+
+    /**
+     * Check whether spans are being recorded.
+     * @return true if they are, else false.
+     */
+    static bool isEnabled() { return enabled.load(memory_order_relaxed); }
+
+    /**
+     * Convert a time to trace microseconds.
+     * @param time the time.
+     * @return the microseconds since recording started.
+     */
+    static double micros(chrono::steady_clock::time_point time)
+    {
+        return chrono::duration<double, micro>(time - origin).count();
+    }
+
+    /**
+     * Record a finished span of the calling thread.
+     * @param category the kind of work.
+     * @param name what was done.
+     * @param args JSON members that describe it, or empty.
+     * @param start the start time in microseconds.
+     * @param end the end time in microseconds.
+     */
+    static void complete(const char *category, const string& name,
+                         const string& args, double start, double end);
+
+    /**
+     * Write the recorded spans as a trace-event JSON file.
+     * @param fileName the file name.
+     * @return true if the file was written, else false.
+     */
+    static bool write(const string& fileName);
+
+    /**
+     * Quote a string for JSON.
+     * @param text the string.
+     * @return the quoted string.
+     */
+    static string jsonString(const string& text);
+
+private:
+    /**
+     * Get the number of the calling thread, which is 1 for the
+     * first thread that records a span.
+     * @return the number.
+     */
+    static int threadNumber();
+};
+
+/**
+ * A span that lasts as long as the object. It records nothing unless
+ * the tracer is on.
+ */
+class TraceSpan
+{
+private:
+    const char *category;   // the kind of work
+    string name;            // what is being done
+    string args;            // JSON members describing it
+    double start;           // start time in microseconds, or -1 if off
+
+public:
+    /**
+     * Constructor.
+     * @param category the kind of work.
+     * @param name what is being done.
+     */
+    TraceSpan(const char *category, const char *name)
+        : category(category), start(-1)
+    {
+        if (Tracer::isEnabled())
+        {
+            this->name = name;
+            start = Tracer::micros(chrono::steady_clock::now());
+        }
+    }
+
+    /**
+     * Constructor for a name with a detail, such as a routine name.
+     * The name is built only if the tracer is on.
+     * @param category the kind of work.
+     * @param name what is being done.
+     * @param detail what it is being done to.
+     */
+    TraceSpan(const char *category, const char *name, const string& detail)
+        : category(category), start(-1)
+    {
+        if (Tracer::isEnabled())
+        {
+            this->name = string(name) + " " + detail;
+            start = Tracer::micros(chrono::steady_clock::now());
+        }
+    }
+
+    /**
+     * Destructor. Record the span.
+     */
+    ~TraceSpan()
+    {
+        if (start >= 0)
+        {
+            Tracer::complete(category, name, args, start,
+                             Tracer::micros(chrono::steady_clock::now()));
+        }
+    }
+
+    /**
+     * Describe the span with a number.
+     * @param key the name of the value.
+     * @param value the value.
+     */
+    void arg(const string& key, long value)
+    {
+        if (start >= 0) append(key, to_string(value));
+    }
+
+    /**
+     * Describe the span with a string.
+     * @param key the name of the value.
+     * @param value the value.
+     */
+    void arg(const string& key, const string& value)
+    {
+        if (start >= 0) append(key, Tracer::jsonString(value));
+    }
+
+private:
+    void append(const string& key, const string& json)
+    {
+        if (!args.empty()) args += ", ";
+        args += Tracer::jsonString(key) + ": " + json;
+    }
+};
+
+}}  // namespace intermediate::util
+
+#endif /* TRACER_H_ */
@@ -0,0 +1,190 @@
+/**
+ * <h1>WorkStealingPool</h1>
+ *
+ * <p>A fixed set of worker threads, each with its own task deque.
+ * A worker takes its newest task first and, when its deque is empty,
+ * steals the oldest task of another worker.</p>
+ */
+#ifndef WORKSTEALINGPOOL_H_
+#define WORKSTEALINGPOOL_H_
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+
+namespace intermediate { namespace util {
+
+using namespace std;
+
+class WorkStealingPool
+{
+public:
+    /**
+     * A task receives the index of the worker that runs it.
+     */
+    typedef function<void(int worker)> Task;
+
+private:
+    struct Queue
+    {
+        mutex lock;
+        deque<Task> tasks;
+    };
+
+    vector<unique_ptr<Queue>> queues;  // one deque per worker
+    vector<thread> workers;            // the worker threads
+    mutex lock;                        // guards the counts below
+    condition_variable available;      // signaled when tasks arrive
+    condition_variable finished;       // signaled when all tasks are done
+    int queued;                        // tasks waiting in the deques
+    int pending;                       // tasks submitted but not done
+    int nextQueue;                     // round-robin submission index
+    bool stopping;                     // true when the pool shuts down
+
+public:
+    /**
+     * Constructor. Start the workers.
+     * @param count the number of workers.
+     */
+    WorkStealingPool(int count)
+        : queued(0), pending(0), nextQueue(0), stopping(false)
+    {
+        if (count < 1) count = 1;
+
+        for (int i = 0; i < count; i++) queues.emplace_back(new Queue());
+        for (int i = 0; i < count; i++)
+        {
+            workers.emplace_back(&WorkStealingPool::run, this, i);
+        }
+    }
+
+    /**
+     * Destructor. Finish the submitted tasks and stop the workers.
+     */
+    ~WorkStealingPool()
+    {
+        wait();
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        available.notify_all();
+        for (thread& worker : workers) worker.join();
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator =(const WorkStealingPool&) = delete;
+
+    /**
+     * Get the number of workers.
+     * @return the count.
+     */
+    int size() const { return workers.size(); }
+
+    /**
+     * Submit a task. Tasks are dealt to the workers' deques in turn.
+     * @param task the task.
+     */
+    void submit(Task task)
+    {
+        int index;
+        {
+            lock_guard<mutex> guard(lock);
+            index = nextQueue;
+            nextQueue = (nextQueue + 1)%queues.size();
+            pending++;
+        }
+        {
+            lock_guard<mutex> guard(queues[index]->lock);
+            queues[index]->tasks.push_back(move(task));
+        }
+        {
+            lock_guard<mutex> guard(lock);
+            queued++;
+        }
+        available.notify_one();
+    }
+
+    /**
+     * Wait until every submitted task is done.
+     */
+    void wait()
+    {
+        unique_lock<mutex> guard(lock);
+        finished.wait(guard, [this] { return pending == 0; });
+    }
+
+private:
+    /**
+     * The body of a worker thread.
+     * @param worker the worker's index.
+     */
+    void run(int worker)
+    {
+        Task task;
+
+        while (take(worker, task))
+        {
+            task(worker);
+            task = nullptr;
+
+            lock_guard<mutex> guard(lock);
+            if (--pending == 0) finished.notify_all();
+        }
+    }
+
+    /**
+     * Wait for a task, from the worker's own deque or stolen.
+     * @param worker the worker's index.
+     * @param task set to the task.
+     * @return false if the pool is stopping, else true.
+     */
+    bool take(int worker, Task& task)
+    {
+        for (;;)
+        {
+            {
+                unique_lock<mutex> guard(lock);
+                available.wait(guard, [this] { return stopping || (queued > 0); });
+                if (queued == 0) return false;  // stopping
+                queued--;
+            }
+
+            // A task is reserved for this worker. Look for it in
+            // its own deque first, then in the others.
+            int count = queues.size();
+            for (int i = 0; i < count; i++)
+            {
+                Queue& queue = *queues[(worker + i)%count];
+                lock_guard<mutex> guard(queue.lock);
+
+                if (!queue.tasks.empty())
+                {
+                    if (i == 0)
+                    {
+                        task = move(queue.tasks.back());
+                        queue.tasks.pop_back();
+                    }
+                    else
+                    {
+                        task = move(queue.tasks.front());
+                        queue.tasks.pop_front();
+                    }
+                    return true;
+                }
+            }
+
+            // Another worker took it first. Give the reservation back.
+            lock_guard<mutex> guard(lock);
+            queued++;
+        }
+    }
+};
+
+}}  // namespace intermediate::util
+
+#endif /* WORKSTEALINGPOOL_H_ */
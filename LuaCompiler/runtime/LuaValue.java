@@ -0,0 +1,356 @@
+import java.util.ArrayList;
+import java.util.HashMap;
+
+/**
+ * <h1>LuaValue</h1>
+ *
+ * <p>The run-time support for Lua values whose type varies. Compiled
+ * programs keep such a value in a long local variable or field, as a
+ * tagged long, so that ints, doubles, booleans and nil never allocate.</p>
+ *
+ * <p>A double is its own IEEE 754 bits, with every NaN made the one
+ * canonical NaN. Any other value is one of the NaNs that remain: its
+ * top 13 bits are set, the next 3 bits are its tag, and the low 32 bits
+ * are its payload. A string is kept in a side table, once for each
+ * distinct string, and its payload is its index there. So two values
+ * are equal if their bits are, apart from an int and a double that are
+ * the same number. The side table only grows, which suits the string
+ * constants of compiled programs.</p>
+ *
+ * <p>Compiled programs must have this class on their class path.</p>
+ */
+public final class LuaValue
+{
+    private static final long TAGGED   = 0xFFF8_0000_0000_0000L;
+    private static final long TAG_MASK = 0xFFFF_0000_0000_0000L;
+
+    private static final long TAG_NIL     = 0xFFF9_0000_0000_0000L;
+    private static final long TAG_BOOLEAN = 0xFFFA_0000_0000_0000L;
+    private static final long TAG_INT     = 0xFFFB_0000_0000_0000L;
+    private static final long TAG_STRING  = 0xFFFC_0000_0000_0000L;
+
+    private static final long PAYLOAD = 0x0000_0000_FFFF_FFFFL;
+    private static final long NAN     = Double.doubleToLongBits(Double.NaN);
+
+    public static final long NIL   = TAG_NIL;
+    public static final long FALSE = TAG_BOOLEAN;
+    public static final long TRUE  = TAG_BOOLEAN | 1;
+
+    private static final ArrayList<String> strings = new ArrayList<>();
+    private static final HashMap<String, Integer> indexes = new HashMap<>();
+
+    private LuaValue() {}
+
+    // ============
+    // Construction
+    // ============
+
+    /**
+     * Get the value of an int.
+     * @param value the int.
+     * @return the value.
+     */
+    public static long ofInt(int value)
+    {
+        return TAG_INT | (value & PAYLOAD);
+    }
+
+    /**
+     * Get the value of a double.
+     * @param value the double.
+     * @return the value.
+     */
+    public static long ofDouble(double value)
+    {
+        // doubleToLongBits() makes every NaN the canonical NaN.
+        return Double.doubleToLongBits(value);
+    }
+
+    /**
+     * Get the value of a boolean.
+     * @param value the boolean.
+     * @return the value.
+     */
+    public static long ofBoolean(boolean value)
+    {
+        return value ? TRUE : FALSE;
+    }
+
+    /**
+     * Get the value of a string.
+     * @param value the string, or null for nil.
+     * @return the value.
+     */
+    public static synchronized long ofString(String value)
+    {
+        if (value == null) return NIL;
+
+        Integer index = indexes.get(value);
+        if (index == null)
+        {
+            index = strings.size();
+            strings.add(value);
+            indexes.put(value, index);
+        }
+
+        return TAG_STRING | index;
+    }
+
+    // =====
+    // Tests
+    // =====
+
+    public static boolean isNil(long value)     { return value == NIL; }
+    public static boolean isBoolean(long value) { return (value & TAG_MASK) == TAG_BOOLEAN; }
+    public static boolean isInt(long value)     { return (value & TAG_MASK) == TAG_INT; }
+    public static boolean isDouble(long value)  { return (value & TAGGED) != TAGGED; }
+    public static boolean isString(long value)  { return (value & TAG_MASK) == TAG_STRING; }
+
+    public static boolean isNumber(long value)
+    {
+        return isInt(value) || isDouble(value);
+    }
+
+    /**
+     * Test a value as a condition: only nil and false are false.
+     * @param value the value.
+     * @return true if it is neither nil nor false.
+     */
+    public static boolean truth(long value)
+    {
+        return (value != NIL) && (value != FALSE);
+    }
+
+    // ===========
+    // Conversions
+    // ===========
+
+    /**
+     * Convert a value to an int, as Lua does for arithmetic.
+     * @param value the value.
+     * @return the int.
+     */
+    public static int toInt(long value)
+    {
+        if (isInt(value)) return (int) value;
+
+        if (isDouble(value))
+        {
+            double number = Double.longBitsToDouble(value);
+            if (number == (int) number) return (int) number;
+
+            throw error("number has no integer representation");
+        }
+
+        if (isString(value)) return parseInt(string(value));
+
+        throw error("attempt to perform arithmetic on a "
+                    + typeName(value) + " value");
+    }
+
+    /**
+     * Convert a string to an int, as Lua does for arithmetic.
+     * Surrounding white space is ignored.
+     * @param value the string, or null for nil.
+     * @return the int.
+     */
+    public static int parseInt(String value)
+    {
+        if (value == null)
+        {
+            throw error("attempt to perform arithmetic on a nil value");
+        }
+
+        try
+        {
+            return Integer.parseInt(value.trim());
+        }
+        catch (NumberFormatException ex) {}
+
+        throw error("attempt to perform arithmetic on a string value");
+    }
+
+    /**
+     * Convert a value to a double, as Lua does for arithmetic.
+     * @param value the value.
+     * @return the double.
+     */
+    public static double toDouble(long value)
+    {
+        if (isDouble(value)) return Double.longBitsToDouble(value);
+        if (isInt(value))    return (int) value;
+
+        if (isString(value))
+        {
+            try
+            {
+                return Double.parseDouble(string(value).trim());
+            }
+            catch (NumberFormatException ex) {}
+        }
+
+        throw error("attempt to perform arithmetic on a "
+                    + typeName(value) + " value");
+    }
+
+    /**
+     * Convert a value that is known to be a boolean.
+     * @param value the value.
+     * @return the boolean.
+     */
+    public static boolean toBoolean(long value)
+    {
+        if (isBoolean(value)) return value == TRUE;
+
+        throw error("boolean expected, got " + typeName(value));
+    }
+
+    /**
+     * Convert a value to a string, as Lua prints it.
+     * @param value the value.
+     * @return the string.
+     */
+    public static String toString(long value)
+    {
+        if (isString(value))  return string(value);
+        if (isInt(value))     return Integer.toString((int) value);
+        if (isBoolean(value)) return value == TRUE ? "true" : "false";
+        if (isNil(value))     return "nil";
+
+        // A double prints as a float even if it is whole.
+        double number = Double.longBitsToDouble(value);
+        if (   (number == Math.rint(number)) && !Double.isInfinite(number)
+            && (Math.abs(number) < 1e15))
+        {
+            return (long) number + ".0";
+        }
+        return Double.toString(number);
+    }
+
+    /**
+     * Get the name of the type of a value, as Lua's type() does.
+     * @param value the value.
+     * @return the name.
+     */
+    public static String typeName(long value)
+    {
+        if (isNumber(value))  return "number";
+        if (isString(value))  return "string";
+        if (isBoolean(value)) return "boolean";
+        return "nil";
+    }
+
+    // ===========
+    // Comparisons
+    // ===========
+
+    /**
+     * Compare two values for equality, as Lua's == does.
+     * @param value1 the first value.
+     * @param value2 the second value.
+     * @return true if they are equal.
+     */
+    public static boolean equal(long value1, long value2)
+    {
+        // NaN is not equal to itself.
+        if (value1 == value2) return value1 != NAN;
+
+        // An int and a double can be the same number.
+        return    isNumber(value1) && isNumber(value2)
+               && (isDouble(value1) || isDouble(value2))
+               && (toDouble(value1) == toDouble(value2));
+    }
+
+    /**
+     * Order two values, as Lua's < does: numbers by value and
+     * strings by their characters. No number is less than NaN,
+     * and NaN is less than no number.
+     * @param value1 the first value.
+     * @param value2 the second value.
+     * @return true if the first value is less than the second.
+     */
+    public static boolean lessThan(long value1, long value2)
+    {
+        if (isInt(value1) && isInt(value2))
+        {
+            return (int) value1 < (int) value2;
+        }
+        if (isNumber(value1) && isNumber(value2))
+        {
+            return toDouble(value1) < toDouble(value2);
+        }
+        if (isString(value1) && isString(value2))
+        {
+            return string(value1).compareTo(string(value2)) < 0;
+        }
+
+        throw compareError(value1, value2);
+    }
+
+    /**
+     * Order two values, as Lua's <= does. Unlike with integers, this
+     * is not the negation of lessThan: NaN is neither, and -0.0 <= 0.0.
+     * @param value1 the first value.
+     * @param value2 the second value.
+     * @return true if the first value is less than or equal to the second.
+     */
+    public static boolean lessEqual(long value1, long value2)
+    {
+        if (isInt(value1) && isInt(value2))
+        {
+            return (int) value1 <= (int) value2;
+        }
+        if (isNumber(value1) && isNumber(value2))
+        {
+            return toDouble(value1) <= toDouble(value2);
+        }
+        if (isString(value1) && isString(value2))
+        {
+            return string(value1).compareTo(string(value2)) <= 0;
+        }
+
+        throw compareError(value1, value2);
+    }
+
+    /**
+     * Order two values, as Lua's > does: a > b is b < a.
+     * @param value1 the first value.
+     * @param value2 the second value.
+     * @return true if the first value is greater than the second.
+     */
+    public static boolean greaterThan(long value1, long value2)
+    {
+        return lessThan(value2, value1);
+    }
+
+    /**
+     * Order two values, as Lua's >= does: a >= b is b <= a.
+     * @param value1 the first value.
+     * @param value2 the second value.
+     * @return true if the first value is greater than or equal to the second.
+     */
+    public static boolean greaterEqual(long value1, long value2)
+    {
+        return lessEqual(value2, value1);
+    }
+
+    // =========
+    // Utilities
+    // =========
+
+    private static synchronized String string(long value)
+    {
+        return strings.get((int) (value & PAYLOAD));
+    }
+
+    private static RuntimeException compareError(long value1, long value2)
+    {
+        return error("attempt to compare " + typeName(value1)
+                     + " with " + typeName(value2));
+    }
+
+    private static RuntimeException error(String message)
+    {
+        return new RuntimeException(message);
+    }
+}